@@ -600,6 +600,9 @@ static int info_verifyroms(core_options *options, const char *gamename)
 	int notfound = 0;
 	int drvindex;
 
+	/* sets verified on an earlier run need not be hashed again */
+	mame_hash_cache_load(options);
+
 	/* iterate over drivers */
 	for (drvindex = 0; drivers[drvindex]; drvindex++)
 		if (mame_strwildcmp(gamename, drivers[drvindex]->name) == 0)
@@ -650,7 +653,8 @@ static int info_verifyroms(core_options *options, const char *gamename)
 			}
 		}
 
-	/* clear out any cached files */
+	/* save what we verified and clear out any cached files */
+	mame_hash_cache_save();
 	zip_file_cache_clear();
 
 	/* if we didn't get anything at all, display a generic end message */
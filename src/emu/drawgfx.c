@@ -14,6 +14,14 @@
 #include "driver.h"
 #include "profiler.h"
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DRAWGFX_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DRAWGFX_SSE2
+#endif
+
 
 /***************************************************************************
     CONSTANTS
@@ -31,6 +39,18 @@
 #define SHIFT0 24
 #endif
 
+/* pixels handled per pass by the span kernels */
+#define SPAN_PIXELS 16
+
+/* tools that check the span kernels against the scalar loops build this file
+   with DRAWGFX_SPAN_SWITCH, which lets them turn the kernels off at run time */
+#ifdef DRAWGFX_SPAN_SWITCH
+int drawgfx_use_spans = 1;
+#define SPANS_ENABLED drawgfx_use_spans
+#else
+#define SPANS_ENABLED 1
+#endif
+
 
 
 /***************************************************************************
@@ -89,6 +109,283 @@ INLINE int readbit(const UINT8 *src, unsigned int bitnum)
 
 
 
+/***************************************************************************
+    SPAN KERNELS
+***************************************************************************/
+
+/*
+    These handle SPAN_PIXELS pixels of an 8-bit source row at a time for
+    the transparent pen blitters. Opaque pixels are found with a compare,
+    merged with the priority bitmap, and written with a masked select, so
+    there is no per-pixel branch. Each produces exactly the same pixels as
+    the per-pixel SETPIXELCOLOR loop it replaces.
+*/
+
+/* priority merge state for one blit */
+typedef struct _span_priority span_priority;
+struct _span_priority
+{
+	UINT8		drawable[32];		/* 0xff for each priority we may draw over */
+	UINT32		pmask;				/* priority mask */
+	UINT8		after;				/* bits or'ed into the priority of updated pixels */
+	UINT8		drawnonly;			/* only update the priority of pixels we draw */
+};
+
+
+/*-------------------------------------------------
+    span_movemask - collapse a vector of 0x00/0xff
+    bytes into a bitmask, lowest lane in bit 0
+-------------------------------------------------*/
+
+#if defined(DRAWGFX_NEON)
+INLINE UINT32 span_movemask(uint8x16_t mask)
+{
+	static const UINT8 lanebits[16] = { 1,2,4,8,16,32,64,128, 1,2,4,8,16,32,64,128 };
+	uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(mask, vld1q_u8(lanebits)))));
+	return (UINT32)vgetq_lane_u64(sums, 0) | ((UINT32)vgetq_lane_u64(sums, 1) << 8);
+}
+#endif
+
+
+/*-------------------------------------------------
+    span_transpen_mask - load SPAN_PIXELS source
+    pixels in destination order and flag the ones
+    that are not transpen; returns a bitmask of
+    the opaque pixels
+-------------------------------------------------*/
+
+INLINE UINT32 span_transpen_mask(const UINT8 *src, int flipx, int transpen, UINT8 *cols, UINT8 *mask)
+{
+#if defined(DRAWGFX_NEON)
+	uint8x16_t pix = vld1q_u8(src);
+	uint8x16_t opaque;
+
+	/* flipped rows are read backwards */
+	if (flipx)
+	{
+		pix = vrev64q_u8(pix);
+		pix = vcombine_u8(vget_high_u8(pix), vget_low_u8(pix));
+	}
+	opaque = vmvnq_u8(vceqq_u8(pix, vdupq_n_u8(transpen)));
+	vst1q_u8(cols, pix);
+	vst1q_u8(mask, opaque);
+	return span_movemask(opaque);
+#elif defined(DRAWGFX_SSE2)
+	__m128i pix = _mm_loadu_si128((const __m128i *)src);
+	__m128i opaque;
+
+	/* flipped rows are read backwards */
+	if (flipx)
+	{
+		pix = _mm_shufflelo_epi16(pix, 0x1b);
+		pix = _mm_shufflehi_epi16(pix, 0x1b);
+		pix = _mm_shuffle_epi32(pix, 0x4e);
+		pix = _mm_or_si128(_mm_slli_epi16(pix, 8), _mm_srli_epi16(pix, 8));
+	}
+	opaque = _mm_xor_si128(_mm_cmpeq_epi8(pix, _mm_set1_epi8(transpen)), _mm_set1_epi8(0xff));
+	_mm_storeu_si128((__m128i *)cols, pix);
+	_mm_storeu_si128((__m128i *)mask, opaque);
+	return _mm_movemask_epi8(opaque);
+#else
+	UINT32 bits = 0;
+	int i;
+
+	for (i = 0; i < SPAN_PIXELS; i++)
+	{
+		UINT8 col = flipx ? src[SPAN_PIXELS - 1 - i] : src[i];
+		cols[i] = col;
+		mask[i] = (col != transpen) ? 0xff : 0x00;
+		bits |= (col != transpen) << i;
+	}
+	return bits;
+#endif
+}
+
+
+/*-------------------------------------------------
+    span_priority_setup - prepare the priority
+    merge for a given pmask; drawnonly selects
+    the 32bpp rule where only drawn pixels update
+    the priority bitmap
+-------------------------------------------------*/
+
+INLINE void span_priority_setup(span_priority *info, UINT32 pmask, int after, int drawnonly)
+{
+	int i;
+
+	for (i = 0; i < 32; i++)
+		info->drawable[i] = ((1 << i) & pmask) ? 0x00 : 0xff;
+	info->pmask = pmask;
+	info->after = after;
+	info->drawnonly = drawnonly;
+}
+
+
+/*-------------------------------------------------
+    span_priority_merge - reduce the opaque mask
+    to the pixels that win against the priority
+    bitmap and update the bitmap; returns a
+    bitmask of the drawn pixels and fills in the
+    ones that land on shadowed pixels
+-------------------------------------------------*/
+
+INLINE UINT32 span_priority_merge(UINT8 *pri, UINT8 *mask, const span_priority *info, UINT32 *shadowbits)
+{
+#if defined(DRAWGFX_NEON)
+	uint8x16_t p = vld1q_u8(pri);
+	uint8x16_t opaque = vld1q_u8(mask);
+	uint8x16_t index = vandq_u8(p, vdupq_n_u8(0x1f));
+	uint8x8x4_t table;
+	uint8x16_t draw, update;
+
+	/* look up whether each priority lets us draw */
+	table.val[0] = vld1_u8(&info->drawable[0]);
+	table.val[1] = vld1_u8(&info->drawable[8]);
+	table.val[2] = vld1_u8(&info->drawable[16]);
+	table.val[3] = vld1_u8(&info->drawable[24]);
+	draw = vandq_u8(opaque, vcombine_u8(vtbl4_u8(table, vget_low_u8(index)), vtbl4_u8(table, vget_high_u8(index))));
+
+	/* update the priority bitmap */
+	update = info->drawnonly ? draw : opaque;
+	*shadowbits = info->drawnonly ? 0 : span_movemask(vandq_u8(draw, vtstq_u8(p, vdupq_n_u8(0x80))));
+	p = vbslq_u8(update, vorrq_u8(vandq_u8(p, vdupq_n_u8(0x7f)), vdupq_n_u8(info->after)), p);
+	vst1q_u8(pri, p);
+
+	vst1q_u8(mask, draw);
+	return span_movemask(draw);
+#elif defined(DRAWGFX_SSE2)
+	__m128i p = _mm_loadu_si128((const __m128i *)pri);
+	__m128i opaque = _mm_loadu_si128((const __m128i *)mask);
+	__m128i index = _mm_and_si128(p, _mm_set1_epi8(0x1f));
+	__m128i quarter = _mm_and_si128(_mm_srli_epi16(index, 3), _mm_set1_epi8(0x03));
+	__m128i bitnum = _mm_and_si128(index, _mm_set1_epi8(0x07));
+	__m128i pbyte = _mm_setzero_si128();
+	__m128i pbit = _mm_setzero_si128();
+	__m128i draw, update;
+	int i;
+
+	/* pick the pmask byte and the bit within it for each priority */
+	for (i = 0; i < 4; i++)
+		pbyte = _mm_or_si128(pbyte, _mm_and_si128(_mm_cmpeq_epi8(quarter, _mm_set1_epi8(i)), _mm_set1_epi8((INT8)(info->pmask >> (8 * i)))));
+	for (i = 0; i < 8; i++)
+		pbit = _mm_or_si128(pbit, _mm_and_si128(_mm_cmpeq_epi8(bitnum, _mm_set1_epi8(i)), _mm_set1_epi8((INT8)(1 << i))));
+	draw = _mm_and_si128(opaque, _mm_cmpeq_epi8(_mm_and_si128(pbyte, pbit), _mm_setzero_si128()));
+
+	/* update the priority bitmap */
+	update = info->drawnonly ? draw : opaque;
+	*shadowbits = info->drawnonly ? 0 : (_mm_movemask_epi8(draw) & _mm_movemask_epi8(p));
+	p = _mm_or_si128(_mm_and_si128(update, _mm_or_si128(_mm_and_si128(p, _mm_set1_epi8(0x7f)), _mm_set1_epi8(info->after))), _mm_andnot_si128(update, p));
+	_mm_storeu_si128((__m128i *)pri, p);
+
+	_mm_storeu_si128((__m128i *)mask, draw);
+	return _mm_movemask_epi8(draw);
+#else
+	UINT32 bits = 0, shadow = 0;
+	int i;
+
+	for (i = 0; i < SPAN_PIXELS; i++)
+	{
+		UINT8 p = pri[i];
+		UINT8 draw = mask[i] & info->drawable[p & 0x1f];
+
+		if (info->drawnonly ? draw : mask[i])
+			pri[i] = (p & 0x7f) | info->after;
+		mask[i] = draw;
+		bits |= (draw & 1) << i;
+		if (!info->drawnonly)
+			shadow |= ((draw & p) >> 7) << i;
+	}
+	*shadowbits = shadow;
+	return bits;
+#endif
+}
+
+
+/*-------------------------------------------------
+    span_store8/16/32 - write SPAN_PIXELS values
+    wherever mask is set
+-------------------------------------------------*/
+
+INLINE void span_store8(UINT8 *dest, const UINT8 *vals, const UINT8 *mask)
+{
+#if defined(DRAWGFX_NEON)
+	vst1q_u8(dest, vbslq_u8(vld1q_u8(mask), vld1q_u8(vals), vld1q_u8(dest)));
+#elif defined(DRAWGFX_SSE2)
+	__m128i m = _mm_loadu_si128((const __m128i *)mask);
+	__m128i d = _mm_loadu_si128((const __m128i *)dest);
+	__m128i v = _mm_loadu_si128((const __m128i *)vals);
+	_mm_storeu_si128((__m128i *)dest, _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, d)));
+#else
+	int i;
+	for (i = 0; i < SPAN_PIXELS; i++)
+		dest[i] = (vals[i] & mask[i]) | (dest[i] & ~mask[i]);
+#endif
+}
+
+INLINE void span_store16(UINT16 *dest, const UINT16 *vals, const UINT8 *mask)
+{
+#if defined(DRAWGFX_NEON)
+	int8x16_t m8 = vreinterpretq_s8_u8(vld1q_u8(mask));
+	int i;
+
+	for (i = 0; i < 2; i++)
+	{
+		uint16x8_t m = vreinterpretq_u16_s16(vmovl_s8(i ? vget_high_s8(m8) : vget_low_s8(m8)));
+		vst1q_u16(&dest[8 * i], vbslq_u16(m, vld1q_u16(&vals[8 * i]), vld1q_u16(&dest[8 * i])));
+	}
+#elif defined(DRAWGFX_SSE2)
+	__m128i m8 = _mm_loadu_si128((const __m128i *)mask);
+	int i;
+
+	for (i = 0; i < 2; i++)
+	{
+		__m128i m = i ? _mm_unpackhi_epi8(m8, m8) : _mm_unpacklo_epi8(m8, m8);
+		__m128i d = _mm_loadu_si128((const __m128i *)&dest[8 * i]);
+		__m128i v = _mm_loadu_si128((const __m128i *)&vals[8 * i]);
+		_mm_storeu_si128((__m128i *)&dest[8 * i], _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, d)));
+	}
+#else
+	int i;
+	for (i = 0; i < SPAN_PIXELS; i++)
+		if (mask[i])
+			dest[i] = vals[i];
+#endif
+}
+
+INLINE void span_store32(UINT32 *dest, const UINT32 *vals, const UINT8 *mask)
+{
+#if defined(DRAWGFX_NEON)
+	int8x16_t m8 = vreinterpretq_s8_u8(vld1q_u8(mask));
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		int16x8_t m16 = vmovl_s8((i & 2) ? vget_high_s8(m8) : vget_low_s8(m8));
+		uint32x4_t m = vreinterpretq_u32_s32(vmovl_s16((i & 1) ? vget_high_s16(m16) : vget_low_s16(m16)));
+		vst1q_u32(&dest[4 * i], vbslq_u32(m, vld1q_u32(&vals[4 * i]), vld1q_u32(&dest[4 * i])));
+	}
+#elif defined(DRAWGFX_SSE2)
+	__m128i m8 = _mm_loadu_si128((const __m128i *)mask);
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		__m128i m16 = (i & 2) ? _mm_unpackhi_epi8(m8, m8) : _mm_unpacklo_epi8(m8, m8);
+		__m128i m = (i & 1) ? _mm_unpackhi_epi16(m16, m16) : _mm_unpacklo_epi16(m16, m16);
+		__m128i d = _mm_loadu_si128((const __m128i *)&dest[4 * i]);
+		__m128i v = _mm_loadu_si128((const __m128i *)&vals[4 * i]);
+		_mm_storeu_si128((__m128i *)&dest[4 * i], _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, d)));
+	}
+#else
+	int i;
+	for (i = 0; i < SPAN_PIXELS; i++)
+		if (mask[i])
+			dest[i] = vals[i];
+#endif
+}
+
+
+
 /***************************************************************************
     INITIALIZATION
 ***************************************************************************/
@@ -606,6 +903,7 @@ int pdrawgfx_shadow_lowpri = 0;
 /* 8-bit version */
 #define DATA_TYPE UINT8
 #define DEPTH 8
+#define SPAN_STORE span_store8
 
 #define DECLARE(function,args,body)
 #define DECLAREG(function,args,body)
@@ -621,9 +919,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define INCREMENT_DST(n) {dstdata+=(n);pridata += (n);}
 #define LOOKUP(n) (colorbase + (n))
 #define SETPIXELCOLOR(dest,n) { if (((1 << (pridata[dest] & 0x1f)) & pmask) == 0) { if (pridata[dest] & 0x80) { dstdata[dest] = palette_shadow_table[n];} else { dstdata[dest] = (n);} } pridata[dest] = (pridata[dest] & 0x7f) | afterdrawmask; }
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) span_priority_setup(&info, pmask, afterdrawmask, FALSE)
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow) bits = span_priority_merge(pridata, mask, &info, &shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_raw_pri8 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef SETPIXELCOLOR
@@ -631,9 +935,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define COLOR_ARG const pen_t *paldata,UINT8 *pridata,UINT32 pmask
 #define LOOKUP(n) (paldata[n])
 #define SETPIXELCOLOR(dest,n) { if (((1 << (pridata[dest] & 0x1f)) & pmask) == 0) { if (pridata[dest] & 0x80) { dstdata[dest] = palette_shadow_table[n];} else { dstdata[dest] = (n);} } pridata[dest] = (pridata[dest] & 0x7f) | afterdrawmask; }
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) span_priority_setup(&info, pmask, afterdrawmask, FALSE)
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow) bits = span_priority_merge(pridata, mask, &info, &shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_pri8 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef INCREMENT_DST
@@ -643,9 +953,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define INCREMENT_DST(n) {dstdata+=(n);}
 #define LOOKUP(n) (colorbase + (n))
 #define SETPIXELCOLOR(dest,n) {dstdata[dest] = (n);}
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) (void)&info
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_raw8 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef SETPIXELCOLOR
@@ -653,9 +969,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define COLOR_ARG const pen_t *paldata
 #define LOOKUP(n) (paldata[n])
 #define SETPIXELCOLOR(dest,n) {dstdata[dest] = (n);}
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) (void)&info
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##8 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef INCREMENT_DST
@@ -693,10 +1015,12 @@ int pdrawgfx_shadow_lowpri = 0;
 
 #undef DEPTH
 #undef DATA_TYPE
+#undef SPAN_STORE
 
 /* 16-bit version */
 #define DATA_TYPE UINT16
 #define DEPTH 16
+#define SPAN_STORE span_store16
 #define alpha_blend_r alpha_blend_r16
 #define alpha_blend alpha_blend16
 
@@ -714,9 +1038,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define INCREMENT_DST(n) {dstdata+=(n);pridata += (n);}
 #define LOOKUP(n) (colorbase + (n))
 #define SETPIXELCOLOR(dest,n) { if (((1 << (pridata[dest] & 0x1f)) & pmask) == 0) { if (pridata[dest] & 0x80) { dstdata[dest] = palette_shadow_table[n];} else { dstdata[dest] = (n);} } pridata[dest] = (pridata[dest] & 0x7f) | afterdrawmask; }
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) span_priority_setup(&info, pmask, afterdrawmask, FALSE)
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow) bits = span_priority_merge(pridata, mask, &info, &shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_raw_pri16 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef SETPIXELCOLOR
@@ -724,9 +1054,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define COLOR_ARG const pen_t *paldata,UINT8 *pridata,UINT32 pmask
 #define LOOKUP(n) (paldata[n])
 #define SETPIXELCOLOR(dest,n) { if (((1 << (pridata[dest] & 0x1f)) & pmask) == 0) { if (pridata[dest] & 0x80) { dstdata[dest] = palette_shadow_table[n];} else { dstdata[dest] = (n);} } pridata[dest] = (pridata[dest] & 0x7f) | afterdrawmask; }
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) span_priority_setup(&info, pmask, afterdrawmask, FALSE)
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow) bits = span_priority_merge(pridata, mask, &info, &shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_pri16 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef INCREMENT_DST
@@ -736,9 +1072,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define INCREMENT_DST(n) {dstdata+=(n);}
 #define LOOKUP(n) (colorbase + (n))
 #define SETPIXELCOLOR(dest,n) {dstdata[dest] = (n);}
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) (void)&info
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_raw16 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef SETPIXELCOLOR
@@ -746,9 +1088,15 @@ int pdrawgfx_shadow_lowpri = 0;
 #define COLOR_ARG const pen_t *paldata
 #define LOOKUP(n) (paldata[n])
 #define SETPIXELCOLOR(dest,n) {dstdata[dest] = (n);}
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) (void)&info
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##16 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef INCREMENT_DST
@@ -786,6 +1134,7 @@ int pdrawgfx_shadow_lowpri = 0;
 
 #undef DEPTH
 #undef DATA_TYPE
+#undef SPAN_STORE
 #undef alpha_blend_r
 #undef alpha_blend
 
@@ -797,6 +1146,7 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 
 #define DATA_TYPE UINT32
 #define DEPTH 32
+#define SPAN_STORE span_store32
 #define alpha_blend_r alpha_blend_r32
 #define alpha_blend alpha_blend32
 
@@ -814,9 +1164,15 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 #define INCREMENT_DST(n) {dstdata+=(n);pridata += (n);}
 #define LOOKUP(n) (colorbase + (n))
 #define SETPIXELCOLOR(dest,n) { UINT8 r8=pridata[dest]; if(!(1<<(r8&0x1f)&pmask)){ if(afterdrawmask){ r8&=0x7f; r8|=0x1f; dstdata[dest]=(n); pridata[dest]=r8; } else if(!(r8&0x80)){ dstdata[dest]=SHADOW32(palette_shadow_table,n); pridata[dest]|=0x80; } } }
+#define SPAN_USABLE (afterdrawmask != 0)
+#define SPAN_PRIORITY_SETUP(info) span_priority_setup(&info, pmask, 0x1f, TRUE)
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow) bits = span_priority_merge(pridata, mask, &info, &shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_raw_pri32 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef SETPIXELCOLOR
@@ -824,9 +1180,15 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 #define COLOR_ARG const pen_t *paldata,UINT8 *pridata,UINT32 pmask
 #define LOOKUP(n) (paldata[n])
 #define SETPIXELCOLOR(dest,n) { UINT8 r8=pridata[dest]; if(!(1<<(r8&0x1f)&pmask)){ if(afterdrawmask){ r8&=0x7f; r8|=0x1f; dstdata[dest]=(n); pridata[dest]=r8; } else if(!(r8&0x80)){ dstdata[dest]=SHADOW32(palette_shadow_table,n); pridata[dest]|=0x80; } } }
+#define SPAN_USABLE (afterdrawmask != 0)
+#define SPAN_PRIORITY_SETUP(info) span_priority_setup(&info, pmask, 0x1f, TRUE)
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow) bits = span_priority_merge(pridata, mask, &info, &shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_pri32 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef INCREMENT_DST
@@ -836,9 +1198,15 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 #define INCREMENT_DST(n) {dstdata+=(n);}
 #define LOOKUP(n) (colorbase + (n))
 #define SETPIXELCOLOR(dest,n) {dstdata[dest] = (n);}
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) (void)&info
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##_raw32 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef SETPIXELCOLOR
@@ -846,9 +1214,15 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 #define COLOR_ARG const pen_t *paldata
 #define LOOKUP(n) (paldata[n])
 #define SETPIXELCOLOR(dest,n) {dstdata[dest] = (n);}
+#define SPAN_USABLE 1
+#define SPAN_PRIORITY_SETUP(info) (void)&info
+#define SPAN_PRIORITY_MERGE(info,mask,bits,shadow)
 #define DECLARE_SWAP_RAW_PRI(function,args,body) void function##32 args body
 #include "drawgfx.c"
 #undef DECLARE_SWAP_RAW_PRI
+#undef SPAN_USABLE
+#undef SPAN_PRIORITY_SETUP
+#undef SPAN_PRIORITY_MERGE
 #undef COLOR_ARG
 #undef LOOKUP
 #undef INCREMENT_DST
@@ -886,6 +1260,7 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 
 #undef DEPTH
 #undef DATA_TYPE
+#undef SPAN_STORE
 #undef alpha_blend_r
 #undef alpha_blend
 
@@ -929,25 +1304,34 @@ INLINE void common_drawgfx(mame_bitmap *dest,const gfx_element *gfx,
 		transparent_color &= 0xff;
 	}
 
-	if (gfx->pen_usage && (transparency == TRANSPARENCY_PEN || transparency == TRANSPARENCY_PENS))
+	/* skip fully transparent elements, and drop the transparency test for fully opaque ones */
+	if (gfx->pen_usage && (transparency == TRANSPARENCY_PEN || transparency == TRANSPARENCY_PEN_RAW ||
+			transparency == TRANSPARENCY_PENS || transparency == TRANSPARENCY_PENS_RAW))
 	{
-		int transmask = 0;
+		UINT32 transmask;
 
-		if (transparency == TRANSPARENCY_PEN)
+		if (transparency == TRANSPARENCY_PEN || transparency == TRANSPARENCY_PEN_RAW)
 		{
-			transmask = 1 << (transparent_color & 0xff);
+			/* pens above 31 never occur in elements that track pen usage */
+			int transpen = transparent_color & 0xff;
+			transmask = (transpen < 32) ? (1 << transpen) : 0;
 		}
-		else	/* transparency == TRANSPARENCY_PENS */
+		else	/* transparency == TRANSPARENCY_PENS or TRANSPARENCY_PENS_RAW */
 		{
 			transmask = transparent_color;
 		}
 
-		if ((gfx->pen_usage[code] & ~transmask) == 0)
-			/* character is totally transparent, no need to draw */
-			return;
-		else if ((gfx->pen_usage[code] & transmask) == 0)
-			/* character is totally opaque, can disable transparency */
-			transparency = TRANSPARENCY_NONE;
+		switch (gfx_element_opacity(gfx, code, transmask))
+		{
+			case GFX_OPACITY_TRANSPARENT:
+				/* character is totally transparent, no need to draw */
+				return;
+
+			case GFX_OPACITY_OPAQUE:
+				/* character is totally opaque, can disable transparency */
+				transparency = is_raw[transparency] ? TRANSPARENCY_NONE_RAW : TRANSPARENCY_NONE;
+				break;
+		}
 	}
 
 	if (dest->bpp == 8)
@@ -1371,6 +1755,24 @@ INLINE void common_drawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 		transparent_color &= 0xff;
 	}
 
+	/* skip fully transparent elements, and drop the transparency test for fully opaque ones */
+	if (gfx && gfx->pen_usage && (transparency == TRANSPARENCY_PEN || transparency == TRANSPARENCY_PEN_RAW || transparency == TRANSPARENCY_PENS))
+	{
+		UINT32 transmask;
+		int opacity;
+
+		if (transparency == TRANSPARENCY_PENS)
+			transmask = transparent_color;
+		else
+			transmask = ((UINT32)transparent_color < 32) ? (1 << transparent_color) : 0;
+
+		opacity = gfx_element_opacity(gfx, code % gfx->total_elements, transmask);
+		if (opacity == GFX_OPACITY_TRANSPARENT)
+			return;
+		if (opacity == GFX_OPACITY_OPAQUE && transparency != TRANSPARENCY_PEN_RAW)
+			transparency = TRANSPARENCY_NONE;
+	}
+
 	if (transparency == TRANSPARENCY_COLOR)
 		transparent_color = Machine->pens[transparent_color];
 
@@ -3575,6 +3977,58 @@ DECLARE_SWAP_RAW_PRI(blockmove_8toN_transpen,(COMMON_ARGS,
 
 	(void)palette_shadow_table;
 
+	/* rows of at least one full span go through the span kernels, left to right */
+	if (dstwidth >= SPAN_PIXELS && SPAN_USABLE && SPANS_ENABLED)
+	{
+		span_priority spanpri;
+
+		SPAN_PRIORITY_SETUP(spanpri);
+		if (flipx)
+			INCREMENT_DST(-(dstwidth-1)*HMODULO)
+
+		while (dstheight)
+		{
+			int x;
+
+			for (x = 0; x <= dstwidth - SPAN_PIXELS; x += SPAN_PIXELS)
+			{
+				UINT8 cols[SPAN_PIXELS];
+				UINT8 mask[SPAN_PIXELS];
+				DATA_TYPE vals[SPAN_PIXELS];
+				UINT32 shadowbits = 0;
+				UINT32 bits;
+				int i;
+
+				bits = span_transpen_mask(flipx ? srcdata + dstwidth - SPAN_PIXELS - x : srcdata + x, flipx, transpen, cols, mask);
+				if (bits != 0)
+				{
+					SPAN_PRIORITY_MERGE(spanpri, mask, bits, shadowbits);
+
+					/* masked-off pixels look up entry 0 so we never read past the palette */
+					for (i = 0; i < SPAN_PIXELS; i++)
+						vals[i] = LOOKUP(cols[i] & mask[i]);
+					for (i = 0; shadowbits != 0; i++, shadowbits >>= 1)
+						if (shadowbits & 1)
+							vals[i] = palette_shadow_table[LOOKUP(cols[i])];
+					if (bits != 0)
+						SPAN_STORE(dstdata, vals, mask);
+				}
+				INCREMENT_DST(SPAN_PIXELS*HMODULO)
+			}
+			for ( ; x < dstwidth; x++)
+			{
+				int col = flipx ? srcdata[dstwidth - 1 - x] : srcdata[x];
+				if (col != transpen) SETPIXELCOLOR(0,LOOKUP(col))
+				INCREMENT_DST(HMODULO)
+			}
+
+			srcdata += dstwidth + srcmodulo;
+			INCREMENT_DST(ydir*VMODULO - dstwidth*HMODULO);
+			dstheight--;
+		}
+		return;
+	}
+
 	if (flipx)
 	{
 		DATA_TYPE *end;
@@ -67,6 +67,14 @@ enum
 	TRANSPARENCY_MODES			/* total number of modes; must be last */
 };
 
+/* per-element opacity classes returned by gfx_element_opacity() */
+enum
+{
+	GFX_OPACITY_MIXED,			/* some pixels are drawn and some are not, or pen usage is unknown */
+	GFX_OPACITY_TRANSPARENT,	/* no pixel would be drawn */
+	GFX_OPACITY_OPAQUE			/* every pixel would be drawn */
+};
+
 enum
 {
 	DRAWMODE_NONE,
@@ -328,4 +336,51 @@ INLINE UINT32 alpha_blend_r32( UINT32 d, UINT32 s, UINT8 level )
 }
 
 
+/*-------------------------------------------------
+    gfx_element_opacity - classify an element
+    against a mask of transparent pens 0-31,
+    based on its pen_usage; elements with more
+    than 32 colors are always reported as mixed
+-------------------------------------------------*/
+
+INLINE int gfx_element_opacity(const gfx_element *gfx, UINT32 code, UINT32 transmask)
+{
+	UINT32 usage;
+
+	if (gfx->pen_usage == NULL)
+		return GFX_OPACITY_MIXED;
+
+	usage = gfx->pen_usage[code];
+	if ((usage & ~transmask) == 0)
+		return GFX_OPACITY_TRANSPARENT;
+	if ((usage & transmask) == 0)
+		return GFX_OPACITY_OPAQUE;
+	return GFX_OPACITY_MIXED;
+}
+
+
+/*-------------------------------------------------
+    gfx_element_single_pen - return the only pen
+    used by an element, or -1 if it uses more
+    than one pen or its pen usage is unknown
+-------------------------------------------------*/
+
+INLINE int gfx_element_single_pen(const gfx_element *gfx, UINT32 code)
+{
+	UINT32 usage;
+	int pen;
+
+	if (gfx->pen_usage == NULL)
+		return -1;
+
+	usage = gfx->pen_usage[code];
+	if (usage == 0 || (usage & (usage - 1)) != 0)
+		return -1;
+
+	for (pen = 0; !(usage & 1); pen++)
+		usage >>= 1;
+	return pen;
+}
+
+
 #endif	/* __DRAWGFX_H__ */
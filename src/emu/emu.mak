@@ -51,6 +51,7 @@ EMUOBJS = \
 	$(EMUOBJ)/fileio.o \
 	$(EMUOBJ)/hash.o \
 	$(EMUOBJ)/info.o \
+	$(EMUOBJ)/inplog.o \
 	$(EMUOBJ)/input.o \
 	$(EMUOBJ)/inputseq.o \
 	$(EMUOBJ)/inptport.o \
@@ -63,6 +64,7 @@ EMUOBJS = \
 	$(EMUOBJ)/rendlay.o \
 	$(EMUOBJ)/rendutil.o \
 	$(EMUOBJ)/restrack.o \
+	$(EMUOBJ)/rewind.o \
 	$(EMUOBJ)/romload.o \
 	$(EMUOBJ)/sound.o \
 	$(EMUOBJ)/sndintrf.o \
@@ -64,8 +64,14 @@ const options_entry mame_core_options[] =
 	{ "autosave",                    "0",         OPTION_BOOLEAN,    "enable automatic restore at startup, and automatic save at exit time" },
 	{ "playback;pb",                 NULL,        0,                 "playback an input file" },
 	{ "record;rec",                  NULL,        0,                 "record an input file" },
+	{ "compact_inp",                 "0",         OPTION_BOOLEAN,    "record input files in the compact, seekable format" },
+	{ "inp_keyframes",               "600",       0,                 "number of frames between keyframes in compact input files (0 = none)" },
+	{ "playback_start",              "0",         0,                 "frame of a compact input file to start playing back from" },
 	{ "mngwrite",                    NULL,        0,                 "optional filename to write a MNG movie of the current session" },
 	{ "wavwrite",                    NULL,        0,                 "optional filename to write a WAV file of the current session" },
+	{ "aviwrite",                    NULL,        0,                 "optional filename to write an AVI movie with sound of the current session" },
+	{ "rewind",                      "0",         0,                 "kilobytes of memory to keep for rewinding the game (0 = disabled)" },
+	{ "rewind_interval",             "4",         0,                 "number of frames between rewind snapshots" },
 
 	/* performance options */
 	{ NULL,                          NULL,        OPTION_HEADER,     "CORE PERFORMANCE OPTIONS" },
@@ -76,6 +82,7 @@ const options_entry mame_core_options[] =
 	{ "sleep",                       "1",         OPTION_BOOLEAN,    "enable sleeping, which gives time back to other applications when idle" },
 	{ "speed(0.01-100)",             "1.0",       0,                 "controls the speed of gameplay, relative to realtime; smaller numbers are slower" },
 	{ "refreshspeed;rs",             "0",         OPTION_BOOLEAN,    "automatically adjusts the speed of gameplay to keep the refresh rate lower than the screen" },
+	{ "tilemapbands",                "1",         0,                 "number of horizontal bands each tilemap is split into and drawn in parallel (1 = draw on the calling thread)" },
 
 	/* rotation options */
 	{ NULL,                          NULL,        OPTION_HEADER,     "CORE ROTATION OPTIONS" },
@@ -93,6 +100,7 @@ const options_entry mame_core_options[] =
 	{ "use_backdrops;backdrop",      "1",         OPTION_BOOLEAN,    "enable backdrops if artwork is enabled and available" },
 	{ "use_overlays;overlay",        "1",         OPTION_BOOLEAN,    "enable overlays if artwork is enabled and available" },
 	{ "use_bezels;bezel",            "1",         OPTION_BOOLEAN,    "enable bezels if artwork is enabled and available" },
+	{ "scalecache",                  "32768",     0,                 "maximum KB of scaled artwork, font and crosshair textures kept for reuse" },
 
 	/* screen options */
 	{ NULL,                          NULL,        OPTION_HEADER,     "CORE SCREEN OPTIONS" },
@@ -112,6 +120,8 @@ const options_entry mame_core_options[] =
 	{ "sound",                       "1",         OPTION_BOOLEAN,    "enable sound output" },
 	{ "samplerate;sr(1000-1000000)", "48000",     0,                 "set sound output sample rate" },
 	{ "samples",                     "1",         OPTION_BOOLEAN,    "enable the use of external samples if available" },
+	{ "samplecache",                 "0",         0,                 "maximum KB of sample data kept in memory; least recently used samples are reloaded on demand (0 = no limit)" },
+	{ "adpcmcache",                  "0",         0,                 "maximum KB of decoded ADPCM phrases cached per OKIM6295 chip (0 = disabled)" },
 	{ "volume;vol",                  "0",         0,                 "sound volume in decibels (-32 min, 0 max)" },
 
 	/* input options */
@@ -157,6 +167,9 @@ const options_entry mame_core_options[] =
 	{ "bios",                        "default",   0,                 "select the system BIOS to use" },
 	{ "cheat;c",                     "0",         OPTION_BOOLEAN,    "enable cheat subsystem" },
 	{ "skip_gameinfo",               "0",         OPTION_BOOLEAN,    "skip displaying the information screen at startup" },
+	{ "hashcache",                   "1",         OPTION_BOOLEAN,    "remember verified ROM hashes so unchanged files are not hashed again" },
+	{ "rehash",                      "0",         OPTION_BOOLEAN,    "ignore remembered ROM hashes and verify every file in full" },
+	{ "validitycache",               "1",         OPTION_BOOLEAN,    "skip the validity checks for drivers that already passed them with this build" },
 
 	{ NULL }
 };
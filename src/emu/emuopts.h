@@ -63,8 +63,14 @@
 #define OPTION_AUTOSAVE				"autosave"
 #define OPTION_PLAYBACK				"playback"
 #define OPTION_RECORD				"record"
+#define OPTION_COMPACT_INP			"compact_inp"
+#define OPTION_INP_KEYFRAMES		"inp_keyframes"
+#define OPTION_PLAYBACK_START		"playback_start"
 #define OPTION_MNGWRITE				"mngwrite"
 #define OPTION_WAVWRITE				"wavwrite"
+#define OPTION_AVIWRITE				"aviwrite"
+#define OPTION_REWIND				"rewind"
+#define OPTION_REWIND_INTERVAL		"rewind_interval"
 
 /* core performance options */
 #define OPTION_AUTOFRAMESKIP		"autoframeskip"
@@ -74,6 +80,7 @@
 #define OPTION_SLEEP				"sleep"
 #define OPTION_SPEED				"speed"
 #define OPTION_REFRESHSPEED			"refreshspeed"
+#define OPTION_TILEMAPBANDS			"tilemapbands"
 
 /* core rotation options */
 #define OPTION_ROTATE				"rotate"
@@ -89,6 +96,7 @@
 #define OPTION_USE_BACKDROPS		"use_backdrops"
 #define OPTION_USE_OVERLAYS			"use_overlays"
 #define OPTION_USE_BEZELS			"use_bezels"
+#define OPTION_SCALECACHE			"scalecache"
 
 /* core screen options */
 #define OPTION_BRIGHTNESS			"brightness"
@@ -105,6 +113,8 @@
 #define OPTION_SOUND				"sound"
 #define OPTION_SAMPLERATE			"samplerate"
 #define OPTION_SAMPLES				"samples"
+#define OPTION_SAMPLECACHE			"samplecache"
+#define OPTION_ADPCMCACHE			"adpcmcache"
 #define OPTION_VOLUME				"volume"
 
 /* core input options */
@@ -139,6 +149,9 @@
 #define OPTION_BIOS					"bios"
 #define OPTION_CHEAT				"cheat"
 #define OPTION_SKIP_GAMEINFO		"skip_gameinfo"
+#define OPTION_HASHCACHE			"hashcache"
+#define OPTION_REHASH				"rehash"
+#define OPTION_VALIDITYCACHE		"validitycache"
 
 
 
@@ -28,6 +28,10 @@
 
 #define OPEN_FLAG_HAS_CRC		0x10000
 
+#define HASH_CACHE_FILENAME		"hash.cache"
+#define HASH_CACHE_SIGNATURE	"# MAME hash cache v1"
+#define HASH_CACHE_BUCKETS		4096
+
 #ifdef MAME_DEBUG
 #define DEBUG_COOKIE			0xbaadf00d
 #endif
@@ -46,10 +50,28 @@ struct _mame_file
 #endif
 	core_file *		file;							/* core file pointer */
 	UINT32			openflags;						/* flags we used for the open */
+	astring *		filename;						/* full path of a file opened directly */
 	char			hash[HASH_BUF_SIZE];			/* hash data for the file */
 	zip_file *		zipfile;						/* ZIP file pointer */
+	const zip_file_header *zipheader;				/* ZIP index entry for this file */
 	UINT8 *			zipdata;						/* ZIP file data */
 	UINT64			ziplength;						/* ZIP file length */
+	astring *		cachekey;						/* hash cache key: path, plus entry name for ZIPs */
+	int				cachepathlen;					/* length of the path part of the key */
+	int				cachestat;						/* 0 = not checked, 1 = valid, -1 = unavailable */
+	UINT64			cachesize;						/* size of the file or ZIP on disk */
+	UINT64			cachemodified;					/* modification time of the file or ZIP on disk */
+};
+
+
+typedef struct _hash_cache_entry hash_cache_entry;
+struct _hash_cache_entry
+{
+	hash_cache_entry *next;							/* next entry in this bucket */
+	UINT64			size;							/* size of the file or ZIP when verified */
+	UINT64			modified;						/* modification time when verified */
+	char			hash[HASH_BUF_SIZE];			/* hash data computed from the contents */
+	char			key[1];							/* path, plus entry name for ZIPs */
 };
 
 
@@ -73,6 +95,21 @@ struct _mame_path
 
 
 
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+/* hash cache */
+static hash_cache_entry *hash_cache[HASH_CACHE_BUCKETS];
+static core_options *hash_cache_options;
+static int hash_cache_enabled;
+static int hash_cache_rehash;
+static int hash_cache_dirty;
+static int hash_cache_hits;
+static int hash_cache_misses;
+
+
+
 /***************************************************************************
     FUNCTION PROTOTYPES
 ***************************************************************************/
@@ -88,9 +125,15 @@ static file_error fopen_attempt_zipped(astring *fullname, UINT32 crc, UINT32 ope
 static void path_iterator_init(path_iterator *iterator, core_options *opts, const char *searchpath);
 static int path_iterator_get_next(path_iterator *iterator, astring *buffer);
 
+/* hash cache */
+static void hash_cache_set_key(mame_file *file, const char *path, const char *entry);
+static int hash_cache_lookup(mame_file *file, UINT32 functions);
+static void hash_cache_store(mame_file *file);
+static hash_cache_entry **hash_cache_find(const char *key);
+static void hash_cache_free(void);
+
 /* misc helpers */
 static file_error load_zipped_file(mame_file *file);
-static int zip_filename_match(const zip_file_header *header, const astring *afilename);
 
 
 
@@ -106,6 +149,7 @@ static int zip_filename_match(const zip_file_header *header, const astring *afil
 
 void fileio_init(running_machine *machine)
 {
+	mame_hash_cache_load(mame_options());
 	add_exit_callback(machine, fileio_exit);
 }
 
@@ -116,6 +160,7 @@ void fileio_init(running_machine *machine)
 
 static void fileio_exit(running_machine *machine)
 {
+	mame_hash_cache_save();
 	zip_file_cache_clear();
 }
 
@@ -251,7 +296,12 @@ static file_error fopen_internal(core_options *opts, const char *searchpath, con
 		/* attempt to open the file directly */
 		filerr = core_fopen(astring_c(fullname), openflags, &(*file)->file);
 		if (filerr == FILERR_NONE)
+		{
+			(*file)->filename = astring_dupc(astring_c(fullname));
+			if ((openflags & (OPEN_FLAG_READ | OPEN_FLAG_WRITE)) == OPEN_FLAG_READ)
+				hash_cache_set_key(*file, astring_c(fullname), NULL);
 			break;
+		}
 
 		/* if we're opening for read-only we have other options */
 		if ((openflags & (OPEN_FLAG_READ | OPEN_FLAG_WRITE)) == OPEN_FLAG_READ)
@@ -318,22 +368,16 @@ static file_error fopen_attempt_zipped(astring *fullname, UINT32 crc, UINT32 ope
 			continue;
 
 		/* see if we can find a file with the right name and (if available) crc */
-		for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-			if (zip_filename_match(header, filename) && (!(openflags & OPEN_FLAG_HAS_CRC) || header->crc == crc))
-				break;
+		header = zip_file_find(zip, astring_c(filename), crc, ZIP_FIND_NAME | ((openflags & OPEN_FLAG_HAS_CRC) ? ZIP_FIND_CRC : 0));
 
 		/* if that failed, look for a file with the right crc, but the wrong filename */
 		if (header == NULL && (openflags & OPEN_FLAG_HAS_CRC))
-			for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-				if (header->crc == crc)
-					break;
+			header = zip_file_find(zip, NULL, crc, ZIP_FIND_CRC);
 
 		/* if that failed, look for a file with the right name; reporting a bad checksum */
 		/* is more helpful and less confusing than reporting "rom not found" */
 		if (header == NULL)
-			for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-				if (zip_filename_match(header, filename))
-					break;
+			header = zip_file_find(zip, astring_c(filename), 0, ZIP_FIND_NAME);
 
 		/* if we got it, read the data */
 		if (header != NULL)
@@ -341,7 +385,9 @@ static file_error fopen_attempt_zipped(astring *fullname, UINT32 crc, UINT32 ope
 			UINT8 crcs[4];
 
 			file->zipfile = zip;
+			file->zipheader = header;
 			file->ziplength = header->uncompressed_length;
+			hash_cache_set_key(file, zip->filename, header->filename);
 
 			/* build a hash with just the CRC */
 			hash_data_clear(file->hash);
@@ -379,6 +425,10 @@ void mame_fclose(mame_file *file)
 		core_fclose(file->file);
 	if (file->zipdata != NULL)
 		free(file->zipdata);
+	if (file->cachekey != NULL)
+		astring_free(file->cachekey);
+	if (file->filename != NULL)
+		astring_free(file->filename);
 	free(file);
 }
 
@@ -540,6 +590,33 @@ char *mame_fgets(char *s, int n, mame_file *file)
 
 
 
+/*-------------------------------------------------
+    mame_fload - read an entire file into a
+    caller-supplied buffer; ZIPped files are
+    inflated straight into the buffer, and
+    different files may be loaded from several
+    threads at once
+-------------------------------------------------*/
+
+UINT32 mame_fload(mame_file *file, void *buffer, UINT32 length)
+{
+	/* inflate ZIPped files directly if they fit */
+	if (file->zipfile != NULL)
+	{
+		if (length < file->ziplength || zip_file_decompress_entry(file->zipfile, file->zipheader, buffer, length) != ZIPERR_NONE)
+			return 0;
+		return file->ziplength;
+	}
+
+	/* otherwise, read from the start */
+	if (file->file != NULL && core_fseek(file->file, 0, SEEK_SET) == 0)
+		return core_fread(file->file, buffer, length);
+
+	return 0;
+}
+
+
+
 /***************************************************************************
     FILE WRITE
 ***************************************************************************/
@@ -701,6 +778,18 @@ core_file *mame_core_file(mame_file *file)
 }
 
 
+/*-------------------------------------------------
+    mame_file_full_name - return the full path
+    of a file opened directly, or NULL for a
+    file inside a ZIP
+-------------------------------------------------*/
+
+const char *mame_file_full_name(mame_file *file)
+{
+	return (file->filename != NULL) ? astring_c(file->filename) : NULL;
+}
+
+
 /*-------------------------------------------------
     mame_fhash - returns the hash for a file
 -------------------------------------------------*/
@@ -710,10 +799,10 @@ const char *mame_fhash(mame_file *file, UINT32 functions)
 	const UINT8 *filedata;
 	UINT32 wehave;
 
-	/* if we already have the functions we need, just return */
-	wehave = hash_data_used_functions(file->hash);
-	if ((wehave & functions) == functions)
+	/* if we already have the functions we need, or verified the file on an earlier run, just return */
+	if (mame_fhash_cached(file, functions))
 		return file->hash;
+	wehave = hash_data_used_functions(file->hash);
 
 	/* load the ZIP file now if we haven't yet */
 	if (file->zipfile != NULL)
@@ -726,12 +815,290 @@ const char *mame_fhash(mame_file *file, UINT32 functions)
 	if (filedata == NULL)
 		return file->hash;
 
-	/* compute the hash */
+	/* compute the hash and remember it for next time */
 	hash_compute(file->hash, filedata, core_fsize(file->file), wehave | functions);
+	hash_cache_store(file);
 	return file->hash;
 }
 
 
+/*-------------------------------------------------
+    mame_fhash_cached - return TRUE if the hash
+    for the given functions is already known,
+    either from the file itself or from the hash
+    cache, so that mame_fhash will not need to
+    read the data
+-------------------------------------------------*/
+
+int mame_fhash_cached(mame_file *file, UINT32 functions)
+{
+	if ((hash_data_used_functions(file->hash) & functions) == functions)
+		return TRUE;
+	return hash_cache_lookup(file, functions);
+}
+
+
+/*-------------------------------------------------
+    mame_fhash_update - supply a hash that the
+    caller computed over the full file contents
+-------------------------------------------------*/
+
+void mame_fhash_update(mame_file *file, const char *hash)
+{
+	hash_data_copy(file->hash, hash);
+	hash_cache_store(file);
+}
+
+
+
+/***************************************************************************
+    HASH CACHE
+***************************************************************************/
+
+/*-------------------------------------------------
+    mame_hash_cache_load - load the hashes that
+    were verified on earlier runs
+-------------------------------------------------*/
+
+void mame_hash_cache_load(core_options *opts)
+{
+	char line[1024];
+	mame_file *file;
+
+	/* start from scratch */
+	hash_cache_free();
+	hash_cache_options = opts;
+	hash_cache_enabled = options_get_bool(opts, OPTION_HASHCACHE);
+	hash_cache_rehash = options_get_bool(opts, OPTION_REHASH);
+	hash_cache_hits = hash_cache_misses = 0;
+	if (!hash_cache_enabled)
+		return;
+
+	/* if there is no cache yet, we're done */
+	if (mame_fopen_options(opts, SEARCHPATH_CONFIG, HASH_CACHE_FILENAME, OPEN_FLAG_READ, &file) != FILERR_NONE)
+		return;
+
+	/* ignore caches written in some other format */
+	if (mame_fgets(line, sizeof(line), file) == NULL || strncmp(line, HASH_CACHE_SIGNATURE, strlen(HASH_CACHE_SIGNATURE)) != 0)
+	{
+		mame_fclose(file);
+		return;
+	}
+
+	/* each line is size, modification time, hash and key; mame_fgets won't terminate overlong lines */
+	line[sizeof(line) - 1] = 0;
+	while (mame_fgets(line, sizeof(line) - 1, file) != NULL)
+	{
+		UINT32 sizehi, sizelo, modhi, modlo;
+		char hash[HASH_BUF_SIZE];
+		hash_cache_entry **entryptr;
+		hash_cache_entry *entry;
+		int keystart, keyend;
+
+		/* skip anything malformed, including lines too long for our buffer */
+		keyend = strlen(line);
+		if (keyend == 0 || (line[keyend - 1] != '\r' && line[keyend - 1] != '\n'))
+			continue;
+		while (keyend > 0 && (line[keyend - 1] == '\n' || line[keyend - 1] == '\r'))
+			line[--keyend] = 0;
+		if (sscanf(line, "%8X%8X %8X%8X %255s %n", &sizehi, &sizelo, &modhi, &modlo, hash, &keystart) != 5 || keystart >= keyend)
+			continue;
+		if (!hash_verify_string(hash))
+			continue;
+
+		/* add a new entry to the end of its bucket, keeping the first of any duplicates */
+		entryptr = hash_cache_find(&line[keystart]);
+		if (*entryptr != NULL)
+			continue;
+		entry = malloc_or_die(sizeof(*entry) + keyend - keystart);
+		entry->next = NULL;
+		entry->size = ((UINT64)sizehi << 32) | sizelo;
+		entry->modified = ((UINT64)modhi << 32) | modlo;
+		strcpy(entry->hash, hash);
+		strcpy(entry->key, &line[keystart]);
+		*entryptr = entry;
+	}
+	mame_fclose(file);
+}
+
+
+/*-------------------------------------------------
+    mame_hash_cache_save - write out the cache if
+    anything new was verified, report statistics
+    and free the cache
+-------------------------------------------------*/
+
+void mame_hash_cache_save(void)
+{
+	mame_file *file;
+	int bucket;
+
+	if (!hash_cache_enabled)
+		return;
+
+	/* report how well we did */
+	if (hash_cache_hits + hash_cache_misses > 0)
+		mame_printf_verbose("Hash cache: %d hits, %d misses%s\n", hash_cache_hits, hash_cache_misses, hash_cache_rehash ? " (rehash forced)" : "");
+
+	/* write the new cache */
+	if (hash_cache_dirty && mame_fopen_options(hash_cache_options, SEARCHPATH_CONFIG, HASH_CACHE_FILENAME, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &file) == FILERR_NONE)
+	{
+		mame_fprintf(file, "%s\n", HASH_CACHE_SIGNATURE);
+		for (bucket = 0; bucket < HASH_CACHE_BUCKETS; bucket++)
+		{
+			hash_cache_entry *entry;
+
+			for (entry = hash_cache[bucket]; entry != NULL; entry = entry->next)
+				mame_fprintf(file, "%08X%08X %08X%08X %s %s\n",
+						(UINT32)(entry->size >> 32), (UINT32)entry->size,
+						(UINT32)(entry->modified >> 32), (UINT32)entry->modified,
+						entry->hash, entry->key);
+		}
+		mame_fclose(file);
+	}
+	hash_cache_free();
+}
+
+
+/*-------------------------------------------------
+    hash_cache_set_key - record where a file came
+    from so that its hash can be cached
+-------------------------------------------------*/
+
+static void hash_cache_set_key(mame_file *file, const char *path, const char *entry)
+{
+	if (!hash_cache_enabled)
+		return;
+
+	/* ZIP entries are keyed by the ZIP path and the name within it */
+	file->cachekey = astring_dupc(path);
+	file->cachepathlen = astring_len(file->cachekey);
+	if (entry != NULL)
+		astring_catc(astring_catc(file->cachekey, "\t"), entry);
+}
+
+
+/*-------------------------------------------------
+    hash_cache_stat - fetch the size and
+    modification time of the file or ZIP a file
+    was opened from; returns FALSE if they are
+    not available
+-------------------------------------------------*/
+
+static int hash_cache_stat(mame_file *file)
+{
+	if (file->cachestat == 0)
+	{
+		astring *path = astring_dupsubstr(file->cachekey, 0, file->cachepathlen);
+		file->cachestat = (osd_stat(astring_c(path), &file->cachesize, &file->cachemodified) == FILERR_NONE) ? 1 : -1;
+		astring_free(path);
+	}
+	return (file->cachestat == 1);
+}
+
+
+/*-------------------------------------------------
+    hash_cache_lookup - fill in the file's hash
+    from the cache if it holds the given
+    functions and the file is unchanged
+-------------------------------------------------*/
+
+static int hash_cache_lookup(mame_file *file, UINT32 functions)
+{
+	hash_cache_entry *entry;
+
+	/* only files with a key can be cached */
+	if (!hash_cache_enabled || file->cachekey == NULL)
+		return FALSE;
+
+	/* the entry must exist, hold everything we need, and match the file on disk */
+	entry = hash_cache_rehash ? NULL : *hash_cache_find(astring_c(file->cachekey));
+	if (entry == NULL || (hash_data_used_functions(entry->hash) & functions) != functions ||
+		!hash_cache_stat(file) || entry->size != file->cachesize || entry->modified != file->cachemodified)
+	{
+		hash_cache_misses++;
+		return FALSE;
+	}
+
+	hash_data_copy(file->hash, entry->hash);
+	hash_cache_hits++;
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    hash_cache_store - remember the hash of a file
+    whose full contents have been hashed
+-------------------------------------------------*/
+
+static void hash_cache_store(mame_file *file)
+{
+	hash_cache_entry **entryptr;
+	hash_cache_entry *entry;
+
+	/* only files with a key that we can stat can be cached */
+	if (!hash_cache_enabled || file->cachekey == NULL || !hash_cache_stat(file))
+		return;
+
+	/* replace any existing entry for this key */
+	entryptr = hash_cache_find(astring_c(file->cachekey));
+	entry = *entryptr;
+	if (entry == NULL)
+	{
+		entry = malloc_or_die(sizeof(*entry) + astring_len(file->cachekey));
+		entry->next = NULL;
+		strcpy(entry->key, astring_c(file->cachekey));
+		*entryptr = entry;
+	}
+	entry->size = file->cachesize;
+	entry->modified = file->cachemodified;
+	hash_data_copy(entry->hash, file->hash);
+	hash_cache_dirty = TRUE;
+}
+
+
+/*-------------------------------------------------
+    hash_cache_find - return a pointer to the
+    link that holds the entry for a key, or to
+    the NULL link at the end of its bucket
+-------------------------------------------------*/
+
+static hash_cache_entry **hash_cache_find(const char *key)
+{
+	hash_cache_entry **entryptr;
+	UINT32 hash = 0;
+	const char *src;
+
+	for (src = key; *src != 0; src++)
+		hash = hash * 31 + (UINT8)*src;
+
+	for (entryptr = &hash_cache[hash % HASH_CACHE_BUCKETS]; *entryptr != NULL; entryptr = &(*entryptr)->next)
+		if (strcmp((*entryptr)->key, key) == 0)
+			break;
+	return entryptr;
+}
+
+
+/*-------------------------------------------------
+    hash_cache_free - free all cache entries
+-------------------------------------------------*/
+
+static void hash_cache_free(void)
+{
+	int bucket;
+
+	for (bucket = 0; bucket < HASH_CACHE_BUCKETS; bucket++)
+		while (hash_cache[bucket] != NULL)
+		{
+			hash_cache_entry *entry = hash_cache[bucket];
+			hash_cache[bucket] = entry->next;
+			free(entry);
+		}
+	hash_cache_enabled = FALSE;
+	hash_cache_dirty = FALSE;
+}
+
+
 
 /***************************************************************************
     PATH ITERATION
@@ -801,7 +1168,7 @@ static file_error load_zipped_file(mame_file *file)
 		return FILERR_OUT_OF_MEMORY;
 
 	/* read the data into our buffer and return */
-	ziperr = zip_file_decompress(file->zipfile, file->zipdata, file->ziplength);
+	ziperr = zip_file_decompress_entry(file->zipfile, file->zipheader, file->zipdata, file->ziplength);
 	if (ziperr != ZIPERR_NONE)
 	{
 		free(file->zipdata);
@@ -821,19 +1188,6 @@ static file_error load_zipped_file(mame_file *file)
 	/* close out the ZIP file */
 	zip_file_close(file->zipfile);
 	file->zipfile = NULL;
+	file->zipheader = NULL;
 	return FILERR_NONE;
 }
-
-
-/*-------------------------------------------------
-    zip_filename_match - compare zip filename
-    to expected filename, ignoring any directory
--------------------------------------------------*/
-
-static int zip_filename_match(const zip_file_header *header, const astring *filename)
-{
-	const char *zipfile = header->filename + header->filename_length - astring_len(filename);
-
-	return (zipfile >= header->filename && astring_icmpc(filename, zipfile) == 0 &&
-		(zipfile == header->filename || zipfile[-1] == '/'));
-}
@@ -130,6 +130,9 @@ int mame_ungetc(int c, mame_file *file);
 /* read a full line of text from the file */
 char *mame_fgets(char *s, int n, mame_file *file);
 
+/* read the entire file into a buffer, decompressing ZIPped files in place */
+UINT32 mame_fload(mame_file *file, void *buffer, UINT32 length);
+
 
 
 /* ----- file write ----- */
@@ -163,8 +166,27 @@ void mame_closepath(mame_path *path);
 /* return the core_file underneath the mame_file */
 core_file *mame_core_file(mame_file *file);
 
+/* return the full path of a file opened directly, or NULL for a file inside a ZIP */
+const char *mame_file_full_name(mame_file *file);
+
 /* return a hash string for the file with the given functions */
 const char *mame_fhash(mame_file *file, UINT32 functions);
 
+/* return TRUE if mame_fhash can return the given functions without reading the file */
+int mame_fhash_cached(mame_file *file, UINT32 functions);
+
+/* supply a hash computed by the caller over the full file contents */
+void mame_fhash_update(mame_file *file, const char *hash);
+
+
+
+/* ----- hash cache ----- */
+
+/* load the hashes verified on earlier runs */
+void mame_hash_cache_load(core_options *opts);
+
+/* save any newly verified hashes and free the cache */
+void mame_hash_cache_save(void);
+
 
 #endif	/* __FILEIO_H__ */
@@ -135,6 +135,15 @@
 #define FALSE   0
 #endif
 
+/* per-call state for the hash functions, so hashes can be computed concurrently */
+typedef union _hash_context hash_context;
+union _hash_context
+{
+	UINT32 crc;
+	struct sha1_ctx sha1;
+	struct MD5Context md5;
+};
+
 struct _hash_function_desc
 {
 	const char* name;           // human-readable name
@@ -142,24 +151,24 @@ struct _hash_function_desc
 	unsigned int size;          // checksum size in bytes
 
 	// Functions used to calculate the hash of a memory block
-	void (*calculate_begin)(void);
-	void (*calculate_buffer)(const void* mem, unsigned long len);
-	void (*calculate_end)(UINT8* bin_chksum);
+	void (*calculate_begin)(hash_context* ctx);
+	void (*calculate_buffer)(hash_context* ctx, const void* mem, unsigned long len);
+	void (*calculate_end)(hash_context* ctx, UINT8* bin_chksum);
 
 };
 typedef struct _hash_function_desc hash_function_desc;
 
-static void h_crc_begin(void);
-static void h_crc_buffer(const void* mem, unsigned long len);
-static void h_crc_end(UINT8* chksum);
+static void h_crc_begin(hash_context* ctx);
+static void h_crc_buffer(hash_context* ctx, const void* mem, unsigned long len);
+static void h_crc_end(hash_context* ctx, UINT8* chksum);
 
-static void h_sha1_begin(void);
-static void h_sha1_buffer(const void* mem, unsigned long len);
-static void h_sha1_end(UINT8* chksum);
+static void h_sha1_begin(hash_context* ctx);
+static void h_sha1_buffer(hash_context* ctx, const void* mem, unsigned long len);
+static void h_sha1_end(hash_context* ctx, UINT8* chksum);
 
-static void h_md5_begin(void);
-static void h_md5_buffer(const void* mem, unsigned long len);
-static void h_md5_end(UINT8* chksum);
+static void h_md5_begin(hash_context* ctx);
+static void h_md5_buffer(hash_context* ctx, const void* mem, unsigned long len);
+static void h_md5_end(hash_context* ctx, UINT8* chksum);
 
 static const hash_function_desc hash_descs[HASH_NUM_FUNCTIONS] =
 {
@@ -553,11 +562,12 @@ void hash_compute(char* dst, const unsigned char* data, unsigned long length, un
 		if (functions & func)
 		{
 			const hash_function_desc* desc = hash_get_function_desc(func);
+			hash_context ctx;
 			UINT8 chksum[256];
 
-			desc->calculate_begin();
-			desc->calculate_buffer(data, length);
-			desc->calculate_end(chksum);
+			desc->calculate_begin(&ctx);
+			desc->calculate_buffer(&ctx, data, length);
+			desc->calculate_end(&ctx, chksum);
 
 			dst += hash_data_add_binary_checksum(dst, func, chksum);
 		}
@@ -655,59 +665,53 @@ int hash_verify_string(const char *hash)
     Hash functions - Wrappers
  *********************************************************************/
 
-static UINT32 crc;
-
-static void h_crc_begin(void)
+static void h_crc_begin(hash_context* ctx)
 {
-	crc = 0;
+	ctx->crc = 0;
 }
 
-static void h_crc_buffer(const void* mem, unsigned long len)
+static void h_crc_buffer(hash_context* ctx, const void* mem, unsigned long len)
 {
-	crc = crc32(crc, (UINT8*)mem, len);
+	ctx->crc = crc32(ctx->crc, (UINT8*)mem, len);
 }
 
-static void h_crc_end(UINT8* bin_chksum)
+static void h_crc_end(hash_context* ctx, UINT8* bin_chksum)
 {
-	bin_chksum[0] = (UINT8)(crc >> 24);
-	bin_chksum[1] = (UINT8)(crc >> 16);
-	bin_chksum[2] = (UINT8)(crc >> 8);
-	bin_chksum[3] = (UINT8)(crc >> 0);
+	bin_chksum[0] = (UINT8)(ctx->crc >> 24);
+	bin_chksum[1] = (UINT8)(ctx->crc >> 16);
+	bin_chksum[2] = (UINT8)(ctx->crc >> 8);
+	bin_chksum[3] = (UINT8)(ctx->crc >> 0);
 }
 
 
-static struct sha1_ctx sha1ctx;
-
-static void h_sha1_begin(void)
+static void h_sha1_begin(hash_context* ctx)
 {
-	sha1_init(&sha1ctx);
+	sha1_init(&ctx->sha1);
 }
 
-static void h_sha1_buffer(const void* mem, unsigned long len)
+static void h_sha1_buffer(hash_context* ctx, const void* mem, unsigned long len)
 {
-	sha1_update(&sha1ctx, len, (UINT8*)mem);
+	sha1_update(&ctx->sha1, len, (UINT8*)mem);
 }
 
-static void h_sha1_end(UINT8* bin_chksum)
+static void h_sha1_end(hash_context* ctx, UINT8* bin_chksum)
 {
-	sha1_final(&sha1ctx);
-	sha1_digest(&sha1ctx, 20, bin_chksum);
+	sha1_final(&ctx->sha1);
+	sha1_digest(&ctx->sha1, 20, bin_chksum);
 }
 
 
-static struct MD5Context md5_ctx;
-
-static void h_md5_begin(void)
+static void h_md5_begin(hash_context* ctx)
 {
-	MD5Init(&md5_ctx);
+	MD5Init(&ctx->md5);
 }
 
-static void h_md5_buffer(const void* mem, unsigned long len)
+static void h_md5_buffer(hash_context* ctx, const void* mem, unsigned long len)
 {
-	MD5Update(&md5_ctx, (md5byte*)mem, len);
+	MD5Update(&ctx->md5, (md5byte*)mem, len);
 }
 
-static void h_md5_end(UINT8* bin_chksum)
+static void h_md5_end(hash_context* ctx, UINT8* bin_chksum)
 {
-	MD5Final(bin_chksum, &md5_ctx);
+	MD5Final(bin_chksum, &ctx->md5);
 }
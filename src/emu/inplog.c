@@ -0,0 +1,736 @@
+/***************************************************************************
+
+    inplog.c
+
+    Compact, seekable input recordings.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    A compact recording logs the same sequence of port values as a
+    classic INP file, but only spends bytes on the values that change.
+    Each value is either equal to the last value logged for its port or
+    not, so the log is a series of pairs:
+
+        run     varint   number of values equal to their port's last value
+        change  varint   XOR of the next value against its port's last value
+
+    A real change is never 0, so a pair with a change of 0 ends the run
+    of pairs and is followed by a chunk, identified by a single byte:
+
+        'K'     a keyframe; the log resumes after it
+        'E'     the end of the recording
+
+    Keyframe chunk:
+
+        frame    4 bytes    input frame at which the state was taken
+        values   32*4       last value logged for each port
+        rawsize  4 bytes    size of the machine state
+        zsize    4 bytes    size of the deflated machine state
+        data     zsize      deflated machine state
+
+    The index follows the end chunk. It has one entry for each keyframe
+    interval, giving the frame and file offset of the keyframe taken
+    during that interval, or an offset of 0 if none could be taken:
+
+        count    4 bytes    number of entries
+        frame    4 bytes    \ repeated count times
+        offset   8 bytes    /
+
+    Finding the keyframe for frame N is a matter of looking at entry
+    N / interval, stepping back over any empty entries.
+
+    Header (40 bytes):
+
+        0x00     8 bytes    "MAMEINPC"
+        0x08     4 bytes    format version
+        0x0c     4 bytes    frames between keyframes (0 = none)
+        0x10     8 bytes    offset of the index (0 = unfinished recording)
+        0x18     16 bytes   game name, NUL padded
+
+    All multi-byte values are little-endian. The machine state inside a
+    keyframe is a raw in-memory snapshot in the byte order of the host
+    that recorded it, so keyframes only load on a host with the same
+    byte order.
+
+***************************************************************************/
+
+#include "driver.h"
+#include "inplog.h"
+#include <zlib.h>
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define INPLOG_SIGNATURE		"MAMEINPC"
+#define INPLOG_VERSION			1
+
+#define HEADER_SIZE				0x28
+#define HEADER_INDEX_OFFSET		0x10
+
+#define CHUNK_KEYFRAME			'K'
+#define CHUNK_END				'E'
+
+#define BUFFER_SIZE				4096
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+typedef struct _keyframe_entry keyframe_entry;
+struct _keyframe_entry
+{
+	UINT32				frame;				/* input frame of the keyframe */
+	UINT64				offset;				/* file offset of its chunk, or 0 */
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+/* I/O buffering */
+static UINT8			buffer[BUFFER_SIZE];
+static UINT32			bufpos;				/* next byte to read or write */
+static UINT32			buflen;				/* valid bytes when reading */
+static UINT64			bufoffset;			/* file offset of the start of the buffer */
+
+/* log state */
+static UINT32			last[MAX_INPUT_PORTS];
+static UINT32			run;				/* values left in (reading) or added to (writing) the current run */
+static UINT32			change;				/* pending change when reading */
+static UINT8			ended;
+
+/* keyframes */
+static UINT32			interval;
+static keyframe_entry *	entries;
+static UINT32			entry_count;
+static UINT32			next_keyframe;
+static UINT8 *			state;
+static UINT32			state_alloc;
+static UINT8 *			zstate;
+static UINT32			zstate_alloc;
+
+/* seeking */
+static UINT64			seek_offset;
+static UINT32			start_frame;
+static UINT8			start_reported;
+
+/* instrumentation */
+static UINT32			stat_keyframes;
+static UINT64			stat_keyframe_bytes;
+
+
+
+/***************************************************************************
+    INLINE FUNCTIONS
+***************************************************************************/
+
+/*-------------------------------------------------
+    put_varint - write a variable-length value
+-------------------------------------------------*/
+
+INLINE UINT8 *put_varint(UINT8 *dest, UINT32 value)
+{
+	while (value >= 0x80)
+	{
+		*dest++ = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	*dest++ = value;
+	return dest;
+}
+
+
+/*-------------------------------------------------
+    put_u32/get_u32 - little-endian helpers
+-------------------------------------------------*/
+
+INLINE void put_u32(UINT8 *dest, UINT32 value)
+{
+	dest[0] = value;
+	dest[1] = value >> 8;
+	dest[2] = value >> 16;
+	dest[3] = value >> 24;
+}
+
+INLINE UINT32 get_u32(const UINT8 *src)
+{
+	return src[0] | (src[1] << 8) | (src[2] << 16) | ((UINT32)src[3] << 24);
+}
+
+
+
+/***************************************************************************
+    BUFFERED I/O
+***************************************************************************/
+
+/*-------------------------------------------------
+    flush_output - write out anything buffered
+-------------------------------------------------*/
+
+static int flush_output(mame_file *file)
+{
+	UINT32 length = bufpos;
+
+	bufoffset += bufpos;
+	bufpos = 0;
+	return (length == 0 || mame_fwrite(file, buffer, length) == length);
+}
+
+
+/*-------------------------------------------------
+    write_bytes - append data to the output
+-------------------------------------------------*/
+
+static int write_bytes(mame_file *file, const void *data, UINT32 length)
+{
+	/* small writes are gathered in the buffer */
+	if (bufpos + length <= BUFFER_SIZE)
+	{
+		memcpy(&buffer[bufpos], data, length);
+		bufpos += length;
+		return TRUE;
+	}
+
+	/* anything else goes straight out behind what is buffered */
+	if (!flush_output(file))
+		return FALSE;
+	bufoffset += length;
+	return (mame_fwrite(file, data, length) == length);
+}
+
+
+/*-------------------------------------------------
+    write_pair - append a run/change pair
+-------------------------------------------------*/
+
+static int write_pair(mame_file *file, UINT32 runlength, UINT32 delta)
+{
+	UINT8 temp[10];
+	return write_bytes(file, temp, put_varint(put_varint(temp, runlength), delta) - temp);
+}
+
+
+/*-------------------------------------------------
+    read_position - return the file offset of the
+    next byte to be read
+-------------------------------------------------*/
+
+INLINE UINT64 read_position(void)
+{
+	return bufoffset + bufpos;
+}
+
+
+/*-------------------------------------------------
+    read_seek - move the read position
+-------------------------------------------------*/
+
+static void read_seek(mame_file *file, UINT64 offset)
+{
+	mame_fseek(file, offset, SEEK_SET);
+	bufoffset = offset;
+	bufpos = buflen = 0;
+}
+
+
+/*-------------------------------------------------
+    read_bytes - read data from the input; returns
+    FALSE if the file ends first
+-------------------------------------------------*/
+
+static int read_bytes(mame_file *file, void *data, UINT32 length)
+{
+	UINT8 *dest = data;
+
+	while (length > 0)
+	{
+		UINT32 chunk;
+
+		/* refill the buffer when we run out */
+		if (bufpos == buflen)
+		{
+			bufoffset += buflen;
+			bufpos = 0;
+			buflen = mame_fread(file, buffer, BUFFER_SIZE);
+			if (buflen == 0)
+				return FALSE;
+		}
+
+		chunk = MIN(length, buflen - bufpos);
+		memcpy(dest, &buffer[bufpos], chunk);
+		bufpos += chunk;
+		dest += chunk;
+		length -= chunk;
+	}
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    read_varint - read a variable-length value
+-------------------------------------------------*/
+
+static int read_varint(mame_file *file, UINT32 *value)
+{
+	UINT32 result = 0;
+	int shift;
+
+	for (shift = 0; shift < 35; shift += 7)
+	{
+		UINT8 byte;
+
+		if (!read_bytes(file, &byte, 1))
+			return FALSE;
+		result |= (UINT32)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+		{
+			*value = result;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+/*-------------------------------------------------
+    read_pair - read the next run/change pair,
+    ending playback if there is none
+-------------------------------------------------*/
+
+static void read_pair(mame_file *file)
+{
+	if (!read_varint(file, &run) || !read_varint(file, &change))
+		ended = TRUE;
+}
+
+
+
+/***************************************************************************
+    COMMON
+***************************************************************************/
+
+/*-------------------------------------------------
+    inplog_check - return TRUE if the file holds
+    a compact recording
+-------------------------------------------------*/
+
+int inplog_check(mame_file *file)
+{
+	char check[8];
+	int result;
+
+	result = (mame_fread(file, check, sizeof(check)) == sizeof(check) && memcmp(check, INPLOG_SIGNATURE, sizeof(check)) == 0);
+	mame_fseek(file, 0, SEEK_SET);
+	return result;
+}
+
+
+/*-------------------------------------------------
+    inplog_reset - reset the log state
+-------------------------------------------------*/
+
+static void inplog_reset(void)
+{
+	bufpos = buflen = 0;
+	bufoffset = 0;
+	memset(last, 0, sizeof(last));
+	run = change = 0;
+	ended = FALSE;
+	entry_count = 0;
+	next_keyframe = 0;
+	seek_offset = 0;
+	start_frame = 0;
+	start_reported = FALSE;
+	stat_keyframes = 0;
+	stat_keyframe_bytes = 0;
+}
+
+
+/*-------------------------------------------------
+    inplog_exit - free everything
+-------------------------------------------------*/
+
+void inplog_exit(void)
+{
+	if (entries != NULL)
+		free(entries);
+	if (state != NULL)
+		free(state);
+	if (zstate != NULL)
+		free(zstate);
+	entries = NULL;
+	state = zstate = NULL;
+	entry_count = state_alloc = zstate_alloc = 0;
+}
+
+
+/*-------------------------------------------------
+    ensure_state_buffers - make room for a state
+    of the given size and its deflated form
+-------------------------------------------------*/
+
+static void ensure_state_buffers(UINT32 size)
+{
+	UINT32 zsize = compressBound(size);
+
+	if (state_alloc < size)
+	{
+		if (state != NULL)
+			free(state);
+		state = malloc_or_die(size);
+		state_alloc = size;
+	}
+	if (zstate_alloc < zsize)
+	{
+		if (zstate != NULL)
+			free(zstate);
+		zstate = malloc_or_die(zsize);
+		zstate_alloc = zsize;
+	}
+}
+
+
+
+/***************************************************************************
+    RECORDING
+***************************************************************************/
+
+/*-------------------------------------------------
+    inplog_record_begin - start a new recording
+-------------------------------------------------*/
+
+void inplog_record_begin(running_machine *machine, mame_file *file, UINT32 keyframe_interval)
+{
+	UINT8 header[HEADER_SIZE];
+
+	inplog_reset();
+
+	/* keyframes are save states, so they need a game that supports them */
+	interval = (machine->gamedrv->flags & GAME_SUPPORTS_SAVE) ? keyframe_interval : 0;
+
+	/* the index offset is filled in once the recording is finished */
+	memset(header, 0, sizeof(header));
+	memcpy(&header[0x00], INPLOG_SIGNATURE, 8);
+	put_u32(&header[0x08], INPLOG_VERSION);
+	put_u32(&header[0x0c], interval);
+	strncpy((char *)&header[0x18], machine->gamedrv->name, 15);
+	write_bytes(file, header, sizeof(header));
+}
+
+
+/*-------------------------------------------------
+    inplog_record_value - log a port value
+-------------------------------------------------*/
+
+int inplog_record_value(mame_file *file, int portnum, UINT32 value)
+{
+	/* unchanged values just extend the run */
+	if (value == last[portnum])
+	{
+		run++;
+		return TRUE;
+	}
+
+	/* a change ends it */
+	if (!write_pair(file, run, value ^ last[portnum]))
+		return FALSE;
+	last[portnum] = value;
+	run = 0;
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    inplog_record_frame - take a keyframe if one
+    is due
+-------------------------------------------------*/
+
+int inplog_record_frame(running_machine *machine, mame_file *file, UINT32 frame)
+{
+	UINT8 chunk[1 + 4 + 4 * MAX_INPUT_PORTS + 4 + 4];
+	UINT32 size, slot, portnum;
+	uLongf zsize;
+
+	if (interval == 0 || frame < next_keyframe)
+		return TRUE;
+
+	/* try again next frame if the state can't be saved right now */
+	size = mame_get_state_size(machine);
+	ensure_state_buffers(size);
+	if (mame_save_state_memory(machine, state, size) != 0)
+		return TRUE;
+
+	/* keyframes are written deflated, but a failure there just costs us this one */
+	zsize = zstate_alloc;
+	if (compress2(zstate, &zsize, state, size, Z_BEST_SPEED) != Z_OK)
+		return TRUE;
+
+	/* end the run of pairs */
+	if (!write_pair(file, run, 0))
+		return FALSE;
+	run = 0;
+
+	/* note the keyframe in the index, leaving empty entries for any intervals without one */
+	slot = frame / interval;
+	if (slot >= entry_count)
+	{
+		keyframe_entry *newentries = malloc_or_die((slot + 1) * sizeof(*newentries));
+		if (entries != NULL)
+		{
+			memcpy(newentries, entries, entry_count * sizeof(*newentries));
+			free(entries);
+		}
+		memset(&newentries[entry_count], 0, (slot + 1 - entry_count) * sizeof(*newentries));
+		entries = newentries;
+		entry_count = slot + 1;
+	}
+	entries[slot].frame = frame;
+	entries[slot].offset = bufoffset + bufpos;
+	next_keyframe = (slot + 1) * interval;
+
+	/* write the chunk */
+	chunk[0] = CHUNK_KEYFRAME;
+	put_u32(&chunk[1], frame);
+	for (portnum = 0; portnum < MAX_INPUT_PORTS; portnum++)
+		put_u32(&chunk[5 + 4 * portnum], last[portnum]);
+	put_u32(&chunk[5 + 4 * MAX_INPUT_PORTS], size);
+	put_u32(&chunk[9 + 4 * MAX_INPUT_PORTS], zsize);
+	if (!write_bytes(file, chunk, sizeof(chunk)) || !write_bytes(file, zstate, zsize))
+		return FALSE;
+
+	stat_keyframes++;
+	stat_keyframe_bytes += sizeof(chunk) + zsize;
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    inplog_record_end - finish the recording and
+    write its index
+-------------------------------------------------*/
+
+void inplog_record_end(mame_file *file)
+{
+	UINT8 temp[12];
+	UINT64 indexoffset;
+	UINT32 entrynum;
+	int success;
+
+	/* end the log */
+	temp[0] = CHUNK_END;
+	success = write_pair(file, run, 0) && write_bytes(file, temp, 1);
+
+	/* append the index */
+	indexoffset = bufoffset + bufpos;
+	put_u32(&temp[0], entry_count);
+	success = success && write_bytes(file, temp, 4);
+	for (entrynum = 0; entrynum < entry_count; entrynum++)
+	{
+		put_u32(&temp[0], entries[entrynum].frame);
+		put_u32(&temp[4], entries[entrynum].offset);
+		put_u32(&temp[8], entries[entrynum].offset >> 32);
+		success = success && write_bytes(file, temp, 12);
+	}
+	success = success && flush_output(file);
+
+	/* only a complete index is advertised in the header */
+	if (success)
+	{
+		put_u32(&temp[0], indexoffset);
+		put_u32(&temp[4], indexoffset >> 32);
+		mame_fseek(file, HEADER_INDEX_OFFSET, SEEK_SET);
+		mame_fwrite(file, temp, 8);
+	}
+
+	logerror("Input log: %u bytes, %u keyframes totalling %u bytes\n", (UINT32)indexoffset, stat_keyframes, (UINT32)stat_keyframe_bytes);
+}
+
+
+
+/***************************************************************************
+    PLAYBACK
+***************************************************************************/
+
+/*-------------------------------------------------
+    find_keyframe - return the offset of the last
+    keyframe at or before the given frame, or 0
+-------------------------------------------------*/
+
+static UINT64 find_keyframe(mame_file *file, UINT64 indexoffset, UINT32 frame)
+{
+	UINT8 temp[12];
+	UINT32 count;
+	INT32 slot;
+
+	read_seek(file, indexoffset);
+	if (!read_bytes(file, temp, 4))
+		return 0;
+	count = get_u32(temp);
+	if (count == 0)
+		return 0;
+
+	/* start at the entry covering the frame, stepping back over empty or later ones */
+	for (slot = MIN(frame / interval, count - 1); slot >= 0; slot--)
+	{
+		read_seek(file, indexoffset + 4 + (UINT64)slot * 12);
+		if (!read_bytes(file, temp, 12))
+			return 0;
+		if ((temp[4] | temp[5] | temp[6] | temp[7] | temp[8] | temp[9] | temp[10] | temp[11]) != 0 && get_u32(&temp[0]) <= frame)
+			return get_u32(&temp[4]) | ((UINT64)get_u32(&temp[8]) << 32);
+	}
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    inplog_playback_begin - start playing back a
+    compact recording
+-------------------------------------------------*/
+
+void inplog_playback_begin(running_machine *machine, mame_file *file, UINT32 startframe)
+{
+	UINT8 header[HEADER_SIZE];
+	UINT64 indexoffset;
+	char name[16];
+
+	inplog_reset();
+
+	/* read and verify the header */
+	if (!read_bytes(file, header, sizeof(header)))
+		fatalerror("Input file is truncated\n");
+	if (get_u32(&header[0x08]) != INPLOG_VERSION)
+		fatalerror("Input file is an unsupported version of the compact format\n");
+	memcpy(name, &header[0x18], sizeof(name));
+	name[sizeof(name) - 1] = 0;
+	if (strcmp(machine->gamedrv->name, name) != 0)
+		fatalerror("Input file is for " GAMENOUN " '%s', not for current " GAMENOUN " '%s'\n", name, machine->gamedrv->name);
+	interval = get_u32(&header[0x0c]);
+	indexoffset = get_u32(&header[0x10]) | ((UINT64)get_u32(&header[0x14]) << 32);
+	mame_printf_info("Playing back previously recorded " GAMENOUN " %s\n", machine->gamedrv->name);
+
+	/* look up where to start, if not at the beginning */
+	start_frame = startframe;
+	if (startframe != 0)
+	{
+		if (interval != 0 && indexoffset != 0)
+			seek_offset = find_keyframe(file, indexoffset, startframe);
+		if (seek_offset == 0)
+			mame_printf_warning("No keyframe found before frame %u; playing back from the start\n", startframe);
+	}
+
+	/* prime the first pair */
+	read_seek(file, HEADER_SIZE);
+	read_pair(file);
+}
+
+
+/*-------------------------------------------------
+    inplog_playback_value - return the next port
+    value
+-------------------------------------------------*/
+
+int inplog_playback_value(mame_file *file, int portnum, UINT32 *value)
+{
+	UINT8 chunk[4 * MAX_INPUT_PORTS + 12];
+
+	while (!ended)
+	{
+		/* values within a run are unchanged */
+		if (run > 0)
+		{
+			run--;
+			*value = last[portnum];
+			return TRUE;
+		}
+
+		/* the value that ends it is a change */
+		if (change != 0)
+		{
+			last[portnum] ^= change;
+			*value = last[portnum];
+			read_pair(file);
+			return TRUE;
+		}
+
+		/* otherwise a chunk follows; skip over keyframes and stop at anything else */
+		if (!read_bytes(file, chunk, 1) || chunk[0] != CHUNK_KEYFRAME || !read_bytes(file, chunk, sizeof(chunk)))
+			break;
+		read_seek(file, read_position() + get_u32(&chunk[4 * MAX_INPUT_PORTS + 8]));
+		read_pair(file);
+	}
+
+	ended = TRUE;
+	return FALSE;
+}
+
+
+/*-------------------------------------------------
+    inplog_playback_frame - perform a pending
+    seek between timeslices
+-------------------------------------------------*/
+
+int inplog_playback_frame(running_machine *machine, mame_file *file, UINT32 *frame, UINT32 *values)
+{
+	UINT8 chunk[1 + 4 + 4 * MAX_INPUT_PORTS + 4 + 4];
+	UINT32 size, zsize, portnum;
+	UINT64 resume;
+	uLongf destlen;
+
+	/* let the benchmark harness know when measurements can start */
+	if (start_frame != 0 && !start_reported && *frame >= start_frame)
+	{
+		mame_printf_info("Playback reached frame %u\n", *frame);
+		start_reported = TRUE;
+	}
+	if (seek_offset == 0)
+		return FALSE;
+
+	/* read the keyframe, remembering where we were in case it can't be loaded yet */
+	resume = read_position();
+	read_seek(file, seek_offset);
+	if (!read_bytes(file, chunk, sizeof(chunk)) || chunk[0] != CHUNK_KEYFRAME)
+		goto cancel;
+	size = get_u32(&chunk[5 + 4 * MAX_INPUT_PORTS]);
+	zsize = get_u32(&chunk[9 + 4 * MAX_INPUT_PORTS]);
+	if (size != mame_get_state_size(machine))
+	{
+		mame_printf_warning("Keyframe does not match this version of the " GAMENOUN "; playing back from the start\n");
+		goto cancel;
+	}
+	ensure_state_buffers(size);
+	destlen = size;
+	if (zsize > zstate_alloc || !read_bytes(file, zstate, zsize) || uncompress(state, &destlen, zstate, zsize) != Z_OK || destlen != size)
+		goto cancel;
+
+	/* try again next frame if the state can't be loaded right now */
+	if (mame_load_state_memory(machine, state, size) != 0)
+	{
+		read_seek(file, resume);
+		return FALSE;
+	}
+
+	/* pick up the log right after the keyframe, with the port values in effect when it was taken */
+	for (portnum = 0; portnum < MAX_INPUT_PORTS; portnum++)
+		values[portnum] = last[portnum] = get_u32(&chunk[5 + 4 * portnum]);
+	*frame = get_u32(&chunk[1]);
+	ended = FALSE;
+	read_pair(file);
+	seek_offset = 0;
+	mame_printf_info("Playback resumed from keyframe at frame %u\n", *frame);
+	return TRUE;
+
+cancel:
+	read_seek(file, resume);
+	seek_offset = 0;
+	return FALSE;
+}
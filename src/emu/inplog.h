@@ -0,0 +1,58 @@
+/***************************************************************************
+
+    inplog.h
+
+    Compact, seekable input recordings.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#pragma once
+
+#ifndef __INPLOG_H__
+#define __INPLOG_H__
+
+#include "mamecore.h"
+#include "fileio.h"
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+/* return TRUE if the file is a compact recording; leaves the file at its start */
+int inplog_check(mame_file *file);
+
+/* free everything at exit */
+void inplog_exit(void);
+
+
+/* ----- recording ----- */
+
+/* write the header of a new recording with a keyframe every so many frames (0 = none) */
+void inplog_record_begin(running_machine *machine, mame_file *file, UINT32 interval);
+
+/* log the next port value; returns 0 on a write error */
+int inplog_record_value(mame_file *file, int portnum, UINT32 value);
+
+/* called between timeslices once a frame to take a keyframe when one is due; returns 0 on a write error */
+int inplog_record_frame(running_machine *machine, mame_file *file, UINT32 frame);
+
+/* finish the recording and write its index */
+void inplog_record_end(mame_file *file);
+
+
+/* ----- playback ----- */
+
+/* read the header and index, and arrange to seek to the keyframe nearest startframe */
+void inplog_playback_begin(running_machine *machine, mame_file *file, UINT32 startframe);
+
+/* read the next port value; returns 0 at the end of the recording */
+int inplog_playback_value(mame_file *file, int portnum, UINT32 *value);
+
+/* called between timeslices once a frame; performs a pending seek, returning TRUE with the new frame and port values if it did */
+int inplog_playback_frame(running_machine *machine, mame_file *file, UINT32 *frame, UINT32 *values);
+
+#endif	/* __INPLOG_H__ */
@@ -97,6 +97,7 @@
 #include "xmlfile.h"
 #include "profiler.h"
 #include "inputseq.h"
+#include "inplog.h"
 #include "ui.h"
 #include <math.h>
 #include <ctype.h>
@@ -279,6 +280,13 @@ static int no_extended_inp;
 static int framecount;
 static double totalspeed;
 
+/* set to 1 if the INP file being played or recorded is in the compact format */
+static int compact_playback;
+static int compact_record;
+
+/* number of VBLANKs seen, for keyframes in compact INP files */
+static UINT32 inp_frame;
+
 
 /***************************************************************************
     PORT HANDLER TABLES
@@ -1005,6 +1013,7 @@ static const input_port_default_entry default_ports_builtin[] =
 	INPUT_PORT_DIGITAL_DEF( 0, IPG_UI,      UI_EDIT_CHEAT,       "Edit Cheat",			SEQ_DEF_1(KEYCODE_E) )
 	INPUT_PORT_DIGITAL_DEF( 0, IPG_UI,      UI_RELOAD_CHEAT,     "Reload Database",		SEQ_DEF_1(KEYCODE_L) )
 	INPUT_PORT_DIGITAL_DEF( 0, IPG_UI,      UI_TOGGLE_CROSSHAIR, "Toggle Crosshair",	SEQ_DEF_1(KEYCODE_F1) )
+	INPUT_PORT_DIGITAL_DEF( 0, IPG_UI,      UI_REWIND,           "Rewind",				SEQ_DEF_1(KEYCODE_BACKSLASH) )
 
 	INPUT_PORT_DIGITAL_DEF( 0, IPG_UI,      OSD_1,				NULL,					SEQ_DEF_0 )
 	INPUT_PORT_DIGITAL_DEF( 0, IPG_UI,      OSD_2,				NULL,					SEQ_DEF_0 )
@@ -1044,6 +1053,8 @@ static int default_ports_lookup[__ipt_max][MAX_PLAYERS];
 
 static void setup_playback(running_machine *machine);
 static void setup_record(running_machine *machine);
+static void input_port_frame(running_machine *machine);
+static void input_port_keyframe(running_machine *machine);
 static void input_port_exit(running_machine *machine);
 static void input_port_load(int config_type, xml_data_node *parentnode);
 static void input_port_save(int config_type, xml_data_node *parentnode);
@@ -1141,8 +1152,14 @@ void input_port_init(running_machine *machine, const input_port_token *ipt)
 	config_register("input", input_port_load, input_port_save);
 
 	/* open playback and record files if specified */
+	compact_playback = compact_record = FALSE;
+	inp_frame = 0;
 	setup_playback(machine);
 	setup_record(machine);
+
+	/* compact INP files do their keyframe work between timeslices */
+	if (compact_playback || compact_record)
+		add_frame_callback(machine, input_port_frame);
 }
 
 
@@ -1169,6 +1186,15 @@ static void setup_playback(running_machine *machine)
 	filerr = mame_fopen(SEARCHPATH_INPUTLOG, filename, OPEN_FLAG_READ, &machine->playback_file);
 	assert_always(filerr == FILERR_NONE, "Failed to open file for playback");
 
+	/* compact INP files have their own header */
+	if (inplog_check(machine->playback_file))
+	{
+		compact_playback = TRUE;
+		no_extended_inp = 1;
+		inplog_playback_begin(machine, machine->playback_file, options_get_int(mame_options(), OPTION_PLAYBACK_START));
+		return;
+	}
+
 	// read first four bytes to check INP type
 	mame_fread(Machine->playback_file, check, 7);
 	mame_fseek(Machine->playback_file, 0, SEEK_SET);
@@ -1236,6 +1262,14 @@ static void setup_record(running_machine *machine)
 	filerr = mame_fopen(SEARCHPATH_INPUTLOG, filename, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &machine->record_file);
 	assert_always(filerr == FILERR_NONE, "Failed to open file for recording");
 
+	/* compact INP files have their own header */
+	if (options_get_bool(mame_options(), OPTION_COMPACT_INP))
+	{
+		compact_record = TRUE;
+		inplog_record_begin(machine, machine->record_file, options_get_int(mame_options(), OPTION_INP_KEYFRAMES));
+		return;
+	}
+
 	/* create a header */
 	memset(&inpheader, 0, sizeof(inpheader));
 	strcpy(inpheader.name, machine->gamedrv->name);
@@ -1252,11 +1286,60 @@ static void setup_record(running_machine *machine)
 
 void input_port_exit(running_machine *machine)
 {
-	/* close any playback or recording files */
+	/* close any playback or recording files, finishing off compact recordings */
 	if (machine->playback_file != NULL)
 		mame_fclose(machine->playback_file);
 	if (machine->record_file != NULL)
+	{
+		if (compact_record)
+			inplog_record_end(machine->record_file);
+		mame_fclose(machine->record_file);
+	}
+	inplog_exit();
+}
+
+
+
+/*************************************
+ *
+ *  Input port frame callback
+ *
+ *************************************/
+
+static void input_port_frame(running_machine *machine)
+{
+	/* only act while running */
+	if (mame_get_phase(machine) != MAME_PHASE_RUNNING || mame_is_paused(machine))
+		return;
+
+	/* we are inside the VBLANK timer here, where the state can't be saved or loaded;
+	   if a user save or load is pending, the keyframe work waits for the next frame */
+	mame_schedule_state_callback(machine, input_port_keyframe);
+}
+
+
+/*************************************
+ *
+ *  Input port keyframe callback
+ *
+ *************************************/
+
+static void input_port_keyframe(running_machine *machine)
+{
+	UINT32 values[MAX_INPUT_PORTS];
+	int portnum;
+
+	/* take a keyframe if one is due; a failure stops recording like any other */
+	if (machine->record_file != NULL && compact_record && !inplog_record_frame(machine, machine->record_file, inp_frame))
+	{
 		mame_fclose(machine->record_file);
+		machine->record_file = NULL;
+	}
+
+	/* a seek restores the port values that were in effect along with the machine */
+	if (machine->playback_file != NULL && compact_playback && inplog_playback_frame(machine, machine->playback_file, &inp_frame, values))
+		for (portnum = 0; portnum < MAX_INPUT_PORTS; portnum++)
+			port_info[portnum].playback = values[portnum];
 }
 
 
@@ -2779,10 +2862,20 @@ static void update_playback_record(int portnum, UINT32 portvalue)
 	if (Machine->playback_file != NULL)
 	{
 		UINT32 result;
+		int success;
+
+		/* compact files decode straight to the value */
+		if (compact_playback)
+			success = inplog_playback_value(Machine->playback_file, portnum, &result);
+		else
+		{
+			success = (mame_fread(Machine->playback_file, &result, sizeof(result)) == sizeof(result));
+			result = BIG_ENDIANIZE_INT32(result);
+		}
 
 		/* a successful read goes into the playback field which overrides everything else */
-		if (mame_fread(Machine->playback_file, &result, sizeof(result)) == sizeof(result))
-			portvalue = port_info[portnum].playback = BIG_ENDIANIZE_INT32(result);
+		if (success)
+			portvalue = port_info[portnum].playback = result;
 
 		/* a failure causes us to close the playback file and stop playback */
 		else
@@ -2803,13 +2896,16 @@ static void update_playback_record(int portnum, UINT32 portvalue)
 	if (Machine->record_file != NULL)
 	{
 		UINT32 result = BIG_ENDIANIZE_INT32(portvalue);
+		int success;
 
-		/* a successful write just works */
-		if (mame_fwrite(Machine->record_file, &result, sizeof(result)) == sizeof(result))
-			;
+		/* compact files only log changes */
+		if (compact_record)
+			success = inplog_record_value(Machine->record_file, portnum, portvalue);
+		else
+			success = (mame_fwrite(Machine->record_file, &result, sizeof(result)) == sizeof(result));
 
 		/* a failure causes us to close the record file and stop recording */
-		else
+		if (!success)
 		{
 			mame_fclose(Machine->record_file);
 			Machine->record_file = NULL;
@@ -3005,6 +3101,7 @@ profiler_mark(PROFILER_INPUT);
 		else
 			update_playback_record(portnum, readinputport(portnum));
 	}
+	inp_frame++;
 
 	/* store speed read from INP file, if extended INP */
 	if (Machine->playback_file != NULL && !no_extended_inp)
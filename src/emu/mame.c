@@ -79,6 +79,7 @@
 #include "driver.h"
 #include "config.h"
 #include "cheat.h"
+#include "rewind.h"
 #include "debugger.h"
 #include "profiler.h"
 #include "render.h"
@@ -100,6 +101,21 @@
 ***************************************************************************/
 
 #define MAX_MEMORY_REGIONS		32
+#define MAX_STATE_CALLBACKS		4
+
+/* startup phases timed for -verbose */
+enum
+{
+	STARTUP_VALIDITY,
+	STARTUP_INI,
+	STARTUP_CORE,
+	STARTUP_ROMS,
+	STARTUP_DRIVER,
+	STARTUP_HARDWARE,
+	STARTUP_SETTINGS,
+	STARTUP_SCREENS,
+	STARTUP_PHASES
+};
 
 
 
@@ -154,7 +170,10 @@ struct _mame_private
 
 	/* load/save */
 	void 			(*saveload_schedule_callback)(running_machine *);
+	void			(*state_callback[MAX_STATE_CALLBACKS])(running_machine *);	/* in-memory state work for handle_state_callback */
+	int				state_callbacks;	/* number of entries in state_callback */
 	attotime		saveload_schedule_time;
+	mame_file *		saveload_file;		/* file being prefetched for a pending load */
 
 	/* array of memory regions */
 	region_info		mem_region[MAX_MEMORY_REGIONS];
@@ -185,6 +204,21 @@ static core_options *mame_opts;
 /* started empty? */
 static UINT8 started_empty;
 
+/* startup timing */
+static osd_ticks_t startup_ticks[STARTUP_PHASES];
+static osd_ticks_t startup_last;
+static const char *const startup_phase_name[STARTUP_PHASES] =
+{
+	"validity",
+	"ini",
+	"core",
+	"roms",
+	"driver init",
+	"hardware start",
+	"cfg/nvram",
+	"screens"
+};
+
 /* output channels */
 static output_callback output_cb[OUTPUT_CHANNEL_COUNT];
 static void *output_cb_param[OUTPUT_CHANNEL_COUNT];
@@ -258,7 +292,7 @@ const char *const memory_region_names[REGION_MAX] =
     FUNCTION PROTOTYPES
 ***************************************************************************/
 
-extern int mame_validitychecks(const game_driver *driver);
+extern int mame_validitychecks_cached(core_options *options, const game_driver *driver);
 
 static int parse_ini_file(core_options *options, const char *name);
 
@@ -272,9 +306,17 @@ static void free_callback_list(callback_item **cb);
 static void saveload_init(running_machine *machine);
 static void handle_save(running_machine *machine);
 static void handle_load(running_machine *machine);
+static void handle_state_callback(running_machine *machine);
+static void save_all_tags(void);
+static void load_all_tags(void);
+static void saveload_close_file(mame_private *mame);
+static void saveload_frame(running_machine *machine);
 
 static void logfile_callback(running_machine *machine, const char *buffer);
 
+static void startup_mark(int phase);
+static void startup_report(void);
+
 
 
 /***************************************************************************
@@ -304,6 +346,10 @@ int mame_execute(core_options *options)
 		/* specify the mame_options */
 		mame_opts = options;
 
+		/* start timing the startup */
+		memset(startup_ticks, 0, sizeof(startup_ticks));
+		startup_last = osd_ticks();
+
 		/* convert the specified gamename to a driver */
 		gamename = core_filename_extract_base(astring_alloc(), options_get_string(mame_options(), OPTION_GAMENAME), TRUE);
 		driver = driver_get_name(astring_c(gamename));
@@ -317,14 +363,16 @@ int mame_execute(core_options *options)
 				started_empty = TRUE;
 		}
 
-		/* otherwise, perform validity checks before anything else */
-		else if (mame_validitychecks(driver) != 0)
+		/* otherwise, perform validity checks before anything else, unless this build already passed them */
+		else if (mame_validitychecks_cached(mame_options(), driver) != 0)
 			return MAMERR_FAILED_VALIDITY;
 		firstgame = FALSE;
+		startup_mark(STARTUP_VALIDITY);
 
 		/* parse any INI files as the first thing */
 		options_revert(mame_options(), OPTION_PRIORITY_INI);
 		mame_parse_ini_files(mame_options(), driver);
+		startup_mark(STARTUP_INI);
 
 		/* create the machine structure and driver */
 		machine = create_machine(driver);
@@ -367,10 +415,13 @@ int mame_execute(core_options *options)
 			/* load the configuration settings and NVRAM */
 			settingsloaded = config_load_settings();
 			nvram_load();
+			startup_mark(STARTUP_SETTINGS);
 
 			/* display the startup screens */
 			ui_display_startup_screens(firstrun, !settingsloaded);
 			firstrun = FALSE;
+			startup_mark(STARTUP_SCREENS);
+			startup_report();
 
 			/* start resource tracking; note that soft_reset assumes it can */
 			/* call end_resource_tracking followed by begin_resource_tracking */
@@ -681,6 +732,7 @@ void mame_schedule_save(running_machine *machine, const char *filename)
 	if (mame->saveload_pending_file != NULL)
 		astring_free(mame->saveload_pending_file);
 	mame->saveload_pending_file = astring_assemble_4(astring_alloc(), machine->basename, PATH_SEPARATOR, filename, ".sta");
+	saveload_close_file(mame);
 
 	/* note the start time and set a timer for the next timeslice to actually schedule it */
 	mame->saveload_schedule_callback = handle_save;
@@ -704,6 +756,13 @@ void mame_schedule_load(running_machine *machine, const char *filename)
 	if (mame->saveload_pending_file != NULL)
 		astring_free(mame->saveload_pending_file);
 	mame->saveload_pending_file = astring_assemble_4(astring_alloc(), machine->basename, PATH_SEPARATOR, filename, ".sta");
+	saveload_close_file(mame);
+
+	/* open the file now and read it in the background until the load can happen */
+	if (mame_fopen(SEARCHPATH_STATE, astring_c(mame->saveload_pending_file), OPEN_FLAG_READ, &mame->saveload_file) == FILERR_NONE)
+		state_save_load_prefetch(mame->saveload_file);
+	else
+		mame->saveload_file = NULL;
 
 	/* note the start time and set a timer for the next timeslice to actually schedule it */
 	mame->saveload_schedule_callback = handle_load;
@@ -714,6 +773,39 @@ void mame_schedule_load(running_machine *machine, const char *filename)
 }
 
 
+/*-------------------------------------------------
+    mame_schedule_state_callback - request a
+    callback between timeslices, where the state
+    can be saved to or loaded from memory;
+    returns FALSE if a save or load is pending
+-------------------------------------------------*/
+
+int mame_schedule_state_callback(running_machine *machine, void (*callback)(running_machine *))
+{
+	mame_private *mame = machine->mame_data;
+	int cbnum;
+
+	/* saves and loads requested by the user come first */
+	if (mame->saveload_schedule_callback != NULL && mame->saveload_schedule_callback != handle_state_callback)
+		return FALSE;
+
+	/* a user save or load may have replaced an earlier list */
+	if (mame->saveload_schedule_callback == NULL)
+		mame->state_callbacks = 0;
+
+	/* each callback runs once however often it asks */
+	for (cbnum = 0; cbnum < mame->state_callbacks; cbnum++)
+		if (mame->state_callback[cbnum] == callback)
+			return TRUE;
+	if (mame->state_callbacks == MAX_STATE_CALLBACKS)
+		return FALSE;
+
+	mame->state_callback[mame->state_callbacks++] = callback;
+	mame->saveload_schedule_callback = handle_state_callback;
+	return TRUE;
+}
+
+
 /*-------------------------------------------------
     mame_is_scheduled_event_pending - is a
     scheduled event pending?
@@ -1523,6 +1615,7 @@ static void init_machine(running_machine *machine)
 		time(&mame->base_time);
 	else
 		mame->base_time = 0;
+	startup_mark(STARTUP_CORE);
 
 	/* first load ROMs, then populate memory, and finally initialize CPUs */
 	/* these operations must proceed in this order */
@@ -1546,8 +1639,10 @@ static void init_machine(running_machine *machine)
 	/* this is where decryption is done and memory maps are altered */
 	/* so this location in the init order is important */
 	ui_set_startup_text("Initializing...", TRUE);
+	startup_mark(STARTUP_ROMS);
 	if (machine->gamedrv->driver_init != NULL)
 		(*machine->gamedrv->driver_init)(machine);
+	startup_mark(STARTUP_DRIVER);
 
 	/* start the video and audio hardware */
 	video_init(machine);
@@ -1565,8 +1660,10 @@ static void init_machine(running_machine *machine)
 
 	/* initialize miscellaneous systems */
 	saveload_init(machine);
+	rewind_init(machine);
 	if (options_get_bool(mame_options(), OPTION_CHEAT))
 		cheat_init(machine);
+	startup_mark(STARTUP_HARDWARE);
 }
 
 
@@ -1638,6 +1735,39 @@ static void free_callback_list(callback_item **cb)
 
 
 
+/*-------------------------------------------------
+    startup_mark - charge the time since the
+    last mark to the given startup phase
+-------------------------------------------------*/
+
+static void startup_mark(int phase)
+{
+	osd_ticks_t now = osd_ticks();
+	startup_ticks[phase] += now - startup_last;
+	startup_last = now;
+}
+
+
+/*-------------------------------------------------
+    startup_report - print the time taken by each
+    startup phase
+-------------------------------------------------*/
+
+static void startup_report(void)
+{
+	osd_ticks_t tps = osd_ticks_per_second();
+	osd_ticks_t total = 0;
+	int phase;
+
+	for (phase = 0; phase < STARTUP_PHASES; phase++)
+		total += startup_ticks[phase];
+	mame_printf_verbose("Startup took %.1f ms:", (double)total * 1000.0 / (double)tps);
+	for (phase = 0; phase < STARTUP_PHASES; phase++)
+		mame_printf_verbose(" %s %.1f%s", startup_phase_name[phase], (double)startup_ticks[phase] * 1000.0 / (double)tps, (phase == STARTUP_PHASES - 1) ? "\n" : ",");
+}
+
+
+
 /***************************************************************************
     SAVE/RESTORE
 ***************************************************************************/
@@ -1657,6 +1787,48 @@ static void saveload_init(running_machine *machine)
 	/* if we're in autosave mode, schedule a load */
 	else if (options_get_bool(mame_options(), OPTION_AUTOSAVE) && (machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
 		mame_schedule_load(machine, "auto");
+
+	/* saves finish in the background; report them when they do */
+	add_frame_callback(machine, saveload_frame);
+}
+
+
+/*-------------------------------------------------
+    saveload_frame - report saves that finished
+    writing in the background
+-------------------------------------------------*/
+
+static void saveload_frame(running_machine *machine)
+{
+	int failed;
+
+	if (!state_save_poll_save(&failed))
+		return;
+
+	/* pop a warning if the game doesn't support saves */
+	if (failed)
+		popmessage("Error: Failed to save state");
+	else if (!(machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
+		popmessage("State successfully saved.\nWarning: Save states are not officially supported for this game.");
+	else
+		popmessage("State successfully saved.");
+}
+
+
+/*-------------------------------------------------
+    saveload_close_file - close the file of a
+    pending load, once the prefetch is done
+    with it
+-------------------------------------------------*/
+
+static void saveload_close_file(mame_private *mame)
+{
+	if (mame->saveload_file != NULL)
+	{
+		state_save_flush();
+		mame_fclose(mame->saveload_file);
+		mame->saveload_file = NULL;
+	}
 }
 
 
@@ -1693,8 +1865,6 @@ static void handle_save(running_machine *machine)
 	filerr = mame_fopen(SEARCHPATH_STATE, astring_c(mame->saveload_pending_file), OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &file);
 	if (filerr == FILERR_NONE)
 	{
-		int cpunum;
-
 		/* write the save state */
 		if (state_save_save_begin(file) != 0)
 		{
@@ -1703,36 +1873,11 @@ static void handle_save(running_machine *machine)
 			goto cancel;
 		}
 
-		/* write the default tag */
-		state_save_push_tag(0);
-		state_save_save_continue();
-		state_save_pop_tag();
-
-		/* loop over CPUs */
-		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-		{
-			cpuintrf_push_context(cpunum);
-
-			/* make sure banking is set */
-			activecpu_reset_banking();
+		/* write the default tag and the CPUs */
+		save_all_tags();
 
-			/* save the CPU data */
-			state_save_push_tag(cpunum + 1);
-			state_save_save_continue();
-			state_save_pop_tag();
-
-			cpuintrf_pop_context();
-		}
-
-		/* finish and close */
+		/* finish; the file is compressed, written and closed in the background */
 		state_save_save_finish();
-		mame_fclose(file);
-
-		/* pop a warning if the game doesn't support saves */
-		if (!(machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
-			popmessage("State successfully saved.\nWarning: Save states are not officially supported for this game.");
-		else
-			popmessage("State successfully saved.");
 	}
 	else
 		popmessage("Error: Failed to save state");
@@ -1752,8 +1897,6 @@ cancel:
 static void handle_load(running_machine *machine)
 {
 	mame_private *mame = machine->mame_data;
-	file_error filerr;
-	mame_file *file;
 
 	/* if no name, bail */
 	if (mame->saveload_pending_file == NULL)
@@ -1775,38 +1918,14 @@ static void handle_load(running_machine *machine)
 		return;
 	}
 
-	/* open the file */
-	filerr = mame_fopen(SEARCHPATH_STATE, astring_c(mame->saveload_pending_file), OPEN_FLAG_READ, &file);
-	if (filerr == FILERR_NONE)
+	/* the file was opened and its prefetch started when the load was scheduled */
+	if (mame->saveload_file != NULL)
 	{
 		/* start loading */
-		if (state_save_load_begin(file) == 0)
+		if (state_save_load_begin(mame->saveload_file) == 0)
 		{
-			int cpunum;
-
-			/* read tag 0 */
-			state_save_push_tag(0);
-			state_save_load_continue();
-			state_save_pop_tag();
-
-			/* loop over CPUs */
-			for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-			{
-				cpuintrf_push_context(cpunum);
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				/* load the CPU data */
-				state_save_push_tag(cpunum + 1);
-				state_save_load_continue();
-				state_save_pop_tag();
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				cpuintrf_pop_context();
-			}
+			/* read the default tag and the CPUs */
+			load_all_tags();
 
 			/* finish and close */
 			state_save_load_finish();
@@ -1814,19 +1933,159 @@ static void handle_load(running_machine *machine)
 		}
 		else
 			popmessage("Error: Failed to load state");
-		mame_fclose(file);
 	}
 	else
 		popmessage("Error: Failed to load state");
 
 cancel:
 	/* unschedule the load */
+	saveload_close_file(mame);
 	astring_free(mame->saveload_pending_file);
 	mame->saveload_pending_file = NULL;
 	mame->saveload_schedule_callback = NULL;
 }
 
 
+/*-------------------------------------------------
+    handle_state_callback - run the callbacks
+    requested by mame_schedule_state_callback,
+    in the order they asked
+-------------------------------------------------*/
+
+static void handle_state_callback(running_machine *machine)
+{
+	mame_private *mame = machine->mame_data;
+	void (*callback[MAX_STATE_CALLBACKS])(running_machine *);
+	int cbnum, count = mame->state_callbacks;
+
+	/* unschedule first, so that the callbacks can schedule themselves again */
+	memcpy(callback, mame->state_callback, count * sizeof(callback[0]));
+	mame->state_callbacks = 0;
+	mame->saveload_schedule_callback = NULL;
+	for (cbnum = 0; cbnum < count; cbnum++)
+		(*callback[cbnum])(machine);
+}
+
+
+/*-------------------------------------------------
+    save_all_tags - save the default tag and
+    then each CPU in its own context
+-------------------------------------------------*/
+
+static void save_all_tags(void)
+{
+	int cpunum;
+
+	/* write the default tag */
+	state_save_push_tag(0);
+	state_save_save_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* save the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_save_continue();
+		state_save_pop_tag();
+
+		cpuintrf_pop_context();
+	}
+}
+
+
+/*-------------------------------------------------
+    load_all_tags - load the default tag and
+    then each CPU in its own context
+-------------------------------------------------*/
+
+static void load_all_tags(void)
+{
+	int cpunum;
+
+	/* read tag 0 */
+	state_save_push_tag(0);
+	state_save_load_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* load the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_load_continue();
+		state_save_pop_tag();
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		cpuintrf_pop_context();
+	}
+}
+
+
+/*-------------------------------------------------
+    mame_get_state_size - return the size of the
+    buffer needed by mame_save_state_memory
+-------------------------------------------------*/
+
+UINT32 mame_get_state_size(running_machine *machine)
+{
+	return state_save_get_size();
+}
+
+
+/*-------------------------------------------------
+    mame_save_state_memory - snapshot the whole
+    machine into a caller-provided buffer right
+    away; returns 0 on success, or non-zero if
+    the state can't be saved at this time
+-------------------------------------------------*/
+
+int mame_save_state_memory(running_machine *machine, void *buffer, UINT32 length)
+{
+	/* anonymous timers can't be saved; the caller may retry later */
+	if (timer_count_anonymous() > 0)
+		return 1;
+
+	if (state_save_save_begin_memory(buffer, length) != 0)
+		return 1;
+	save_all_tags();
+	state_save_save_finish();
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    mame_load_state_memory - restore the whole
+    machine from a buffer filled by
+    mame_save_state_memory; returns 0 on success
+-------------------------------------------------*/
+
+int mame_load_state_memory(running_machine *machine, const void *buffer, UINT32 length)
+{
+	/* anonymous timers might overwrite the data we load */
+	if (timer_count_anonymous() > 0)
+		return 1;
+
+	if (state_save_load_begin_memory(buffer, length) != 0)
+		return 1;
+	load_all_tags();
+	state_save_load_finish();
+	return 0;
+}
+
+
 
 /***************************************************************************
     SYSTEM TIME
@@ -253,6 +253,7 @@ extern const char mame_disclaimer[];
 extern char giant_string_buffer[];
 
 extern char build_version[];
+extern const char build_id[];
 
 
 
@@ -309,6 +310,18 @@ void mame_schedule_save(running_machine *machine, const char *filename);
 /* schedule a load */
 void mame_schedule_load(running_machine *machine, const char *filename);
 
+/* schedule a callback between timeslices for in-memory state work; returns FALSE if a save or load is pending or too many are queued */
+int mame_schedule_state_callback(running_machine *machine, void (*callback)(running_machine *));
+
+/* size of the buffer needed for an in-memory state snapshot */
+UINT32 mame_get_state_size(running_machine *machine);
+
+/* snapshot the state into memory immediately; returns 0 on success */
+int mame_save_state_memory(running_machine *machine, void *buffer, UINT32 length);
+
+/* restore the state from a memory snapshot immediately; returns 0 on success */
+int mame_load_state_memory(running_machine *machine, const void *buffer, UINT32 length);
+
 /* is a scheduled event pending? */
 int mame_is_scheduled_event_pending(running_machine *machine);
 
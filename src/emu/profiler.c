@@ -127,6 +127,7 @@ const char *profiler_get_text(void)
 		"Callbck",
 		"Input  ",
 		"Movie  ",
+		"Rewind ",
 		"Logerr ",
 		"Extra  ",
 		"User1  ",
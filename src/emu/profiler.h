@@ -41,6 +41,7 @@ enum
 	PROFILER_TIMER_CALLBACK,
 	PROFILER_INPUT,		/* input.c and inptport.c */
 	PROFILER_MOVIE_REC,	/* movie recording */
+	PROFILER_REWIND,	/* rewind snapshots */
 	PROFILER_LOGERROR,	/* logerror */
 	PROFILER_EXTRA,		/* everything else */
 
@@ -52,7 +52,6 @@
     CONSTANTS
 ***************************************************************************/
 
-#define MAX_TEXTURE_SCALES		8
 #define TEXTURE_GROUP_SIZE		256
 
 #define NUM_PRIMLISTS			2
@@ -121,6 +120,10 @@ struct _object_transform
 /* a scaled_texture contains a single scaled entry for a texture */
 struct _scaled_texture
 {
+	scaled_texture *	next;				/* next scaled entry for the same texture */
+	scaled_texture *	lruprev;			/* previous entry in the global LRU list */
+	scaled_texture *	lrunext;			/* next entry in the global LRU list */
+	render_texture *	texture;			/* texture we were scaled from */
 	mame_bitmap *		bitmap;				/* final bitmap */
 	UINT32				seqid;				/* sequence number */
 };
@@ -137,8 +140,9 @@ struct _render_texture
 	int					format;				/* format of the texture data */
 	texture_scaler		scaler;				/* scaling callback */
 	void *				param;				/* scaling callback parameter */
-	UINT32				curseq;				/* current sequence number */
-	scaled_texture		scaled[MAX_TEXTURE_SCALES];	/* array of scaled variants of this texture */
+	UINT32				curseq;				/* sequence number of the unscaled source, 0 if stale */
+	UINT32				lookupseq;			/* lookup_seqid at the time curseq was assigned */
+	scaled_texture *	scaledlist;			/* list of scaled variants of this texture */
 };
 
 
@@ -163,6 +167,7 @@ struct _render_target
 	int					base_layerconfig;	/* the layer configuration at the time of first frame */
 	int					maxtexwidth;		/* maximum width of a texture */
 	int					maxtexheight;		/* maximum height of a texture */
+	UINT64				lastsignature;		/* signature of the last primitive list */
 };
 
 
@@ -220,6 +225,16 @@ static container_item *container_item_free_list;
 static render_ref *render_ref_free_list;
 static render_texture *render_texture_free_list;
 
+/* scaled texture cache, most recently used first */
+static scaled_texture *scaled_lru_head;
+static scaled_texture *scaled_lru_tail;
+static UINT64 scaled_cache_bytes;
+static UINT64 scaled_cache_budget;
+
+/* sequence numbers for textures and for palette/brightness lookups */
+static UINT32 texture_seqid;
+static UINT32 lookup_seqid;
+
 /* containers for the UI and for screens */
 static render_container *ui_container;
 static render_container *screen_container[MAX_SCREENS];
@@ -259,11 +274,13 @@ static int load_layout_files(render_target *target, const char *layoutfile, int
 static void add_container_primitives(render_target *target, render_primitive_list *list, const object_transform *xform, render_container *container, int blendmode);
 static void add_element_primitives(render_target *target, render_primitive_list *list, const object_transform *xform, const layout_element *element, int state, int blendmode);
 static void add_clear_and_optimize_primitive_list(render_target *target, render_primitive_list *list);
+static UINT64 compute_primitive_signature(render_target *target, const render_primitive_list *list);
 
 /* render references */
 static void invalidate_all_render_ref(void *refptr);
 
 /* render textures */
+static void scaled_texture_free(scaled_texture *scaled);
 static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UINT32 dheight, render_texinfo *texinfo, render_ref **reflist);
 
 /* render containers */
@@ -486,6 +503,11 @@ void render_init(running_machine *machine)
 	ui_target = NULL;
 	memset(screen_container, 0, sizeof(screen_container));
 
+	/* set up the scaled texture cache */
+	scaled_lru_head = scaled_lru_tail = NULL;
+	scaled_cache_bytes = 0;
+	scaled_cache_budget = (UINT64)options_get_int(mame_options(), OPTION_SCALECACHE) * 1024;
+
 	/* create a UI container */
 	ui_container = render_container_alloc();
 
@@ -564,6 +586,10 @@ static void render_exit(running_machine *machine)
 	while (targetlist != NULL)
 		render_target_free(targetlist);
 
+	/* free any scaled textures still held by live textures */
+	while (scaled_lru_head != NULL)
+		scaled_texture_free(scaled_lru_head);
+
 	/* free the screen overlay */
 	if (screen_overlay != NULL)
 		bitmap_free(screen_overlay);
@@ -1556,6 +1582,11 @@ const render_primitive_list *render_target_get_primitives(render_target *target)
 
 	/* optimize the list before handing it off */
 	add_clear_and_optimize_primitive_list(target, &target->primlist[listnum]);
+
+	/* compare against the previous list so the OSD can skip redrawing identical frames */
+	target->primlist[listnum].signature = compute_primitive_signature(target, &target->primlist[listnum]);
+	target->primlist[listnum].unchanged = (target->primlist[listnum].signature == target->lastsignature);
+	target->lastsignature = target->primlist[listnum].signature;
 	osd_lock_release(target->primlist[listnum].lock);
 	return &target->primlist[listnum];
 }
@@ -2213,6 +2244,36 @@ done:
 
 
 
+/*-------------------------------------------------
+    compute_primitive_signature - compute a hash
+    over everything that determines how a
+    primitive list is drawn
+-------------------------------------------------*/
+
+static UINT64 compute_primitive_signature(render_target *target, const render_primitive_list *list)
+{
+	UINT64 hash = U64(0xcbf29ce484222325);
+	const render_primitive *prim;
+
+	/* start with the target size and the state of the palette lookups */
+	hash = (hash ^ (UINT32)target->width) * U64(0x100000001b3);
+	hash = (hash ^ (UINT32)target->height) * U64(0x100000001b3);
+	hash = (hash ^ lookup_seqid) * U64(0x100000001b3);
+
+	/* FNV-1a over each primitive; primitives are zeroed on allocation, so the padding is stable */
+	for (prim = list->head; prim != NULL; prim = prim->next)
+	{
+		const UINT8 *data = (const UINT8 *)&prim->type;
+		const UINT8 *end = (const UINT8 *)(prim + 1);
+
+		while (data < end)
+			hash = (hash ^ *data++) * U64(0x100000001b3);
+	}
+	return hash;
+}
+
+
+
 /***************************************************************************
     RENDER REFERENCES
 ***************************************************************************/
@@ -2291,15 +2352,10 @@ render_texture *render_texture_alloc(texture_scaler scaler, void *param)
 void render_texture_free(render_texture *texture)
 {
 	render_texture *base_save;
-	int scalenum;
 
 	/* free all scaled versions */
-	for (scalenum = 0; scalenum < ARRAY_LENGTH(texture->scaled); scalenum++)
-		if (texture->scaled[scalenum].bitmap != NULL)
-		{
-			invalidate_all_render_ref(texture->scaled[scalenum].bitmap);
-			bitmap_free(texture->scaled[scalenum].bitmap);
-		}
+	while (texture->scaledlist != NULL)
+		scaled_texture_free(texture->scaledlist);
 
 	/* invalidate references to the original bitmap as well */
 	if (texture->bitmap != NULL)
@@ -2321,8 +2377,6 @@ void render_texture_free(render_texture *texture)
 
 void render_texture_set_bitmap(render_texture *texture, mame_bitmap *bitmap, const rectangle *sbounds, UINT32 palettebase, int format)
 {
-	int scalenum;
-
 	/* invalidate references to the old bitmap */
 	if (bitmap != texture->bitmap && texture->bitmap != NULL)
 		invalidate_all_render_ref(texture->bitmap);
@@ -2336,16 +2390,104 @@ void render_texture_set_bitmap(render_texture *texture, mame_bitmap *bitmap, con
 	texture->palettebase = palettebase;
 	texture->format = format;
 
-	/* invalidate all scaled versions */
-	for (scalenum = 0; scalenum < ARRAY_LENGTH(texture->scaled); scalenum++)
-	{
-		if (texture->scaled[scalenum].bitmap != NULL)
+	/* the source is new; anything scaled from the old one is now stale */
+	texture->curseq = 0;
+	while (texture->scaledlist != NULL)
+		scaled_texture_free(texture->scaledlist);
+}
+
+
+/*-------------------------------------------------
+    scaled_bitmap_bytes - return the number of
+    bytes a scaled bitmap is charged against the
+    cache budget
+-------------------------------------------------*/
+
+INLINE UINT64 scaled_bitmap_bytes(const mame_bitmap *bitmap)
+{
+	return (UINT64)bitmap->rowpixels * bitmap->height * (bitmap->bpp / 8);
+}
+
+
+/*-------------------------------------------------
+    scaled_texture_free - release a scaled entry
+    and unlink it from its texture and the LRU
+-------------------------------------------------*/
+
+static void scaled_texture_free(scaled_texture *scaled)
+{
+	render_texture *texture = scaled->texture;
+	scaled_texture **scaled_ptr;
+	mame_bitmap *bitmap = scaled->bitmap;
+
+	/* unlink from the texture's list */
+	for (scaled_ptr = &texture->scaledlist; *scaled_ptr != NULL; scaled_ptr = &(*scaled_ptr)->next)
+		if (*scaled_ptr == scaled)
 		{
-			invalidate_all_render_ref(texture->scaled[scalenum].bitmap);
-			bitmap_free(texture->scaled[scalenum].bitmap);
+			*scaled_ptr = scaled->next;
+			break;
 		}
-		texture->scaled[scalenum].bitmap = NULL;
-		texture->scaled[scalenum].seqid = 0;
+
+	/* unlink from the LRU */
+	if (scaled->lruprev != NULL)
+		scaled->lruprev->lrunext = scaled->lrunext;
+	else
+		scaled_lru_head = scaled->lrunext;
+	if (scaled->lrunext != NULL)
+		scaled->lrunext->lruprev = scaled->lruprev;
+	else
+		scaled_lru_tail = scaled->lruprev;
+
+	/* release the bitmap and anything that references it */
+	scaled_cache_bytes -= scaled_bitmap_bytes(bitmap);
+	invalidate_all_render_ref(bitmap);
+	bitmap_free(bitmap);
+	free(scaled);
+}
+
+
+/*-------------------------------------------------
+    scaled_texture_touch - move a scaled entry to
+    the front of the LRU
+-------------------------------------------------*/
+
+INLINE void scaled_texture_touch(scaled_texture *scaled)
+{
+	if (scaled == scaled_lru_head)
+		return;
+
+	/* unlink */
+	scaled->lruprev->lrunext = scaled->lrunext;
+	if (scaled->lrunext != NULL)
+		scaled->lrunext->lruprev = scaled->lruprev;
+	else
+		scaled_lru_tail = scaled->lruprev;
+
+	/* relink at the head */
+	scaled->lruprev = NULL;
+	scaled->lrunext = scaled_lru_head;
+	scaled_lru_head->lruprev = scaled;
+	scaled_lru_head = scaled;
+}
+
+
+/*-------------------------------------------------
+    scaled_texture_evict - throw out least
+    recently used entries until the given number
+    of bytes fits within the budget; entries used
+    by the list being built are kept
+-------------------------------------------------*/
+
+static void scaled_texture_evict(UINT64 needed, render_ref *reflist)
+{
+	scaled_texture *scaled = scaled_lru_tail;
+
+	while (scaled != NULL && scaled_cache_bytes + needed > scaled_cache_budget)
+	{
+		scaled_texture *prev = scaled->lruprev;
+		if (!has_render_ref(reflist, scaled->bitmap))
+			scaled_texture_free(scaled);
+		scaled = prev;
 	}
 }
 
@@ -2359,9 +2501,8 @@ static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UIN
 {
 	UINT8 bpp = (texture->format == TEXFORMAT_PALETTE16 || texture->format == TEXFORMAT_PALETTEA16 || texture->format == TEXFORMAT_RGB15 || texture->format == TEXFORMAT_YUY16) ? 16 : 32;
 	const rgb_t *palbase = (texture->format == TEXFORMAT_PALETTE16 || texture->format == TEXFORMAT_PALETTEA16) ? palette_entry_list_adjusted(Machine->palette) + texture->palettebase : NULL;
-	scaled_texture *scaled = NULL;
+	scaled_texture *scaled;
 	int swidth, sheight;
-	int scalenum;
 
 	/* source width/height come from the source bounds */
 	swidth = texture->sbounds.max_x - texture->sbounds.min_x;
@@ -2374,6 +2515,13 @@ static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UIN
 	/* are we scaler-free? if so, just return the source bitmap */
 	if (texture->scaler == NULL || (texture->bitmap != NULL && swidth == dwidth && sheight == dheight))
 	{
+		/* the sequence number only changes when the source or the lookups it is drawn through do */
+		if (texture->curseq == 0 || texture->lookupseq != lookup_seqid)
+		{
+			texture->curseq = ++texture_seqid;
+			texture->lookupseq = lookup_seqid;
+		}
+
 		/* add a reference and set up the source bitmap */
 		add_render_ref(reflist, texture->bitmap);
 		texinfo->base = (UINT8 *)texture->bitmap->base + (texture->sbounds.min_y * texture->bitmap->rowpixels + texture->sbounds.min_x) * (bpp / 8);
@@ -2381,46 +2529,44 @@ static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UIN
 		texinfo->width = swidth;
 		texinfo->height = sheight;
 		texinfo->palette = palbase;
-		texinfo->seqid = ++texture->curseq;
+		texinfo->seqid = texture->curseq;
 		return TRUE;
 	}
 
 	/* is it a size we already have? */
-	for (scalenum = 0; scalenum < ARRAY_LENGTH(texture->scaled); scalenum++)
-	{
-		scaled = &texture->scaled[scalenum];
-
-		/* we need a non-NULL bitmap with matching dest size */
-		if (scaled->bitmap != NULL && dwidth == scaled->bitmap->width && dheight == scaled->bitmap->height)
+	for (scaled = texture->scaledlist; scaled != NULL; scaled = scaled->next)
+		if (dwidth == scaled->bitmap->width && dheight == scaled->bitmap->height)
 			break;
-	}
 
 	/* did we get one? */
-	if (scalenum == ARRAY_LENGTH(texture->scaled))
+	if (scaled != NULL)
+		scaled_texture_touch(scaled);
+	else
 	{
-		int lowest = -1;
-
 		/* ask our notifier if we can scale now */
 		if (rescale_notify != NULL && !(*rescale_notify)(Machine, dwidth, dheight))
 			return FALSE;
 
-		/* didn't find one -- take the entry with the lowest seqnum */
-		for (scalenum = 0; scalenum < ARRAY_LENGTH(texture->scaled); scalenum++)
-			if ((lowest == -1 || texture->scaled[scalenum].seqid < texture->scaled[lowest].seqid) && !has_render_ref(*reflist, texture->scaled[scalenum].bitmap))
-				lowest = scalenum;
-		assert_always(lowest != -1, "Too many live texture instances!");
-
-		/* throw out any existing entries */
-		scaled = &texture->scaled[lowest];
-		if (scaled->bitmap != NULL)
-		{
-			invalidate_all_render_ref(scaled->bitmap);
-			bitmap_free(scaled->bitmap);
-		}
-
-		/* allocate a new bitmap */
+		/* allocate a new entry and bitmap */
+		scaled = malloc_or_die(sizeof(*scaled));
+		memset(scaled, 0, sizeof(*scaled));
+		scaled->texture = texture;
 		scaled->bitmap = bitmap_alloc(dwidth, dheight, BITMAP_FORMAT_ARGB32);
-		scaled->seqid = ++texture->curseq;
+		scaled->seqid = ++texture_seqid;
+
+		/* make room within the budget; this is a soft limit, so we always keep the new entry */
+		scaled_texture_evict(scaled_bitmap_bytes(scaled->bitmap), *reflist);
+		scaled_cache_bytes += scaled_bitmap_bytes(scaled->bitmap);
+
+		/* link it into the texture's list and the front of the LRU */
+		scaled->next = texture->scaledlist;
+		texture->scaledlist = scaled;
+		scaled->lrunext = scaled_lru_head;
+		if (scaled_lru_head != NULL)
+			scaled_lru_head->lruprev = scaled;
+		else
+			scaled_lru_tail = scaled;
+		scaled_lru_head = scaled;
 
 		/* let the scaler do the work */
 		(*texture->scaler)(scaled->bitmap, texture->bitmap, &texture->sbounds, texture->param);
@@ -2776,6 +2922,7 @@ void render_container_set_palette_alpha(render_container *container, UINT32 entr
 {
 	assert(entry < ARRAY_LENGTH(container->bcglookup));
 	container->bcglookup[entry] = (alpha << 24) | (container->bcglookup[entry] & 0x00ffffff);
+	lookup_seqid++;
 }
 
 
@@ -2895,6 +3042,9 @@ static void render_container_recompute_lookups(render_container *container)
 {
 	int i;
 
+	/* anything drawn through the old lookups needs to be redrawn */
+	lookup_seqid++;
+
 	/* recompute the 256 entry lookup table */
 	for (i = 0; i < 0x100; i++)
 	{
@@ -2958,6 +3108,9 @@ static void render_container_update_palette(render_container *container)
 		const pen_t *adjusted_palette = palette_entry_list_adjusted(palette);
 		UINT32 entry32, entry;
 
+		/* anything drawn through the old lookups needs to be redrawn */
+		lookup_seqid++;
+
 		/* loop over chunks of 32 entries, since we can quickly examine 32 at a time */
 		for (entry32 = mindirty / 32; entry32 <= maxdirty / 32; entry32++)
 		{
@@ -291,6 +291,8 @@ struct _render_primitive_list
 	render_primitive **	nextptr;			/* pointer to the next tail pointer */
 	osd_lock *			lock;				/* should only should be accessed under this lock */
 	render_ref *		reflist;			/* list of references */
+	UINT64				signature;			/* hash over the primitives, for change detection */
+	int					unchanged;			/* TRUE if identical to the previous list for this target */
 };
 
 
@@ -42,6 +42,11 @@
 #define NO_DEST_READ 0
 #endif
 
+/* set DEST_BIG_ENDIAN for 16bpp destinations stored big-endian */
+#if !defined(DEST_BIG_ENDIAN)
+#define DEST_BIG_ENDIAN 0
+#endif
+
 
 
 /***************************************************************************
@@ -56,6 +61,14 @@
 #include "render.h"
 #include <math.h>
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RENDERSW_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RENDERSW_SSE2
+#endif
+
 
 
 /***************************************************************************
@@ -70,6 +83,15 @@
 #define IS_OPAQUE(a)		(a >= (NO_DEST_READ ? 0.5f : 1.0f))
 #define IS_TRANSPARENT(a)	(a <  (NO_DEST_READ ? 0.5f : 0.0001f))
 
+/* texels gathered per pass by the span kernels */
+#define SPAN_CHUNK			64
+
+/* widest row that is kept for copying into vertically repeated rows */
+#define ROWCOPY_PIXELS		2048
+
+/* maximum number of horizontal bands rendered in parallel */
+#define MAX_BANDS			WORK_MAX_THREADS
+
 
 
 /***************************************************************************
@@ -86,6 +108,16 @@ struct _quad_setup_data
 };
 
 
+typedef struct _band_info band_info;
+struct _band_info
+{
+	const render_primitive *primlist;		/* primitives to draw */
+	void *			dstdata;				/* destination bitmap */
+	UINT32			width, height, pitch;	/* destination dimensions */
+	INT32			top, bottom;			/* rows [top, bottom) belong to this band */
+};
+
+
 
 /***************************************************************************
     GLOBAL VARIABLES
@@ -105,6 +137,18 @@ INLINE float round_nearest(float f)
 }
 
 
+INLINE void init_cosine_table(void)
+{
+	/* build up the cosine table if we haven't yet */
+	if (cosine_table[0] == 0)
+	{
+		int entry;
+		for (entry = 0; entry <= 2048; entry++)
+			cosine_table[entry] = (int)((double)(1.0 / cos(atan((double)(entry) / 2048.0))) * 0x10000000 + 0.5);
+	}
+}
+
+
 INLINE UINT32 ycc_to_rgb(UINT8 y, UINT8 cb, UINT8 cr)
 {
 	/* original equations:
@@ -146,6 +190,194 @@ INLINE UINT32 ycc_to_rgb(UINT8 y, UINT8 cb, UINT8 cr)
 	return MAKE_RGB(r, g, b);
 }
 
+
+
+/***************************************************************************
+    SPAN KERNELS
+***************************************************************************/
+
+/*
+    These work on 32bpp destinations laid out like the source (xRGB), for
+    rows where V does not change across the span. Each produces exactly
+    the same pixels as the per-pixel loop it replaces.
+*/
+
+/*-------------------------------------------------
+    span_double32 - write each of count source
+    pixels twice
+-------------------------------------------------*/
+
+INLINE void span_double32(UINT32 *dest, const UINT32 *src, int count)
+{
+#if defined(RENDERSW_NEON)
+	for ( ; count >= 4; count -= 4, src += 4, dest += 8)
+	{
+		uint32x4x2_t pair;
+		pair.val[0] = pair.val[1] = vld1q_u32(src);
+		vst2q_u32(dest, pair);
+	}
+#elif defined(RENDERSW_SSE2)
+	for ( ; count >= 4; count -= 4, src += 4, dest += 8)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)&dest[0], _mm_unpacklo_epi32(pix, pix));
+		_mm_storeu_si128((__m128i *)&dest[4], _mm_unpackhi_epi32(pix, pix));
+	}
+#endif
+	for ( ; count > 0; count--, src++, dest += 2)
+		dest[0] = dest[1] = *src;
+}
+
+
+/*-------------------------------------------------
+    span_fetch32 - fetch count texels from a row,
+    stepping U by dudx
+-------------------------------------------------*/
+
+INLINE void span_fetch32(UINT32 *dest, const UINT32 *srcrow, INT32 curu, INT32 dudx, int count)
+{
+	/* exact 2x: after at most one leading pixel, texels come in pairs */
+	if (dudx == 0x8000 && count > 2)
+	{
+		if ((curu >> 16) != ((curu + dudx) >> 16))
+		{
+			*dest++ = srcrow[curu >> 16];
+			curu += dudx;
+			count--;
+		}
+		span_double32(dest, &srcrow[curu >> 16], count / 2);
+		if (count & 1)
+			dest[count - 1] = srcrow[(curu + (count - 1) * dudx) >> 16];
+		return;
+	}
+
+	for ( ; count >= 4; count -= 4, dest += 4, curu += 4 * dudx)
+	{
+		dest[0] = srcrow[curu >> 16];
+		dest[1] = srcrow[(curu + dudx) >> 16];
+		dest[2] = srcrow[(curu + 2 * dudx) >> 16];
+		dest[3] = srcrow[(curu + 3 * dudx) >> 16];
+	}
+	for ( ; count > 0; count--, curu += dudx)
+		*dest++ = srcrow[curu >> 16];
+}
+
+
+/*-------------------------------------------------
+    span_fetch_palette16 - fetch count palettized
+    texels from a row, stepping U by dudx
+-------------------------------------------------*/
+
+INLINE void span_fetch_palette16(UINT32 *dest, const UINT16 *srcrow, const rgb_t *palbase, INT32 curu, INT32 dudx, int count)
+{
+	/* exact 2x: after at most one leading pixel, texels come in pairs */
+	if (dudx == 0x8000 && count > 2)
+	{
+		const UINT16 *src;
+
+		if ((curu >> 16) != ((curu + dudx) >> 16))
+		{
+			*dest++ = palbase[srcrow[curu >> 16]];
+			curu += dudx;
+			count--;
+		}
+		for (src = &srcrow[curu >> 16]; count >= 2; count -= 2, dest += 2)
+			dest[0] = dest[1] = palbase[*src++];
+		if (count)
+			*dest = palbase[*src];
+		return;
+	}
+
+	for ( ; count >= 4; count -= 4, dest += 4, curu += 4 * dudx)
+	{
+		dest[0] = palbase[srcrow[curu >> 16]];
+		dest[1] = palbase[srcrow[(curu + dudx) >> 16]];
+		dest[2] = palbase[srcrow[(curu + 2 * dudx) >> 16]];
+		dest[3] = palbase[srcrow[(curu + 3 * dudx) >> 16]];
+	}
+	for ( ; count > 0; count--, curu += dudx)
+		*dest++ = palbase[srcrow[curu >> 16]];
+}
+
+
+/*-------------------------------------------------
+    span_blend32 - alpha blend count ARGB source
+    pixels over the destination; fully
+    transparent ones leave it untouched
+-------------------------------------------------*/
+
+INLINE void span_blend32(UINT32 *dest, const UINT32 *src, int count)
+{
+#if defined(RENDERSW_NEON)
+	uint16x8_t full = vdupq_n_u16(0x100);
+
+	for ( ; count >= 4; count -= 4, src += 4, dest += 4)
+	{
+		uint32x4_t spix = vld1q_u32(src);
+		uint32x4_t dpix = vld1q_u32(dest);
+		uint32x4_t ta = vshrq_n_u32(spix, 24);
+		uint8x16_t ta8 = vreinterpretq_u8_u32(vmulq_n_u32(ta, 0x01010101));
+		uint16x8_t talo = vmovl_u8(vget_low_u8(ta8));
+		uint16x8_t tahi = vmovl_u8(vget_high_u8(ta8));
+		uint8x16_t s8 = vreinterpretq_u8_u32(spix);
+		uint8x16_t d8 = vreinterpretq_u8_u32(dpix);
+		uint16x8_t lo, hi;
+		uint32x4_t result;
+
+		/* s * ta + d * (256 - ta) tops out at 0xff00, so 16 bits are enough */
+		lo = vmulq_u16(vmovl_u8(vget_low_u8(s8)), talo);
+		lo = vmlaq_u16(lo, vmovl_u8(vget_low_u8(d8)), vsubq_u16(full, talo));
+		hi = vmulq_u16(vmovl_u8(vget_high_u8(s8)), tahi);
+		hi = vmlaq_u16(hi, vmovl_u8(vget_high_u8(d8)), vsubq_u16(full, tahi));
+		result = vreinterpretq_u32_u8(vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+		result = vandq_u32(result, vdupq_n_u32(0x00ffffff));
+
+		vst1q_u32(dest, vbslq_u32(vceqq_u32(ta, vdupq_n_u32(0)), dpix, result));
+	}
+#elif defined(RENDERSW_SSE2)
+	__m128i zero = _mm_setzero_si128();
+	__m128i rgbmask = _mm_set1_epi32(0x00ffffff);
+	__m128i full = _mm_set1_epi16(0x100);
+
+	for ( ; count >= 4; count -= 4, src += 4, dest += 4)
+	{
+		__m128i spix = _mm_loadu_si128((const __m128i *)src);
+		__m128i dpix = _mm_loadu_si128((const __m128i *)dest);
+		__m128i ta = _mm_srli_epi32(spix, 24);
+		__m128i ta16 = _mm_or_si128(ta, _mm_slli_epi32(ta, 16));
+		__m128i talo = _mm_unpacklo_epi32(ta16, ta16);
+		__m128i tahi = _mm_unpackhi_epi32(ta16, ta16);
+		__m128i lo, hi, result, keep;
+
+		/* s * ta + d * (256 - ta) tops out at 0xff00, so 16 bits are enough */
+		lo = _mm_mullo_epi16(_mm_unpacklo_epi8(spix, zero), talo);
+		lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(dpix, zero), _mm_sub_epi16(full, talo)));
+		hi = _mm_mullo_epi16(_mm_unpackhi_epi8(spix, zero), tahi);
+		hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(dpix, zero), _mm_sub_epi16(full, tahi)));
+		result = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+		result = _mm_and_si128(result, rgbmask);
+
+		keep = _mm_cmpeq_epi32(ta, zero);
+		result = _mm_or_si128(_mm_and_si128(keep, dpix), _mm_andnot_si128(keep, result));
+		_mm_storeu_si128((__m128i *)dest, result);
+	}
+#endif
+	for ( ; count > 0; count--, src++, dest++)
+	{
+		UINT32 pix = *src;
+		UINT32 ta = pix >> 24;
+		if (ta != 0)
+		{
+			UINT32 dpix = *dest;
+			UINT32 invta = 0x100 - ta;
+			UINT32 r = (((pix >> 16) & 0xff) * ta + ((dpix >> 16) & 0xff) * invta) >> 8;
+			UINT32 g = (((pix >> 8) & 0xff) * ta + ((dpix >> 8) & 0xff) * invta) >> 8;
+			UINT32 b = ((pix & 0xff) * ta + (dpix & 0xff) * invta) >> 8;
+			*dest = (r << 16) | (g << 8) | b;
+		}
+	}
+}
+
 #endif
 
 
@@ -194,6 +426,20 @@ INLINE UINT32 ycc_to_rgb(UINT8 y, UINT8 cb, UINT8 cr)
 #endif
 #endif
 
+/* convert between destination pixels in memory and in native byte order */
+#if DEST_BIG_ENDIAN
+#define DEST_PIXEL(pix)			BIG_ENDIANIZE_INT16(pix)
+#else
+#define DEST_PIXEL(pix)			(pix)
+#endif
+
+/* the span kernels need a 32bpp destination laid out like the source */
+#if !defined(VARIABLE_SHIFT) && !DEST_BIG_ENDIAN && (SRCSHIFT_R == 0) && (SRCSHIFT_G == 0) && (SRCSHIFT_B == 0) && (DSTSHIFT_R == 16) && (DSTSHIFT_G == 8) && (DSTSHIFT_B == 0)
+#define SPAN32				1
+#else
+#define SPAN32				0
+#endif
+
 
 
 /***************************************************************************
@@ -210,22 +456,23 @@ INLINE void FUNC_PREFIX(draw_aa_pixel)(void *dstdata, UINT32 pitch, int x, int y
 	PIXEL_TYPE *dest;
 
 	dest = (PIXEL_TYPE *)dstdata + y * pitch + x;
-	dpix = NO_DEST_READ ? 0 : *dest;
+	dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 	dr = SOURCE32_R(col) + DEST_R(dpix);
 	dg = SOURCE32_G(col) + DEST_G(dpix);
 	db = SOURCE32_B(col) + DEST_B(dpix);
 	dr = (dr | -(dr >> (8 - SRCSHIFT_R))) & (0xff >> SRCSHIFT_R);
 	dg = (dg | -(dg >> (8 - SRCSHIFT_G))) & (0xff >> SRCSHIFT_G);
 	db = (db | -(db >> (8 - SRCSHIFT_B))) & (0xff >> SRCSHIFT_B);
-	*dest = DEST_ASSEMBLE_RGB(dr, dg, db);
+	*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(dr, dg, db));
 }
 
 
 /*-------------------------------------------------
-    draw_line - draw a line or point
+    draw_line - draw a line or point, touching
+    only rows between top and bottom
 -------------------------------------------------*/
 
-static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, UINT32 pitch)
+static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata, INT32 width, INT32 top, INT32 bottom, UINT32 pitch)
 {
 	int dx,dy,sx,sy,cx,cy,bwidth;
 	UINT8 a1;
@@ -245,13 +492,7 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
 
 	if (PRIMFLAG_GET_ANTIALIAS(prim->flags))
 	{
-		/* build up the cosine table if we haven't yet */
-		if (cosine_table[0] == 0)
-		{
-			int entry;
-			for (entry = 0; entry <= 2048; entry++)
-				cosine_table[entry] = (int)((double)(1.0 / cos(atan((double)(entry) / 2048.0))) * 0x10000000 + 0.5);
-		}
+		init_cosine_table();
 
 		beam = prim->width * 65536.0f;
 		if (beam < 0x00010000)
@@ -277,7 +518,7 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
 				{
 					dx = bwidth;    /* init diameter of beam */
 					dy = y1 >> 16;
-					if (dy >= 0 && dy < height)
+					if (dy >= top && dy < bottom)
 						FUNC_PREFIX(draw_aa_pixel)(dstdata, pitch, x1, dy, Tinten(0xff & (~y1 >> 8), col));
 					dy++;
 					dx -= 0x10000 - (0xffff & y1); /* take off amount plotted */
@@ -285,11 +526,11 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
 					dx >>= 16;                   /* adjust to pixel (solid) count */
 					while (dx--)                 /* plot rest of pixels */
 					{
-						if (dy >= 0 && dy < height)
+						if (dy >= top && dy < bottom)
 							FUNC_PREFIX(draw_aa_pixel)(dstdata, pitch, x1, dy, col);
 						dy++;
 					}
-					if (dy >= 0 && dy < height)
+					if (dy >= top && dy < bottom)
 						FUNC_PREFIX(draw_aa_pixel)(dstdata, pitch, x1, dy, Tinten(a1,col));
 				}
 				if (x1 == xx) break;
@@ -309,7 +550,7 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
 			x1 -= bwidth >> 1; /* start back half the width */
 			for (;;)
 			{
-				if (y1 >= 0 && y1 < height)
+				if (y1 >= top && y1 < bottom)
 				{
 					dy = bwidth;    /* calc diameter of beam */
 					dx = x1 >> 16;
@@ -352,7 +593,7 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
 		{
 			for (;;)
 			{
-				if (x1 >= 0 && x1 < width && y1 >= 0 && y1 < height)
+				if (x1 >= 0 && x1 < width && y1 >= top && y1 < bottom)
 					FUNC_PREFIX(draw_aa_pixel)(dstdata, pitch, x1, y1, col);
 				if (x1 == x2) break;
 				x1 += sx;
@@ -368,7 +609,7 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
 		{
 			for (;;)
 			{
-				if (x1 >= 0 && x1 < width && y1 >= 0 && y1 < height)
+				if (x1 >= 0 && x1 < width && y1 >= top && y1 < bottom)
 					FUNC_PREFIX(draw_aa_pixel)(dstdata, pitch, x1, y1, col);
 				if (y1 == y2) break;
 				y1 += sy;
@@ -390,10 +631,11 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
 ***************************************************************************/
 
 /*-------------------------------------------------
-    draw_rect - draw a solid rectangle
+    draw_rect - draw a solid rectangle, touching
+    only rows between top and bottom
 -------------------------------------------------*/
 
-static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, UINT32 pitch)
+static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata, INT32 width, INT32 top, INT32 bottom, UINT32 pitch)
 {
 	render_bounds fpos = prim->bounds;
 	INT32 startx, starty, endx, endy;
@@ -413,10 +655,10 @@ static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata,
 	if (startx >= width) startx = width;
 	if (endx < 0) endx = 0;
 	if (endx >= width) endx = width;
-	if (starty < 0) starty = 0;
-	if (starty >= height) starty = height;
-	if (endy < 0) endy = 0;
-	if (endy >= height) endy = height;
+	if (starty < top) starty = top;
+	if (starty >= bottom) starty = bottom;
+	if (endy < top) endy = top;
+	if (endy >= bottom) endy = bottom;
 
 	/* bail if nothing left */
 	if (fpos.x0 > fpos.x1 || fpos.y0 > fpos.y1)
@@ -447,7 +689,7 @@ static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata,
 
 			/* loop over cols */
 			for (x = startx; x < endx; x++) {
-				*dest++ = pix;
+				*dest++ = DEST_PIXEL(pix);
 			}
 		}
 	}
@@ -482,11 +724,11 @@ static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata,
 			/* loop over cols */
 			for (x = startx; x < endx; x++)
 			{
-				UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+				UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 				UINT32 dr = (r + ((dpix & rmask) * inva)) & (rmask << 8);
 				UINT32 dg = (g + ((dpix & gmask) * inva)) & (gmask << 8);
 				UINT32 db = (b + ((dpix & bmask) * inva)) & (bmask << 8);
-				*dest++ = (dr | dg | db) >> 8;
+				*dest++ = DEST_PIXEL((dr | dg | db) >> 8);
 			}
 		}
 	}
@@ -519,21 +761,45 @@ static void FUNC_PREFIX(draw_quad_palette16_none)(const render_primitive *prim,
 	/* fast case: no coloring, no alpha */
 	if (prim->color.r >= 1.0f && prim->color.g >= 1.0f && prim->color.b >= 1.0f && IS_OPAQUE(prim->color.a))
 	{
+		PIXEL_TYPE rowbuf[ROWCOPY_PIXELS];
+		int rowcopy = dvdx == 0 && setup->dudy == 0 && setup->dvdy < 0x10000 && endx > setup->startx && endx - setup->startx <= ROWCOPY_PIXELS;
+		INT32 prevv = -1;
+
 		/* loop over rows */
 		for (y = setup->starty; y < setup->endy; y++)
 		{
-			PIXEL_TYPE *dest = (PIXEL_TYPE *)dstdata + y * pitch + setup->startx;
+			PIXEL_TYPE *target = (PIXEL_TYPE *)dstdata + y * pitch + setup->startx;
+			PIXEL_TYPE *dest = rowcopy ? rowbuf : target;
 			INT32 curu = setup->startu + (y - setup->starty) * setup->dudy;
 			INT32 curv = setup->startv + (y - setup->starty) * setup->dvdy;
 
-			/* loop over cols */
-			for (x = setup->startx; x < endx; x++)
+			/* a row sampling the same texels as the one above is a copy of it */
+			if (rowcopy && y > setup->starty && (curv >> 16) == prevv)
 			{
-				UINT32 pix = palbase[texbase[(curv >> 16) * texrp + (curu >> 16)]];
-				*dest++ = SOURCE32_TO_DEST(pix);
-				curu += dudx;
-				curv += dvdx;
+				memcpy(target, rowbuf, (endx - setup->startx) * sizeof(*target));
+				continue;
+			}
+			prevv = curv >> 16;
+
+#if SPAN32
+			if (dvdx == 0)
+				span_fetch_palette16((UINT32 *)dest, &texbase[(curv >> 16) * texrp], palbase, curu, dudx, endx - setup->startx);
+			else
+#endif
+			{
+				/* loop over cols */
+				for (x = setup->startx; x < endx; x++)
+				{
+					UINT32 pix = palbase[texbase[(curv >> 16) * texrp + (curu >> 16)]];
+					*dest++ = DEST_PIXEL(SOURCE32_TO_DEST(pix));
+					curu += dudx;
+					curv += dvdx;
+				}
 			}
+
+			/* rows are built in the row buffer, so the destination is never read back */
+			if (rowcopy)
+				memcpy(target, rowbuf, (endx - setup->startx) * sizeof(*target));
 		}
 	}
 
@@ -564,7 +830,7 @@ static void FUNC_PREFIX(draw_quad_palette16_none)(const render_primitive *prim,
 				UINT32 g = (SOURCE32_G(pix) * sg) >> 8;
 				UINT32 b = (SOURCE32_B(pix) * sb) >> 8;
 
-				*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+				*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 				curu += dudx;
 				curv += dvdx;
 			}
@@ -596,12 +862,12 @@ static void FUNC_PREFIX(draw_quad_palette16_none)(const render_primitive *prim,
 			for (x = setup->startx; x < endx; x++)
 			{
 				UINT32 pix = palbase[texbase[(curv >> 16) * texrp + (curu >> 16)]];
-				UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+				UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 				UINT32 r = (SOURCE32_R(pix) * sr + DEST_R(dpix) * invsa) >> 8;
 				UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 				UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-				*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+				*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 				curu += dudx;
 				curv += dvdx;
 			}
@@ -644,14 +910,14 @@ static void FUNC_PREFIX(draw_quad_palette16_add)(const render_primitive *prim, v
 				UINT32 pix = palbase[texbase[(curv >> 16) * texrp + (curu >> 16)]];
 				if ((pix & 0xffffff) != 0)
 				{
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = SOURCE32_R(pix) + DEST_R(dpix);
 					UINT32 g = SOURCE32_G(pix) + DEST_G(dpix);
 					UINT32 b = SOURCE32_B(pix) + DEST_B(dpix);
 					r = (r | -(r >> (8 - SRCSHIFT_R))) & (0xff >> SRCSHIFT_R);
 					g = (g | -(g >> (8 - SRCSHIFT_G))) & (0xff >> SRCSHIFT_G);
 					b = (b | -(b >> (8 - SRCSHIFT_B))) & (0xff >> SRCSHIFT_B);
-					*dest = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 				}
 				dest++;
 				curu += dudx;
@@ -685,14 +951,14 @@ static void FUNC_PREFIX(draw_quad_palette16_add)(const render_primitive *prim, v
 				UINT32 pix = palbase[texbase[(curv >> 16) * texrp + (curu >> 16)]];
 				if ((pix & 0xffffff) != 0)
 				{
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = ((SOURCE32_R(pix) * sr) >> 8) + DEST_R(dpix);
 					UINT32 g = ((SOURCE32_G(pix) * sg) >> 8) + DEST_G(dpix);
 					UINT32 b = ((SOURCE32_B(pix) * sb) >> 8) + DEST_B(dpix);
 					r = (r | -(r >> (8 - SRCSHIFT_R))) & (0xff >> SRCSHIFT_R);
 					g = (g | -(g >> (8 - SRCSHIFT_G))) & (0xff >> SRCSHIFT_G);
 					b = (b | -(b >> (8 - SRCSHIFT_B))) & (0xff >> SRCSHIFT_B);
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -742,13 +1008,13 @@ static void FUNC_PREFIX(draw_quad_palettea16_alpha)(const render_primitive *prim
 				UINT32 ta = pix >> 24;
 				if (ta != 0)
 				{
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 invta = 0x100 - ta;
 					UINT32 r = (SOURCE32_R(pix) * ta + DEST_R(dpix) * invta) >> 8;
 					UINT32 g = (SOURCE32_G(pix) * ta + DEST_G(dpix) * invta) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * ta + DEST_B(dpix) * invta) >> 8;
 
-					*dest = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 				}
 				dest++;
 				curu += dudx;
@@ -785,13 +1051,13 @@ static void FUNC_PREFIX(draw_quad_palettea16_alpha)(const render_primitive *prim
 				UINT32 ta = (pix >> 24) * sa;
 				if (ta != 0)
 				{
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 invsta = (0x10000 - ta) << 8;
 					UINT32 r = (SOURCE32_R(pix) * sr * ta + DEST_R(dpix) * invsta) >> 24;
 					UINT32 g = (SOURCE32_G(pix) * sg * ta + DEST_G(dpix) * invsta) >> 24;
 					UINT32 b = (SOURCE32_B(pix) * sb * ta + DEST_B(dpix) * invsta) >> 24;
 
-					*dest = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 				}
 				dest++;
 				curu += dudx;
@@ -840,7 +1106,7 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 				{
 					const UINT16 *spix = &texbase[(curv >> 16) * texrp + (curu >> 17) * 2];
 					UINT32 pix = ycc_to_rgb(spix[(curu >> 16) & 1] >> 8, spix[0], spix[1]);
-					*dest++ = SOURCE32_TO_DEST(pix);
+					*dest++ = DEST_PIXEL(SOURCE32_TO_DEST(pix));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -854,7 +1120,7 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 				{
 					const UINT16 *spix = &texbase[(curv >> 16) * texrp + (curu >> 17) * 2];
 					UINT32 pix = ycc_to_rgb(palbase[spix[(curu >> 16) & 1] >> 8], spix[0], spix[1]);
-					*dest++ = SOURCE32_TO_DEST(pix);
+					*dest++ = DEST_PIXEL(SOURCE32_TO_DEST(pix));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -893,7 +1159,7 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 					UINT32 g = (SOURCE32_G(pix) * sg) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -911,7 +1177,7 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 					UINT32 g = (SOURCE32_G(pix) * sg) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -948,12 +1214,12 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 				{
 					const UINT16 *spix = &texbase[(curv >> 16) * texrp + (curu >> 17) * 2];
 					UINT32 pix = ycc_to_rgb(spix[(curu >> 16) & 1] >> 8, spix[0], spix[1]);
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (SOURCE32_R(pix) * sr + DEST_R(dpix) * invsa) >> 8;
 					UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -967,12 +1233,12 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 				{
 					const UINT16 *spix = &texbase[(curv >> 16) * texrp + (curu >> 17) * 2];
 					UINT32 pix = ycc_to_rgb(palbase[spix[(curu >> 16) & 1] >> 8], spix[0], spix[1]);
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (SOURCE32_R(pix) * sr + DEST_R(dpix) * invsa) >> 8;
 					UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1018,7 +1284,7 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					*dest++ = SOURCE15_TO_DEST(pix);
+					*dest++ = DEST_PIXEL(SOURCE15_TO_DEST(pix));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1035,7 +1301,7 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 					UINT32 g = palbase[(pix >> 5) & 0x1f] >> SRCSHIFT_G;
 					UINT32 b = palbase[(pix >> 0) & 0x1f] >> SRCSHIFT_B;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1073,7 +1339,7 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 					UINT32 g = (SOURCE15_G(pix) * sg) >> 8;
 					UINT32 b = (SOURCE15_B(pix) * sb) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1090,7 +1356,7 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 					UINT32 g = (palbase[(pix >> 5) & 0x1f] * sg) >> (8 + SRCSHIFT_G);
 					UINT32 b = (palbase[(pix >> 0) & 0x1f] * sb) >> (8 + SRCSHIFT_B);
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1126,12 +1392,12 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (SOURCE15_R(pix) * sr + DEST_R(dpix) * invsa) >> 8;
 					UINT32 g = (SOURCE15_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE15_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1144,12 +1410,12 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = ((palbase[(pix >> 10) & 0x1f] >> SRCSHIFT_R) * sr + DEST_R(dpix) * invsa) >> 8;
 					UINT32 g = ((palbase[(pix >> 5) & 0x1f] >> SRCSHIFT_G) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = ((palbase[(pix >> 0) & 0x1f] >> SRCSHIFT_B) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1182,23 +1448,43 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 	/* fast case: no coloring, no alpha */
 	if (prim->color.r >= 1.0f && prim->color.g >= 1.0f && prim->color.b >= 1.0f && IS_OPAQUE(prim->color.a))
 	{
+		PIXEL_TYPE rowbuf[ROWCOPY_PIXELS];
+		int rowcopy = dvdx == 0 && setup->dudy == 0 && setup->dvdy < 0x10000 && endx > setup->startx && endx - setup->startx <= ROWCOPY_PIXELS;
+		INT32 prevv = -1;
+
 		/* loop over rows */
 		for (y = setup->starty; y < setup->endy; y++)
 		{
-			PIXEL_TYPE *dest = (PIXEL_TYPE *)dstdata + y * pitch + setup->startx;
+			PIXEL_TYPE *target = (PIXEL_TYPE *)dstdata + y * pitch + setup->startx;
+			PIXEL_TYPE *dest = rowcopy ? rowbuf : target;
 			INT32 curu = setup->startu + (y - setup->starty) * setup->dudy;
 			INT32 curv = setup->startv + (y - setup->starty) * setup->dvdy;
 
+			/* a row sampling the same texels as the one above is a copy of it */
+			if (rowcopy && y > setup->starty && (curv >> 16) == prevv)
+			{
+				memcpy(target, rowbuf, (endx - setup->startx) * sizeof(*target));
+				continue;
+			}
+			prevv = curv >> 16;
+
 			/* no lookup case */
 			if (palbase == NULL)
 			{
-				/* loop over cols */
-				for (x = setup->startx; x < endx; x++)
+#if SPAN32
+				if (dvdx == 0)
+					span_fetch32((UINT32 *)dest, &texbase[(curv >> 16) * texrp], curu, dudx, endx - setup->startx);
+				else
+#endif
 				{
-					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					*dest++ = SOURCE32_TO_DEST(pix);
-					curu += dudx;
-					curv += dvdx;
+					/* loop over cols */
+					for (x = setup->startx; x < endx; x++)
+					{
+						UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
+						*dest++ = DEST_PIXEL(SOURCE32_TO_DEST(pix));
+						curu += dudx;
+						curv += dvdx;
+					}
 				}
 			}
 
@@ -1213,11 +1499,15 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 					UINT32 g = palbase[(pix >> 8) & 0xff] >> SRCSHIFT_G;
 					UINT32 b = palbase[(pix >> 0) & 0xff] >> SRCSHIFT_B;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
 			}
+
+			/* rows are built in the row buffer, so the destination is never read back */
+			if (rowcopy)
+				memcpy(target, rowbuf, (endx - setup->startx) * sizeof(*target));
 		}
 	}
 
@@ -1251,7 +1541,7 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 					UINT32 g = (SOURCE32_G(pix) * sg) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1268,7 +1558,7 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 					UINT32 g = (palbase[(pix >> 8) & 0xff] * sg) >> (8 + SRCSHIFT_G);
 					UINT32 b = (palbase[(pix >> 0) & 0xff] * sb) >> (8 + SRCSHIFT_B);
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1304,12 +1594,12 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (SOURCE32_R(pix) * sr + DEST_R(dpix) * invsa) >> 8;
 					UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1322,12 +1612,12 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = ((palbase[(pix >> 16) & 0xff] >> SRCSHIFT_R) * sr + DEST_R(dpix) * invsa) >> 8;
 					UINT32 g = ((palbase[(pix >> 8) & 0xff] >> SRCSHIFT_G) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = ((palbase[(pix >> 0) & 0xff] >> SRCSHIFT_B) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1370,6 +1660,25 @@ static void FUNC_PREFIX(draw_quad_argb32_alpha)(const render_primitive *prim, vo
 			/* no lookup case */
 			if (palbase == NULL)
 			{
+#if SPAN32 && !NO_DEST_READ
+				if (dvdx == 0)
+				{
+					const UINT32 *srcrow = &texbase[(curv >> 16) * texrp];
+					UINT32 span[SPAN_CHUNK];
+
+					/* gather a chunk of texels, then blend it in one go */
+					for (x = setup->startx; x < endx; x += SPAN_CHUNK)
+					{
+						int count = MIN(endx - x, SPAN_CHUNK);
+						span_fetch32(span, srcrow, curu, dudx, count);
+						span_blend32((UINT32 *)dest, span, count);
+						dest += count;
+						curu += count * dudx;
+					}
+					continue;
+				}
+#endif
+
 				/* loop over cols */
 				for (x = setup->startx; x < endx; x++)
 				{
@@ -1377,13 +1686,13 @@ static void FUNC_PREFIX(draw_quad_argb32_alpha)(const render_primitive *prim, vo
 					UINT32 ta = pix >> 24;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 invta = 0x100 - ta;
 						UINT32 r = (SOURCE32_R(pix) * ta + DEST_R(dpix) * invta) >> 8;
 						UINT32 g = (SOURCE32_G(pix) * ta + DEST_G(dpix) * invta) >> 8;
 						UINT32 b = (SOURCE32_B(pix) * ta + DEST_B(dpix) * invta) >> 8;
 
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1401,13 +1710,13 @@ static void FUNC_PREFIX(draw_quad_argb32_alpha)(const render_primitive *prim, vo
 					UINT32 ta = pix >> 24;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 invta = 0x100 - ta;
 						UINT32 r = ((palbase[(pix >> 16) & 0xff] >> SRCSHIFT_R) * ta + DEST_R(dpix) * invta) >> 8;
 						UINT32 g = ((palbase[(pix >> 8) & 0xff] >> SRCSHIFT_G) * ta + DEST_G(dpix) * invta) >> 8;
 						UINT32 b = ((palbase[(pix >> 0) & 0xff] >> SRCSHIFT_B) * ta + DEST_B(dpix) * invta) >> 8;
 
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1448,13 +1757,13 @@ static void FUNC_PREFIX(draw_quad_argb32_alpha)(const render_primitive *prim, vo
 					UINT32 ta = (pix >> 24) * sa;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 invsta = (0x10000 - ta) << 8;
 						UINT32 r = (SOURCE32_R(pix) * sr * ta + DEST_R(dpix) * invsta) >> 24;
 						UINT32 g = (SOURCE32_G(pix) * sg * ta + DEST_G(dpix) * invsta) >> 24;
 						UINT32 b = (SOURCE32_B(pix) * sb * ta + DEST_B(dpix) * invsta) >> 24;
 
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1473,13 +1782,13 @@ static void FUNC_PREFIX(draw_quad_argb32_alpha)(const render_primitive *prim, vo
 					UINT32 ta = (pix >> 24) * sa;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 invsta = (0x10000 - ta) << 8;
 						UINT32 r = ((palbase[(pix >> 16) & 0xff] >> SRCSHIFT_R) * sr * ta + DEST_R(dpix) * invsta) >> 24;
 						UINT32 g = ((palbase[(pix >> 8) & 0xff] >> SRCSHIFT_G) * sg * ta + DEST_G(dpix) * invsta) >> 24;
 						UINT32 b = ((palbase[(pix >> 0) & 0xff] >> SRCSHIFT_B) * sb * ta + DEST_B(dpix) * invsta) >> 24;
 
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1527,12 +1836,12 @@ static void FUNC_PREFIX(draw_quad_argb32_multiply)(const render_primitive *prim,
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (SOURCE32_R(pix) * DEST_R(dpix)) >> (8 - SRCSHIFT_R);
 					UINT32 g = (SOURCE32_G(pix) * DEST_G(dpix)) >> (8 - SRCSHIFT_G);
 					UINT32 b = (SOURCE32_B(pix) * DEST_B(dpix)) >> (8 - SRCSHIFT_B);
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1543,12 +1852,12 @@ static void FUNC_PREFIX(draw_quad_argb32_multiply)(const render_primitive *prim,
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (palbase[(pix >> 16) & 0xff] * DEST_R(dpix)) >> 8;
 					UINT32 g = (palbase[(pix >> 8) & 0xff] * DEST_G(dpix)) >> 8;
 					UINT32 b = (palbase[(pix >> 0) & 0xff] * DEST_B(dpix)) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1582,12 +1891,12 @@ static void FUNC_PREFIX(draw_quad_argb32_multiply)(const render_primitive *prim,
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (SOURCE32_R(pix) * sr * DEST_R(dpix)) >> (16 - SRCSHIFT_R);
 					UINT32 g = (SOURCE32_G(pix) * sg * DEST_G(dpix)) >> (16 - SRCSHIFT_G);
 					UINT32 b = (SOURCE32_B(pix) * sb * DEST_B(dpix)) >> (16 - SRCSHIFT_B);
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1598,12 +1907,12 @@ static void FUNC_PREFIX(draw_quad_argb32_multiply)(const render_primitive *prim,
 				for (x = setup->startx; x < endx; x++)
 				{
 					UINT32 pix = texbase[(curv >> 16) * texrp + (curu >> 16)];
-					UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+					UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 					UINT32 r = (palbase[(pix >> 16) & 0xff] * sr * DEST_R(dpix)) >> 16;
 					UINT32 g = (palbase[(pix >> 8) & 0xff] * sg * DEST_G(dpix)) >> 16;
 					UINT32 b = (palbase[(pix >> 0) & 0xff] * sb * DEST_B(dpix)) >> 16;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1652,14 +1961,14 @@ static void FUNC_PREFIX(draw_quad_argb32_add)(const render_primitive *prim, void
 					UINT32 ta = pix >> 24;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 r = ((SOURCE32_R(pix) * ta) >> 8) + DEST_R(dpix);
 						UINT32 g = ((SOURCE32_G(pix) * ta) >> 8) + DEST_G(dpix);
 						UINT32 b = ((SOURCE32_B(pix) * ta) >> 8) + DEST_B(dpix);
 						r = (r | -(r >> (8 - SRCSHIFT_R))) & (0xff >> SRCSHIFT_R);
 						g = (g | -(g >> (8 - SRCSHIFT_G))) & (0xff >> SRCSHIFT_G);
 						b = (b | -(b >> (8 - SRCSHIFT_B))) & (0xff >> SRCSHIFT_B);
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1677,14 +1986,14 @@ static void FUNC_PREFIX(draw_quad_argb32_add)(const render_primitive *prim, void
 					UINT32 ta = pix >> 24;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 r = ((palbase[(pix >> 16) & 0xff] * ta) >> (8 + SRCSHIFT_R)) + DEST_R(dpix);
 						UINT32 g = ((palbase[(pix >> 8) & 0xff] * ta) >> (8 + SRCSHIFT_G)) + DEST_G(dpix);
 						UINT32 b = ((palbase[(pix >> 0) & 0xff] * ta) >> (8 + SRCSHIFT_B)) + DEST_B(dpix);
 						r = (r | -(r >> (8 - SRCSHIFT_R))) & (0xff >> SRCSHIFT_R);
 						g = (g | -(g >> (8 - SRCSHIFT_G))) & (0xff >> SRCSHIFT_G);
 						b = (b | -(b >> (8 - SRCSHIFT_B))) & (0xff >> SRCSHIFT_B);
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1725,14 +2034,14 @@ static void FUNC_PREFIX(draw_quad_argb32_add)(const render_primitive *prim, void
 					UINT32 ta = (pix >> 24) * sa;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 r = ((SOURCE32_R(pix) * sr * ta) >> 24) + DEST_R(dpix);
 						UINT32 g = ((SOURCE32_G(pix) * sg * ta) >> 24) + DEST_G(dpix);
 						UINT32 b = ((SOURCE32_B(pix) * sb * ta) >> 24) + DEST_B(dpix);
 						r = (r | -(r >> (8 - SRCSHIFT_R))) & (0xff >> SRCSHIFT_R);
 						g = (g | -(g >> (8 - SRCSHIFT_G))) & (0xff >> SRCSHIFT_G);
 						b = (b | -(b >> (8 - SRCSHIFT_B))) & (0xff >> SRCSHIFT_B);
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1750,14 +2059,14 @@ static void FUNC_PREFIX(draw_quad_argb32_add)(const render_primitive *prim, void
 					UINT32 ta = (pix >> 24) * sa;
 					if (ta != 0)
 					{
-						UINT32 dpix = NO_DEST_READ ? 0 : *dest;
+						UINT32 dpix = NO_DEST_READ ? 0 : DEST_PIXEL(*dest);
 						UINT32 r = ((palbase[(pix >> 16) & 0xff] * sr * ta) >> (24 + SRCSHIFT_R)) + DEST_R(dpix);
 						UINT32 g = ((palbase[(pix >> 8) & 0xff] * sr * ta) >> (24 + SRCSHIFT_R)) + DEST_G(dpix);
 						UINT32 b = ((palbase[(pix >> 0) & 0xff] * sr * ta) >> (24 + SRCSHIFT_R)) + DEST_B(dpix);
 						r = (r | -(r >> (8 - SRCSHIFT_R))) & (0xff >> SRCSHIFT_R);
 						g = (g | -(g >> (8 - SRCSHIFT_G))) & (0xff >> SRCSHIFT_G);
 						b = (b | -(b >> (8 - SRCSHIFT_B))) & (0xff >> SRCSHIFT_B);
-						*dest = DEST_ASSEMBLE_RGB(r, g, b);
+						*dest = DEST_PIXEL(DEST_ASSEMBLE_RGB(r, g, b));
 					}
 					dest++;
 					curu += dudx;
@@ -1777,13 +2086,15 @@ static void FUNC_PREFIX(draw_quad_argb32_add)(const render_primitive *prim, void
 /*-------------------------------------------------
     setup_and_draw_textured_quad - perform setup
     and then dispatch to a texture-mode-specific
-    drawing routine
+    drawing routine; only rows between top and
+    bottom are drawn
 -------------------------------------------------*/
 
-static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, UINT32 pitch)
+static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, INT32 top, INT32 bottom, UINT32 pitch)
 {
 	float fdudx, fdvdx, fdudy, fdvdy;
 	quad_setup_data setup;
+	INT32 skip;
 
 	assert(prim->bounds.x0 <= prim->bounds.x1);
 	assert(prim->bounds.y0 <= prim->bounds.y1);
@@ -1822,6 +2133,18 @@ static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *pr
 	setup.startu += (setup.dudx + setup.dudy) / 2;
 	setup.startv += (setup.dvdx + setup.dvdy) / 2;
 
+	/* clip to the band, stepping U/V so rows sample exactly as they would unclipped */
+	if (setup.endy > bottom) setup.endy = bottom;
+	skip = top - setup.starty;
+	if (skip > 0)
+	{
+		setup.starty = top;
+		setup.startu += skip * setup.dudy;
+		setup.startv += skip * setup.dvdy;
+	}
+	if (setup.starty >= setup.endy)
+		return;
+
 	/* render based on the texture coordinates */
 	switch (prim->flags & (PRIMFLAG_TEXFORMAT_MASK | PRIMFLAG_BLENDMODE_MASK))
 	{
@@ -1878,11 +2201,12 @@ static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *pr
 ***************************************************************************/
 
 /*-------------------------------------------------
-    draw_primitives - draw a series of primitives
-    using a software rasterizer
+    draw_primitives_band - draw a series of
+    primitives, touching only rows between top
+    and bottom
 -------------------------------------------------*/
 
-void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch)
+static void FUNC_PREFIX(draw_primitives_band)(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, INT32 top, INT32 bottom)
 {
 	const render_primitive *prim;
 
@@ -1891,19 +2215,93 @@ void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdat
 		switch (prim->type)
 		{
 			case RENDER_PRIMITIVE_LINE:
-				FUNC_PREFIX(draw_line)(prim, dstdata, width, height, pitch);
+				FUNC_PREFIX(draw_line)(prim, dstdata, width, top, bottom, pitch);
 				break;
 
 			case RENDER_PRIMITIVE_QUAD:
 				if (!prim->texture.base)
-					FUNC_PREFIX(draw_rect)(prim, dstdata, width, height, pitch);
+					FUNC_PREFIX(draw_rect)(prim, dstdata, width, top, bottom, pitch);
 				else
-					FUNC_PREFIX(setup_and_draw_textured_quad)(prim, dstdata, width, height, pitch);
+					FUNC_PREFIX(setup_and_draw_textured_quad)(prim, dstdata, width, height, top, bottom, pitch);
 				break;
 		}
 }
 
 
+/*-------------------------------------------------
+    draw_band_callback - work item callback that
+    renders a single band
+-------------------------------------------------*/
+
+static void *FUNC_PREFIX(draw_band_callback)(void *param, int threadid)
+{
+	band_info *band = param;
+	FUNC_PREFIX(draw_primitives_band)(band->primlist, band->dstdata, band->width, band->height, band->pitch, band->top, band->bottom);
+	return NULL;
+}
+
+
+
+/***************************************************************************
+    PRIMARY ENTRY POINTS
+***************************************************************************/
+
+/*-------------------------------------------------
+    draw_primitives - draw a series of primitives
+    using a software rasterizer
+-------------------------------------------------*/
+
+void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch)
+{
+	FUNC_PREFIX(draw_primitives_band)(primlist, dstdata, width, height, pitch, 0, height);
+}
+
+
+/*-------------------------------------------------
+    draw_primitives_threaded - draw a series of
+    primitives by splitting the target into
+    horizontal bands and rasterizing them in
+    parallel on the given work queue; each band
+    draws the whole list in order, so the result
+    matches draw_primitives exactly
+-------------------------------------------------*/
+
+void FUNC_PREFIX(draw_primitives_threaded)(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue, int numbands)
+{
+	band_info band[MAX_BANDS];
+	int bandnum;
+
+	/* clamp the band count; too few rows per band and threading is not worth it */
+	numbands = MIN(numbands, MAX_BANDS);
+	numbands = MIN(numbands, (int)height / 16);
+	if (queue == NULL || numbands <= 1)
+	{
+		FUNC_PREFIX(draw_primitives)(primlist, dstdata, width, height, pitch);
+		return;
+	}
+
+	/* the line rasterizer's lookup table must exist before the workers start */
+	init_cosine_table();
+
+	/* split the target into bands of nearly equal height */
+	for (bandnum = 0; bandnum < numbands; bandnum++)
+	{
+		band[bandnum].primlist = primlist;
+		band[bandnum].dstdata = dstdata;
+		band[bandnum].width = width;
+		band[bandnum].height = height;
+		band[bandnum].pitch = pitch;
+		band[bandnum].top = height * bandnum / numbands;
+		band[bandnum].bottom = height * (bandnum + 1) / numbands;
+	}
+
+	/* queue them all and wait for the workers to finish; the bands live on our stack,
+	   so we can't return while any worker may still be reading them */
+	osd_work_item_queue_multiple(queue, FUNC_PREFIX(draw_band_callback), numbands, band, sizeof(band[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+	while (!osd_work_queue_wait(queue, 100 * osd_ticks_per_second())) ;
+}
+
+
 
 /***************************************************************************
     MACRO UNDOING
@@ -1926,6 +2324,8 @@ void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdat
 
 #undef SOURCE15_TO_DEST
 #undef SOURCE32_TO_DEST
+#undef DEST_PIXEL
+#undef SPAN32
 
 #undef FUNC_PREFIX
 #undef PIXEL_TYPE
@@ -1939,5 +2339,6 @@ void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdat
 #undef DSTSHIFT_B
 
 #undef NO_DEST_READ
+#undef DEST_BIG_ENDIAN
 
 #undef VARIABLE_SHIFT
@@ -0,0 +1,515 @@
+/***************************************************************************
+
+    rewind.c
+
+    Rewind buffer built on in-memory save state deltas.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    Every few frames the whole machine is snapshotted into memory. Only
+    the most recent snapshot is kept in full; each older one is kept as
+    the XOR of itself against the snapshot that followed it, run length
+    encoded so that unchanged data costs nothing but a skip count.
+
+    Delta format, in 64-bit words:
+
+        skip    varint   number of unchanged words to step over
+        count   varint   number of words that follow
+        words   count*8  XOR of the old and new words
+
+    repeated until the end of the delta. XOR is its own inverse, so
+    applying the newest delta to the newest snapshot yields the one
+    before it, and so on back through the ring.
+
+***************************************************************************/
+
+#include "driver.h"
+#include "rewind.h"
+#include "profiler.h"
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+/* bytes of budget reserved for each entry in the step table */
+#define BYTES_PER_STEP		128
+
+/* work requested by the frame callback, done between timeslices */
+#define REQUEST_NONE		0
+#define REQUEST_SNAPSHOT	1
+#define REQUEST_STEP_BACK	2
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+typedef struct _rewind_step rewind_step;
+struct _rewind_step
+{
+	UINT32				offset;				/* offset of the delta within the ring */
+	UINT32				length;				/* length of the delta in bytes */
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+/* configuration */
+static UINT32			rewind_interval;
+static UINT32			rewind_budget;
+
+/* snapshots */
+static UINT32			state_size;			/* size of a snapshot, as reported by the state system */
+static UINT32			state_words;		/* size of a snapshot rounded up to 64-bit words */
+static UINT64 *			latest;				/* most recent snapshot, in full */
+static UINT8			have_latest;		/* TRUE once a snapshot has been saved into latest */
+static UINT64 *			current;			/* scratch snapshot being taken */
+static UINT8 *			delta;				/* scratch delta, sized for the worst case */
+static UINT32			delta_max;
+
+/* ring of deltas, newest at the head */
+static UINT8 *			ring;
+static UINT32			ring_size;
+static UINT32			ring_head;
+static UINT32			ring_used;
+static rewind_step *	steps;
+static UINT32			step_capacity;
+static UINT32			step_first;
+static UINT32			step_count;
+
+/* playback state */
+static UINT32			frames_since_snapshot;
+static UINT8			rewinding;
+static UINT8			request;
+
+/* instrumentation */
+static UINT32			stat_snapshots;
+static UINT64			stat_bytes;
+static osd_ticks_t		stat_ticks;
+static osd_ticks_t		stat_max_ticks;
+
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+static void rewind_frame(running_machine *machine);
+static void rewind_perform(running_machine *machine);
+static void rewind_exit(running_machine *machine);
+static void rewind_free(void);
+static void rewind_alloc(UINT32 size);
+
+
+
+/***************************************************************************
+    INLINE FUNCTIONS
+***************************************************************************/
+
+/*-------------------------------------------------
+    put_varint - write a variable-length value
+-------------------------------------------------*/
+
+INLINE UINT8 *put_varint(UINT8 *dest, UINT32 value)
+{
+	while (value >= 0x80)
+	{
+		*dest++ = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	*dest++ = value;
+	return dest;
+}
+
+
+/*-------------------------------------------------
+    get_varint - read a variable-length value
+-------------------------------------------------*/
+
+INLINE const UINT8 *get_varint(const UINT8 *src, UINT32 *value)
+{
+	UINT32 result = 0;
+	int shift = 0;
+
+	while (*src & 0x80)
+	{
+		result |= (*src++ & 0x7f) << shift;
+		shift += 7;
+	}
+	*value = result | (*src++ << shift);
+	return src;
+}
+
+
+
+/***************************************************************************
+    INITIALIZATION
+***************************************************************************/
+
+/*-------------------------------------------------
+    rewind_init - set up the rewind buffer if it
+    is enabled and the game supports saving
+-------------------------------------------------*/
+
+void rewind_init(running_machine *machine)
+{
+	rewind_budget = options_get_int(mame_options(), OPTION_REWIND) * 1024;
+	rewind_interval = MAX(options_get_int(mame_options(), OPTION_REWIND_INTERVAL), 1);
+
+	/* snapshots of a game without save state support would not restore */
+	if (rewind_budget == 0 || !(machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
+		return;
+
+	/* buffers are allocated on the first snapshot, once registrations are closed */
+	state_size = 0;
+	have_latest = FALSE;
+	frames_since_snapshot = 0;
+	rewinding = FALSE;
+	request = REQUEST_NONE;
+	stat_snapshots = 0;
+	stat_bytes = 0;
+	stat_ticks = 0;
+	stat_max_ticks = 0;
+
+	add_frame_callback(machine, rewind_frame);
+	add_exit_callback(machine, rewind_exit);
+}
+
+
+/*-------------------------------------------------
+    rewind_exit - report statistics and free
+    everything
+-------------------------------------------------*/
+
+static void rewind_exit(running_machine *machine)
+{
+	if (stat_snapshots > 0)
+	{
+		osd_ticks_t tps = osd_ticks_per_second();
+		logerror("Rewind: %u snapshots of %u bytes, average delta %u bytes, average %.3f ms, max %.3f ms\n",
+				stat_snapshots, state_size, (UINT32)(stat_bytes / stat_snapshots),
+				(double)stat_ticks * 1000.0 / (double)tps / (double)stat_snapshots,
+				(double)stat_max_ticks * 1000.0 / (double)tps);
+	}
+	rewind_free();
+}
+
+
+/*-------------------------------------------------
+    rewind_free - free all buffers
+-------------------------------------------------*/
+
+static void rewind_free(void)
+{
+	if (latest != NULL)
+		free(latest);
+	if (current != NULL)
+		free(current);
+	if (delta != NULL)
+		free(delta);
+	if (ring != NULL)
+		free(ring);
+	if (steps != NULL)
+		free(steps);
+	latest = current = NULL;
+	delta = ring = NULL;
+	steps = NULL;
+	state_size = 0;
+	have_latest = FALSE;
+}
+
+
+/*-------------------------------------------------
+    rewind_alloc - (re)allocate all buffers for
+    snapshots of the given size
+-------------------------------------------------*/
+
+static void rewind_alloc(UINT32 size)
+{
+	rewind_free();
+
+	/* the worst case delta is all literals, broken up by pairs of matching words */
+	state_size = size;
+	state_words = (size + 7) / 8;
+	delta_max = state_words * 8 + (state_words / 3 + 1) * 10;
+
+	/* split the budget between the step table and the ring */
+	step_capacity = rewind_budget / BYTES_PER_STEP;
+	ring_size = rewind_budget - step_capacity * sizeof(steps[0]);
+
+	/* padding words stay zero in both snapshots, so they never show up in a delta */
+	latest = malloc_or_die(state_words * 8);
+	current = malloc_or_die(state_words * 8);
+	memset(latest, 0, state_words * 8);
+	memset(current, 0, state_words * 8);
+	delta = malloc_or_die(delta_max);
+	ring = malloc_or_die(ring_size);
+	steps = malloc_or_die(step_capacity * sizeof(steps[0]));
+
+	ring_head = ring_used = 0;
+	step_first = step_count = 0;
+}
+
+
+
+/***************************************************************************
+    DELTA ENCODING
+***************************************************************************/
+
+/*-------------------------------------------------
+    delta_encode - encode the XOR of two
+    snapshots; returns the length of the delta
+-------------------------------------------------*/
+
+static UINT32 delta_encode(UINT8 *dest, const UINT64 *newer, const UINT64 *older, UINT32 words)
+{
+	UINT8 *out = dest;
+	UINT32 last = 0, word = 0;
+
+	while (word < words)
+	{
+		UINT32 start;
+
+		/* skip unchanged words; whole unchanged entries go by at memory speed */
+		while (word < words && newer[word] == older[word])
+			word++;
+		if (word == words)
+			break;
+
+		/* extend the literal run until two words in a row match */
+		start = word;
+		while (word < words && (newer[word] != older[word] || (word + 1 < words && newer[word + 1] != older[word + 1])))
+			word++;
+
+		/* emit the skip, the count, and the XORed words */
+		out = put_varint(out, start - last);
+		out = put_varint(out, word - start);
+		for ( ; start < word; start++)
+		{
+			UINT64 diff = newer[start] ^ older[start];
+			memcpy(out, &diff, 8);
+			out += 8;
+		}
+		last = word;
+	}
+	return out - dest;
+}
+
+
+/*-------------------------------------------------
+    delta_apply - XOR a delta into a snapshot
+-------------------------------------------------*/
+
+static void delta_apply(UINT64 *state, const UINT8 *src, UINT32 length)
+{
+	const UINT8 *end = src + length;
+	UINT32 word = 0;
+
+	while (src < end)
+	{
+		UINT32 skip, count;
+
+		src = get_varint(src, &skip);
+		src = get_varint(src, &count);
+		for (word += skip; count > 0; count--, word++)
+		{
+			UINT64 diff;
+			memcpy(&diff, src, 8);
+			state[word] ^= diff;
+			src += 8;
+		}
+	}
+}
+
+
+
+/***************************************************************************
+    RING MANAGEMENT
+***************************************************************************/
+
+/*-------------------------------------------------
+    ring_push - append a delta to the ring,
+    dropping the oldest ones to make room
+-------------------------------------------------*/
+
+static void ring_push(const UINT8 *data, UINT32 length)
+{
+	rewind_step *step;
+	UINT32 first;
+
+	/* a delta bigger than the whole ring breaks the chain; start over */
+	if (length > ring_size)
+	{
+		ring_head = ring_used = 0;
+		step_first = step_count = 0;
+		return;
+	}
+
+	/* drop the oldest deltas until there is room */
+	while (ring_used + length > ring_size || step_count == step_capacity)
+	{
+		ring_used -= steps[step_first].length;
+		step_first = (step_first + 1) % step_capacity;
+		step_count--;
+	}
+
+	/* copy in, wrapping around the end of the ring */
+	first = MIN(length, ring_size - ring_head);
+	memcpy(&ring[ring_head], data, first);
+	memcpy(&ring[0], data + first, length - first);
+
+	step = &steps[(step_first + step_count) % step_capacity];
+	step->offset = ring_head;
+	step->length = length;
+	step_count++;
+
+	ring_head = (ring_head + length) % ring_size;
+	ring_used += length;
+}
+
+
+/*-------------------------------------------------
+    ring_pop - remove the newest delta from the
+    ring, copying it out; returns its length
+-------------------------------------------------*/
+
+static UINT32 ring_pop(UINT8 *data)
+{
+	rewind_step *step = &steps[(step_first + step_count - 1) % step_capacity];
+	UINT32 first = MIN(step->length, ring_size - step->offset);
+
+	memcpy(data, &ring[step->offset], first);
+	memcpy(data + first, &ring[0], step->length - first);
+
+	ring_head = step->offset;
+	ring_used -= step->length;
+	step_count--;
+	return step->length;
+}
+
+
+
+/***************************************************************************
+    FRAME PROCESSING
+***************************************************************************/
+
+/*-------------------------------------------------
+    rewind_snapshot - take a snapshot and push
+    the delta to the previous one
+-------------------------------------------------*/
+
+static void rewind_snapshot(running_machine *machine)
+{
+	osd_ticks_t start = osd_ticks();
+	UINT32 size = mame_get_state_size(machine);
+	UINT64 *temp;
+
+	/* a change in registrations invalidates every delta */
+	if (state_size != size)
+		rewind_alloc(size);
+
+	/* try again next frame if the state can't be saved right now */
+	if (mame_save_state_memory(machine, current, state_size) != 0)
+		return;
+
+	/* the delta takes the newest snapshot back to the one before it */
+	if (have_latest)
+	{
+		UINT32 length = delta_encode(delta, current, latest, state_words);
+		ring_push(delta, length);
+		stat_bytes += length;
+	}
+
+	/* the new snapshot becomes the latest */
+	temp = latest;
+	latest = current;
+	current = temp;
+	have_latest = TRUE;
+	frames_since_snapshot = 0;
+
+	/* accumulate timing */
+	start = osd_ticks() - start;
+	stat_ticks += start;
+	stat_max_ticks = MAX(stat_max_ticks, start);
+	stat_snapshots++;
+}
+
+
+/*-------------------------------------------------
+    rewind_step_back - restore the latest
+    snapshot, first stepping back a delta if
+    the rewind key was already held
+-------------------------------------------------*/
+
+static void rewind_step_back(running_machine *machine)
+{
+	/* nothing to go back to until a snapshot has been saved, or the state can't be loaded right now */
+	if (!have_latest || timer_count_anonymous() > 0)
+		return;
+
+	/* the machine has always run on past the latest snapshot, so a fresh press returns */
+	/* to it; each frame the key stays held steps one delta further back */
+	if (rewinding && step_count > 0)
+		delta_apply(latest, delta, ring_pop(delta));
+
+	if (mame_load_state_memory(machine, latest, state_size) == 0)
+		frames_since_snapshot = 0;
+}
+
+
+/*-------------------------------------------------
+    rewind_frame - per-frame callback; asks for
+    a step back while the rewind key is held,
+    and for a snapshot every few frames otherwise
+-------------------------------------------------*/
+
+static void rewind_frame(running_machine *machine)
+{
+	/* only act while running */
+	if (mame_get_phase(machine) != MAME_PHASE_RUNNING || mame_is_paused(machine))
+		return;
+
+	if (input_port_type_pressed(IPT_UI_REWIND, 0))
+		request = REQUEST_STEP_BACK;
+	else
+	{
+		rewinding = FALSE;
+		if (++frames_since_snapshot >= rewind_interval || !have_latest)
+			request = REQUEST_SNAPSHOT;
+	}
+
+	/* we are inside the VBLANK timer here; the work happens once the timeslice ends */
+	/* a pending user save or load goes first, and we ask again next frame */
+	if (request != REQUEST_NONE && !mame_schedule_state_callback(machine, rewind_perform))
+		request = REQUEST_NONE;
+}
+
+
+/*-------------------------------------------------
+    rewind_perform - take the snapshot or step
+    back requested by the frame callback, between
+    timeslices
+-------------------------------------------------*/
+
+static void rewind_perform(running_machine *machine)
+{
+profiler_mark(PROFILER_REWIND);
+	if (request == REQUEST_STEP_BACK)
+	{
+		rewind_step_back(machine);
+		rewinding = TRUE;
+	}
+	else if (request == REQUEST_SNAPSHOT)
+		rewind_snapshot(machine);
+	request = REQUEST_NONE;
+profiler_mark(PROFILER_END);
+}
@@ -0,0 +1,21 @@
+/***************************************************************************
+
+    rewind.h
+
+    Rewind buffer built on in-memory save state deltas.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#pragma once
+
+#ifndef __REWIND_H__
+#define __REWIND_H__
+
+#include "mamecore.h"
+
+void rewind_init(running_machine *machine);
+
+#endif	/* __REWIND_H__ */
@@ -39,6 +39,36 @@ struct _open_chd
 };
 
 
+/* bytes of a region written by a ROM load: groups of groupsize bytes, stride bytes apart */
+typedef struct _region_span region_span;
+struct _region_span
+{
+	UINT8 *				start;					/* first byte touched */
+	UINT32				length;					/* distance from the first to the last byte touched, plus one */
+	UINT32				groupsize;				/* bytes written per group */
+	UINT32				stride;					/* distance between groups */
+};
+
+
+/* a whole-file load handed off to the worker threads */
+typedef struct _deferred_load deferred_load;
+struct _deferred_load
+{
+	deferred_load *		next;					/* pointer to next in the list */
+	const rom_entry *	romp;					/* ROM entry being loaded */
+	mame_file *			file;					/* file to load from */
+	region_span			span;					/* region bytes being written */
+	UINT32				length;					/* length of the file */
+	int					groupsize;				/* bytes per group */
+	int					skip;					/* bytes skipped between groups */
+	int					reversed;				/* groups are stored reversed */
+	UINT32				functions;				/* hash functions to compute */
+	int					cached;					/* hash is already known from the hash cache */
+	UINT32				actlength;				/* bytes actually loaded */
+	char				hash[HASH_BUF_SIZE];	/* hash of the loaded data */
+};
+
+
 
 /***************************************************************************
     GLOBAL VARIABLES
@@ -53,6 +83,11 @@ int system_bios;
 
 static int total_rom_load_warnings;
 
+/* deferred loads */
+static osd_work_queue *rom_queue;
+static deferred_load *deferred_list;
+static deferred_load **deferred_tailptr;
+
 
 
 /***************************************************************************
@@ -60,6 +95,8 @@ static int total_rom_load_warnings;
 ***************************************************************************/
 
 static void rom_exit(running_machine *machine);
+static void compare_length_and_hash(rom_load_data *romdata, const char *name, UINT32 explength, const char* hash, UINT32 actlength, const char* acthash);
+static void finish_deferred_loads(rom_load_data *romdata);
 
 
 
@@ -340,17 +377,23 @@ static void dump_wrong_and_correct_checksums(rom_load_data* romdata, const char*
 
 static void verify_length_and_hash(rom_load_data *romdata, const char *name, UINT32 explength, const char* hash)
 {
-	UINT32 actlength;
-	const char* acthash;
-
 	/* we've already complained if there is no file */
 	if (!romdata->file)
 		return;
 
 	/* get the length and CRC from the file */
-	actlength = mame_fsize(romdata->file);
-	acthash = mame_fhash(romdata->file, hash_data_used_functions(hash));
+	compare_length_and_hash(romdata, name, explength, hash, mame_fsize(romdata->file), mame_fhash(romdata->file, hash_data_used_functions(hash)));
+}
 
+
+/*-------------------------------------------------
+    compare_length_and_hash - report any
+    differences between the expected and actual
+    length and hash signatures
+-------------------------------------------------*/
+
+static void compare_length_and_hash(rom_load_data *romdata, const char *name, UINT32 explength, const char* hash, UINT32 actlength, const char* acthash)
+{
 	/* verify length */
 	if (explength != actlength)
 	{
@@ -548,23 +591,16 @@ static int rom_fread(rom_load_data *romdata, UINT8 *buffer, int length)
 
 
 /*-------------------------------------------------
-    read_rom_data - read ROM data for a single
-    entry
+    get_rom_span - validate a ROM entry and
+    compute the region bytes it writes
 -------------------------------------------------*/
 
-static int read_rom_data(rom_load_data *romdata, const rom_entry *romp)
+static void get_rom_span(rom_load_data *romdata, const rom_entry *romp, region_span *span)
 {
-	int datashift = ROM_GETBITSHIFT(romp);
-	int datamask = ((1 << ROM_GETBITWIDTH(romp)) - 1) << datashift;
 	int numbytes = ROM_GETLENGTH(romp);
 	int groupsize = ROM_GETGROUPSIZE(romp);
 	int skip = ROM_GETSKIPCOUNT(romp);
-	int reversed = ROM_ISREVERSED(romp);
 	int numgroups = (numbytes + groupsize - 1) / groupsize;
-	UINT8 *base = romdata->regionbase + ROM_GETOFFSET(romp);
-	int i;
-
-	debugload("Loading ROM data: offs=%X len=%X mask=%02X group=%d skip=%d reverse=%d\n", ROM_GETOFFSET(romp), numbytes, datamask, groupsize, skip, reversed);
 
 	/* make sure the length was an even multiple of the group size */
 	if (numbytes % groupsize != 0)
@@ -578,6 +614,147 @@ static int read_rom_data(rom_load_data *romdata, const rom_entry *romp)
 	if (numbytes == 0)
 		fatalerror("Error in RomModule definition: %s has an invalid length\n", ROM_GETNAME(romp));
 
+	span->start = romdata->regionbase + ROM_GETOFFSET(romp);
+	span->length = numgroups * groupsize + (numgroups - 1) * skip;
+	span->groupsize = (skip == 0) ? span->length : groupsize;
+	span->stride = (skip == 0) ? span->length : groupsize + skip;
+}
+
+
+/*-------------------------------------------------
+    spans_overlap - return TRUE if two region
+    spans can write the same byte
+-------------------------------------------------*/
+
+static int spans_overlap(const region_span *span1, const region_span *span2)
+{
+	UINT32 phase;
+
+	/* disjoint ranges never overlap */
+	if (span1->start >= span2->start + span2->length || span2->start >= span1->start + span1->length)
+		return FALSE;
+
+	/* different strides might; assume the worst */
+	if (span1->stride != span2->stride || span1->groupsize + span2->groupsize > span1->stride)
+		return TRUE;
+
+	/* same stride: interleaved loads overlap only if their groups meet */
+	if (span2->start >= span1->start)
+		phase = (span2->start - span1->start) % span1->stride;
+	else
+		phase = (span1->stride - (span1->start - span2->start) % span1->stride) % span1->stride;
+	return (phase < span1->groupsize || phase + span2->groupsize > span1->stride);
+}
+
+
+/*-------------------------------------------------
+    wait_for_span - finish any deferred loads
+    that write bytes in the given span
+-------------------------------------------------*/
+
+static void wait_for_span(rom_load_data *romdata, const region_span *span)
+{
+	deferred_load *load;
+
+	for (load = deferred_list; load != NULL; load = load->next)
+		if (spans_overlap(&load->span, span))
+		{
+			finish_deferred_loads(romdata);
+			break;
+		}
+}
+
+
+/*-------------------------------------------------
+    copy_rom_chunk - copy a buffer of ROM data
+    into the region, grouping, skipping,
+    reversing and masking as requested; returns
+    the next target address
+-------------------------------------------------*/
+
+static UINT8 *copy_rom_chunk(UINT8 *base, const UINT8 *bufptr, int bytesleft, int groupsize, int skip, int reversed, int datamask, int datashift)
+{
+	int i;
+
+	/* unmasked cases */
+	if (datamask == 0xff)
+	{
+		/* non-grouped data */
+		if (groupsize == 1)
+			for (i = 0; i < bytesleft; i++, base += skip)
+				*base = *bufptr++;
+
+		/* grouped data -- non-reversed case */
+		else if (!reversed)
+			while (bytesleft)
+			{
+				for (i = 0; i < groupsize && bytesleft; i++, bytesleft--)
+					base[i] = *bufptr++;
+				base += skip;
+			}
+
+		/* grouped data -- reversed case */
+		else
+			while (bytesleft)
+			{
+				for (i = groupsize - 1; i >= 0 && bytesleft; i--, bytesleft--)
+					base[i] = *bufptr++;
+				base += skip;
+			}
+	}
+
+	/* masked cases */
+	else
+	{
+		/* non-grouped data */
+		if (groupsize == 1)
+			for (i = 0; i < bytesleft; i++, base += skip)
+				*base = (*base & ~datamask) | ((*bufptr++ << datashift) & datamask);
+
+		/* grouped data -- non-reversed case */
+		else if (!reversed)
+			while (bytesleft)
+			{
+				for (i = 0; i < groupsize && bytesleft; i++, bytesleft--)
+					base[i] = (base[i] & ~datamask) | ((*bufptr++ << datashift) & datamask);
+				base += skip;
+			}
+
+		/* grouped data -- reversed case */
+		else
+			while (bytesleft)
+			{
+				for (i = groupsize - 1; i >= 0 && bytesleft; i--, bytesleft--)
+					base[i] = (base[i] & ~datamask) | ((*bufptr++ << datashift) & datamask);
+				base += skip;
+			}
+	}
+	return base;
+}
+
+
+/*-------------------------------------------------
+    read_rom_data - read ROM data for a single
+    entry
+-------------------------------------------------*/
+
+static int read_rom_data(rom_load_data *romdata, const rom_entry *romp)
+{
+	int datashift = ROM_GETBITSHIFT(romp);
+	int datamask = ((1 << ROM_GETBITWIDTH(romp)) - 1) << datashift;
+	int numbytes = ROM_GETLENGTH(romp);
+	int groupsize = ROM_GETGROUPSIZE(romp);
+	int skip = ROM_GETSKIPCOUNT(romp);
+	int reversed = ROM_ISREVERSED(romp);
+	UINT8 *base = romdata->regionbase + ROM_GETOFFSET(romp);
+	region_span span;
+
+	debugload("Loading ROM data: offs=%X len=%X mask=%02X group=%d skip=%d reverse=%d\n", ROM_GETOFFSET(romp), numbytes, datamask, groupsize, skip, reversed);
+
+	/* validate the entry and wait for any deferred loads into the same bytes */
+	get_rom_span(romdata, romp, &span);
+	wait_for_span(romdata, &span);
+
 	/* special case for simple loads */
 	if (datamask == 0xff && (groupsize == 1 || !reversed) && skip == 0)
 		return rom_fread(romdata, base, numbytes);
@@ -588,7 +765,6 @@ static int read_rom_data(rom_load_data *romdata, const rom_entry *romp)
 	{
 		int evengroupcount = (sizeof(romdata->tempbuf) / groupsize) * groupsize;
 		int bytesleft = (numbytes > evengroupcount) ? evengroupcount : numbytes;
-		UINT8 *bufptr = romdata->tempbuf;
 
 		/* read as much as we can */
 		debugload("  Reading %X bytes into buffer\n", bytesleft);
@@ -597,63 +773,133 @@ static int read_rom_data(rom_load_data *romdata, const rom_entry *romp)
 		numbytes -= bytesleft;
 
 		debugload("  Copying to %p\n", base);
+		base = copy_rom_chunk(base, romdata->tempbuf, bytesleft, groupsize, skip, reversed, datamask, datashift);
+	}
+	debugload("  All done\n");
+	return ROM_GETLENGTH(romp);
+}
 
-		/* unmasked cases */
-		if (datamask == 0xff)
-		{
-			/* non-grouped data */
-			if (groupsize == 1)
-				for (i = 0; i < bytesleft; i++, base += skip)
-					*base = *bufptr++;
-
-			/* grouped data -- non-reversed case */
-			else if (!reversed)
-				while (bytesleft)
-				{
-					for (i = 0; i < groupsize && bytesleft; i++, bytesleft--)
-						base[i] = *bufptr++;
-					base += skip;
-				}
 
-			/* grouped data -- reversed case */
-			else
-				while (bytesleft)
-				{
-					for (i = groupsize - 1; i >= 0 && bytesleft; i--, bytesleft--)
-						base[i] = *bufptr++;
-					base += skip;
-				}
-		}
+/*-------------------------------------------------
+    deferred_load_callback - load a whole file
+    into its region on a worker thread
+-------------------------------------------------*/
 
-		/* masked cases */
-		else
-		{
-			/* non-grouped data */
-			if (groupsize == 1)
-				for (i = 0; i < bytesleft; i++, base += skip)
-					*base = (*base & ~datamask) | ((*bufptr++ << datashift) & datamask);
-
-			/* grouped data -- non-reversed case */
-			else if (!reversed)
-				while (bytesleft)
-				{
-					for (i = 0; i < groupsize && bytesleft; i++, bytesleft--)
-						base[i] = (base[i] & ~datamask) | ((*bufptr++ << datashift) & datamask);
-					base += skip;
-				}
+static void *deferred_load_callback(void *param, int threadid)
+{
+	deferred_load *load = param;
+	UINT8 *data;
 
-			/* grouped data -- reversed case */
-			else
-				while (bytesleft)
-				{
-					for (i = groupsize - 1; i >= 0 && bytesleft; i--, bytesleft--)
-						base[i] = (base[i] & ~datamask) | ((*bufptr++ << datashift) & datamask);
-					base += skip;
-				}
-		}
+	/* simple loads go straight into the region; interleaved ones are staged */
+	if ((load->groupsize == 1 || !load->reversed) && load->skip == 0)
+		data = load->span.start;
+	else
+	{
+		data = malloc(load->length);
+		if (data == NULL)
+			return NULL;
 	}
-	debugload("  All done\n");
-	return ROM_GETLENGTH(romp);
+
+	/* load the data, and hash it unless that was done on an earlier run */
+	load->actlength = mame_fload(load->file, data, load->length);
+	if (!load->cached)
+		hash_compute(load->hash, data, load->actlength, load->functions);
+
+	/* spread staged data across the region */
+	if (data != load->span.start)
+	{
+		copy_rom_chunk(load->span.start, data, load->actlength, load->groupsize, load->groupsize + load->skip, load->reversed, 0xff, 0);
+		free(data);
+	}
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    defer_rom_data - hand a whole-file load off
+    to the worker threads; returns TRUE if the
+    file was taken
+-------------------------------------------------*/
+
+static int defer_rom_data(rom_load_data *romdata, const rom_entry *romp, UINT32 *lastflags)
+{
+	rom_entry modified_romp = *romp;
+	deferred_load *load;
+	region_span span;
+
+	/* continues, ignores and reloads need the file more than once */
+	if (rom_queue == NULL || ROMENTRY_ISCONTINUE(romp + 1) || ROMENTRY_ISIGNORE(romp + 1) || ROMENTRY_ISRELOAD(romp + 1))
+		return FALSE;
+
+	/* handle flag inheritance */
+	if (!ROM_INHERITSFLAGS(&modified_romp))
+		*lastflags = modified_romp._flags;
+	else
+		modified_romp._flags = (modified_romp._flags & ~ROM_INHERITEDFLAGS) | *lastflags;
+
+	/* masked loads merge with what is there, and bad lengths are reported by the normal path */
+	if (ROM_GETBITWIDTH(&modified_romp) != 8 || ROM_GETBITSHIFT(&modified_romp) != 0 || mame_fsize(romdata->file) != ROM_GETLENGTH(&modified_romp))
+		return FALSE;
+
+	/* validate the entry and make sure earlier loads into the same bytes land first */
+	get_rom_span(romdata, &modified_romp, &span);
+	wait_for_span(romdata, &span);
+
+	/* fill in the load */
+	load = malloc_or_die(sizeof(*load));
+	memset(load, 0, sizeof(*load));
+	load->romp = romp;
+	load->file = romdata->file;
+	load->span = span;
+	load->length = ROM_GETLENGTH(&modified_romp);
+	load->groupsize = ROM_GETGROUPSIZE(&modified_romp);
+	load->skip = ROM_GETSKIPCOUNT(&modified_romp);
+	load->reversed = ROM_ISREVERSED(&modified_romp);
+	load->functions = hash_data_used_functions(ROM_GETHASHDATA(romp));
+	load->cached = mame_fhash_cached(romdata->file, load->functions);
+	romdata->file = NULL;
+
+	/* add to the list and queue it */
+	*deferred_tailptr = load;
+	deferred_tailptr = &load->next;
+	debugload("Deferring ROM load: %s\n", ROM_GETNAME(romp));
+	if (osd_work_item_queue(rom_queue, deferred_load_callback, load, WORK_ITEM_FLAG_AUTO_RELEASE) == NULL)
+		deferred_load_callback(load, 0);
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    finish_deferred_loads - wait for all
+    deferred loads, then verify and close them
+-------------------------------------------------*/
+
+static void finish_deferred_loads(rom_load_data *romdata)
+{
+	deferred_load *load;
+
+	/* nothing to do if nothing is pending */
+	if (deferred_list == NULL)
+		return;
+	while (!osd_work_queue_wait(rom_queue, 100 * osd_ticks_per_second())) ;
+
+	/* verify in the order the files were opened */
+	while ((load = deferred_list) != NULL)
+	{
+		deferred_list = load->next;
+
+		/* pick up the cached hash, or remember the one we computed */
+		if (load->cached)
+			hash_data_copy(load->hash, mame_fhash(load->file, load->functions));
+		else if (load->actlength == load->length)
+			mame_fhash_update(load->file, load->hash);
+
+		if (romdata != NULL)
+			compare_length_and_hash(romdata, ROM_GETNAME(load->romp), load->length, ROM_GETHASHDATA(load->romp), load->actlength, load->hash);
+		mame_fclose(load->file);
+		free(load);
+	}
+	deferred_tailptr = &deferred_list;
 }
 
 
@@ -665,6 +911,7 @@ static void fill_rom_data(rom_load_data *romdata, const rom_entry *romp)
 {
 	UINT32 numbytes = ROM_GETLENGTH(romp);
 	UINT8 *base = romdata->regionbase + ROM_GETOFFSET(romp);
+	region_span span;
 
 	/* make sure we fill within the region space */
 	if (ROM_GETOFFSET(romp) + numbytes > romdata->regionlength)
@@ -674,6 +921,11 @@ static void fill_rom_data(rom_load_data *romdata, const rom_entry *romp)
 	if (numbytes == 0)
 		fatalerror("Error in RomModule definition: FILL has an invalid length\n");
 
+	/* wait for any deferred loads into the same bytes */
+	span.start = base;
+	span.length = span.groupsize = span.stride = numbytes;
+	wait_for_span(romdata, &span);
+
 	/* fill the data (filling value is stored in place of the hashdata) */
 	memset(base, (FPTR)ROM_GETHASHDATA(romp) & 0xff, numbytes);
 }
@@ -708,6 +960,9 @@ static void copy_rom_data(rom_load_data *romdata, const rom_entry *romp)
 	if (srcoffs + numbytes > memory_region_length(srcregion))
 		fatalerror("Error in RomModule definition: COPY out of source memory region space\n");
 
+	/* the source may still be loading */
+	finish_deferred_loads(romdata);
+
 	/* fill the data */
 	memcpy(base, srcbase + srcoffs, numbytes);
 }
@@ -759,6 +1014,13 @@ static void process_rom_entries(rom_load_data *romdata, const rom_entry *romp)
 				if (!open_rom_file(romdata, romp))
 					handle_missing_file(romdata, romp);
 
+				/* whole-file loads can finish on the worker threads */
+				else if (defer_rom_data(romdata, romp, &lastflags))
+				{
+					romp++;
+					continue;
+				}
+
 				/* loop until we run out of reloads */
 				do
 				{
@@ -1078,6 +1340,11 @@ void rom_init(running_machine *machine, const rom_entry *romp)
 	chd_list = NULL;
 	chd_list_tailptr = &chd_list;
 
+	/* set up the worker threads for loading whole files */
+	rom_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	deferred_list = NULL;
+	deferred_tailptr = &deferred_list;
+
 	/* loop until we hit the end */
 	for (region = romp, regnum = 0; region; region = rom_next_region(region), regnum++)
 	{
@@ -1118,6 +1385,12 @@ void rom_init(running_machine *machine, const rom_entry *romp)
 			regionlist[regiontype] = region;
 	}
 
+	/* wait for the last of the deferred loads */
+	finish_deferred_loads(&romdata);
+	if (rom_queue != NULL)
+		osd_work_queue_free(rom_queue);
+	rom_queue = NULL;
+
 	/* post-process the regions */
 	for (regnum = 0; regnum < REGION_MAX; regnum++)
 		if (regionlist[regnum])
@@ -1144,6 +1417,14 @@ static void rom_exit(running_machine *machine)
 	open_chd *curchd;
 	int i;
 
+	/* if we bailed out mid-load, let the workers finish before freeing their targets */
+	if (rom_queue != NULL)
+	{
+		finish_deferred_loads(NULL);
+		osd_work_queue_free(rom_queue);
+		rom_queue = NULL;
+	}
+
 	/* free the memory allocated for various regions */
 	for (i = 0; i < MAX_MEMORY_REGIONS; i++)
 		free_memory_region(machine, i);
@@ -1151,6 +1432,13 @@ static void rom_exit(running_machine *machine)
 	/* close all hard drives */
 	for (curchd = chd_list; curchd != NULL; curchd = curchd->next)
 	{
+		chd_cache_stats stats;
+
+		/* report how well the hunk cache did */
+		if (chd_get_cache_stats((curchd->diffchd != NULL) ? curchd->diffchd : curchd->origchd, &stats) == CHDERR_NONE && stats.hits + stats.misses > 0)
+			mame_printf_verbose("CHD hunk cache: %u hits, %u misses, %u read ahead, %.3f s decompressing\n",
+					(UINT32)stats.hits, (UINT32)stats.misses, (UINT32)stats.readahead, (double)stats.decompress_time / osd_ticks_per_second());
+
 		if (curchd->diffchd != NULL)
 			chd_close(curchd->diffchd);
 		if (curchd->difffile != NULL)
@@ -770,6 +770,7 @@ static TIMER_CALLBACK( sound_update )
 		osd_update_audio_stream(finalmix, finalmix_offset / 2);
 		if (wavfile != NULL)
 			wav_add_data_16(wavfile, finalmix, finalmix_offset);
+		video_avi_add_sound(machine, finalmix, finalmix_offset / 2);
 	}
 
 	/* update the streamer */
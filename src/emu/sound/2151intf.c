@@ -29,13 +29,6 @@ static void ym2151_update(void *param, stream_sample_t **inputs, stream_sample_t
 }
 
 
-static void ym2151_postload(void *param)
-{
-	struct ym2151_info *info = param;
-	YM2151Postload(info->chip);
-}
-
-
 static void *ym2151_start(int sndindex, int clock, const void *config)
 {
 	static const struct YM2151interface dummy = { 0 };
@@ -54,8 +47,6 @@ static void *ym2151_start(int sndindex, int clock, const void *config)
 
 	info->chip = YM2151Init(sndindex,clock,rate);
 
-	state_save_register_func_postload_ptr(ym2151_postload, info);
-
 	if (info->chip != 0)
 	{
 		YM2151SetIrqHandler(info->chip,info->intf->irqhandler);
@@ -124,6 +124,30 @@ void dst_crfilter_step(node_description *node)
 	}
 }
 
+void dst_crfilter_step_block(node_description *node, int samples)
+{
+	struct dst_rcfilter_context *context = node->context;
+	const double *enable = node->input_block[0];
+	const double *in = node->input_block[1];
+	const double *vref = node->input_block[4];
+	double *out = node->output_block;
+	double vCap = context->vCap;
+	double exponent = context->exponent;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		if (enable[i])
+		{
+			out[i] = in[i] - vCap;
+			vCap += ((in[i] - vref[i]) - vCap) * exponent;
+		}
+		else
+			out[i] = 0;
+	}
+	context->vCap = vCap;
+}
+
 void dst_crfilter_reset(node_description *node)
 {
 	struct dst_rcfilter_context *context = node->context;
@@ -193,6 +217,28 @@ void dst_filter1_step(node_description *node)
 	context->y1 = node->output;
 }
 
+void dst_filter1_step_block(node_description *node, int samples)
+{
+	struct dss_filter1_context *context = node->context;
+	const double *enable = node->input_block[0];
+	const double *in = node->input_block[1];
+	double *out = node->output_block;
+	double a1 = context->a1, b0 = context->b0, b1 = context->b1;
+	double x1 = context->x1, y1 = context->y1;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		double gain = (enable[i] == 0.0) ? 0.0 : 1.0;
+
+		y1 = -a1*y1 + b0*gain*in[i] + b1*x1;
+		x1 = gain*in[i];
+		out[i] = y1;
+	}
+	context->x1 = x1;
+	context->y1 = y1;
+}
+
 void dst_filter1_reset(node_description *node)
 {
 	struct dss_filter1_context *context = node->context;
@@ -280,6 +326,35 @@ void dst_filter2_step(node_description *node)
 	context->y1 = node->output;
 }
 
+void dst_filter2_step_block(node_description *node, int samples)
+{
+	struct dss_filter2_context *context = node->context;
+	const double *enable = node->input_block[0];
+	const double *in = node->input_block[1];
+	double *out = node->output_block;
+	double a1 = context->a1, a2 = context->a2;
+	double b0 = context->b0, b1 = context->b1, b2 = context->b2;
+	double x1 = context->x1, x2 = context->x2;
+	double y1 = context->y1, y2 = context->y2;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		double gain = (enable[i] == 0.0) ? 0.0 : 1.0;
+		double y0 = -a1*y1 - a2*y2 + b0*gain*in[i] + b1*x1 + b2*x2;
+
+		x2 = x1;
+		x1 = gain * in[i];
+		y2 = y1;
+		y1 = y0;
+		out[i] = y0;
+	}
+	context->x1 = x1;
+	context->x2 = x2;
+	context->y1 = y1;
+	context->y2 = y2;
+}
+
 void dst_filter2_reset(node_description *node)
 {
 	struct dss_filter2_context *context = node->context;
@@ -1066,6 +1141,30 @@ void dst_rcfilter_step(node_description *node)
 	}
 }
 
+void dst_rcfilter_step_block(node_description *node, int samples)
+{
+	struct dst_rcfilter_context *context = node->context;
+	const double *enable = node->input_block[0];
+	const double *vin = node->input_block[1];
+	const double *vref = node->input_block[4];
+	double *out = node->output_block;
+	double vCap = context->vCap;
+	double exponent = context->exponent;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		if (enable[i])
+		{
+			vCap += ((vin[i] - vref[i] - vCap) * exponent);
+			out[i] = vCap + vref[i];
+		}
+		else
+			out[i] = 0;
+	}
+	context->vCap = vCap;
+}
+
 void dst_rcfilter_reset(node_description *node)
 {
 	struct dst_rcfilter_context *context = node->context;
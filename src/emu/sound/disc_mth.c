@@ -175,6 +175,20 @@ void dst_adder_step(node_description *node)
 	}
 }
 
+void dst_adder_step_block(node_description *node, int samples)
+{
+	const double *enable = node->input_block[0];
+	const double *in0 = node->input_block[1];
+	const double *in1 = node->input_block[2];
+	const double *in2 = node->input_block[3];
+	const double *in3 = node->input_block[4];
+	double *out = node->output_block;
+	int i;
+
+	for (i = 0; i < samples; i++)
+		out[i] = enable[i] ? in0[i] + in1[i] + in2[i] + in3[i] : 0;
+}
+
 
 /************************************************************************
  *
@@ -254,6 +268,29 @@ void dst_clamp_step(node_description *node)
 	}
 }
 
+void dst_clamp_step_block(node_description *node, int samples)
+{
+	const double *enable = node->input_block[0];
+	const double *in = node->input_block[1];
+	const double *min = node->input_block[2];
+	const double *max = node->input_block[3];
+	const double *clamp = node->input_block[4];
+	double *out = node->output_block;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		if (!enable[i])
+			out[i] = clamp[i];
+		else if (in[i] < min[i])
+			out[i] = min[i];
+		else if (in[i] > max[i])
+			out[i] = max[i];
+		else
+			out[i] = in[i];
+	}
+}
+
 
 /************************************************************************
  *
@@ -440,6 +477,28 @@ void dst_divide_step(node_description *node)
 	}
 }
 
+void dst_divide_step_block(node_description *node, int samples)
+{
+	const double *enable = node->input_block[0];
+	const double *in = node->input_block[1];
+	const double *div = node->input_block[2];
+	double *out = node->output_block;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		if (!enable[i])
+			out[i] = 0;
+		else if (div[i] == 0)
+		{
+			out[i] = DBL_MAX;	/* Max out but don't break */
+			discrete_log("dst_divider_step() - Divide by Zero attempted in NODE_%02d.\n",node->node-NODE_START);
+		}
+		else
+			out[i] = in[i] / div[i];
+	}
+}
+
 
 /************************************************************************
  *
@@ -469,6 +528,19 @@ void dst_gain_step(node_description *node)
 	}
 }
 
+void dst_gain_step_block(node_description *node, int samples)
+{
+	const double *enable = node->input_block[0];
+	const double *in = node->input_block[1];
+	const double *gain = node->input_block[2];
+	const double *offset = node->input_block[3];
+	double *out = node->output_block;
+	int i;
+
+	for (i = 0; i < samples; i++)
+		out[i] = enable[i] ? in[i] * gain[i] + offset[i] : 0;
+}
+
 
 /************************************************************************
  *
@@ -611,6 +683,17 @@ void dst_logic_inv_step(node_description *node)
 	}
 }
 
+void dst_logic_inv_step_block(node_description *node, int samples)
+{
+	const double *enable = node->input_block[0];
+	const double *in = node->input_block[1];
+	double *out = node->output_block;
+	int i;
+
+	for (i = 0; i < samples; i++)
+		out[i] = (enable[i] && !in[i]) ? 1.0 : 0.0;
+}
+
 /************************************************************************
  *
  * DST_LOGIC_AND - Logic AND gate implementation
@@ -1459,6 +1542,19 @@ void dst_switch_step(node_description *node)
 	}
 }
 
+void dst_switch_step_block(node_description *node, int samples)
+{
+	const double *enable = node->input_block[0];
+	const double *sw = node->input_block[1];
+	const double *in0 = node->input_block[2];
+	const double *in1 = node->input_block[3];
+	double *out = node->output_block;
+	int i;
+
+	for (i = 0; i < samples; i++)
+		out[i] = enable[i] ? (sw[i] ? in1[i] : in0[i]) : 0;
+}
+
 /************************************************************************
  *
  * DSS_ASWITCH - Analog switch
@@ -1230,6 +1230,26 @@ void dss_sinewave_step(node_description *node)
 	context->phase=fmod((context->phase+((2.0*M_PI*DSS_SINEWAVE__FREQ)/discrete_current_context->sample_rate)),2.0*M_PI);
 }
 
+void dss_sinewave_step_block(node_description *node, int samples)
+{
+	struct dss_sinewave_context *context = node->context;
+	const double *enable = node->input_block[0];
+	const double *freq = node->input_block[1];
+	const double *ampl = node->input_block[2];
+	const double *bias = node->input_block[3];
+	double *out = node->output_block;
+	double phase = context->phase;
+	int sample_rate = discrete_current_context->sample_rate;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		out[i] = enable[i] ? (ampl[i]/2.0) * sin(phase) + bias[i] : 0;
+		phase = fmod((phase+((2.0*M_PI*freq[i])/sample_rate)),2.0*M_PI);
+	}
+	context->phase = phase;
+}
+
 void dss_sinewave_reset(node_description *node)
 {
 	struct dss_sinewave_context *context = node->context;
@@ -1296,6 +1316,33 @@ void dss_squarewave_step(node_description *node)
 	context->phase=fmod((context->phase+((2.0*M_PI*DSS_SQUAREWAVE__FREQ)/discrete_current_context->sample_rate)),2.0*M_PI);
 }
 
+void dss_squarewave_step_block(node_description *node, int samples)
+{
+	struct dss_squarewave_context *context = node->context;
+	const double *enable = node->input_block[0];
+	const double *freq = node->input_block[1];
+	const double *amp = node->input_block[2];
+	const double *duty = node->input_block[3];
+	const double *bias = node->input_block[4];
+	double *out = node->output_block;
+	double phase = context->phase;
+	int sample_rate = discrete_current_context->sample_rate;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		/* Establish trigger phase from duty */
+		context->trigger=((100-duty[i])/100)*(2.0*M_PI);
+
+		if (enable[i])
+			out[i] = ((phase > context->trigger) ? (amp[i]/2.0) : -(amp[i]/2.0)) + bias[i];
+		else
+			out[i] = 0;
+		phase = fmod((phase+((2.0*M_PI*freq[i])/sample_rate)),2.0*M_PI);
+	}
+	context->phase = phase;
+}
+
 void dss_squarewave_reset(node_description *node)
 {
 	struct dss_squarewave_context *context = node->context;
@@ -1660,6 +1707,30 @@ void dss_trianglewave_step(node_description *node)
 	context->phase=fmod((context->phase+((2.0*M_PI*DSS_TRIANGLEWAVE__FREQ)/discrete_current_context->sample_rate)),2.0*M_PI);
 }
 
+void dss_trianglewave_step_block(node_description *node, int samples)
+{
+	struct dss_trianglewave_context *context = node->context;
+	const double *enable = node->input_block[0];
+	const double *freq = node->input_block[1];
+	const double *amp = node->input_block[2];
+	const double *bias = node->input_block[3];
+	double *out = node->output_block;
+	double phase = context->phase;
+	int sample_rate = discrete_current_context->sample_rate;
+	int i;
+
+	for (i = 0; i < samples; i++)
+	{
+		if (enable[i])
+			out[i] = (phase < M_PI ? (amp[i] * (phase / (M_PI/2.0) - 1.0))/2.0 :
+								(amp[i] * (3.0 - phase / (M_PI/2.0)))/2.0) + bias[i];
+		else
+			out[i] = 0;
+		phase = fmod((phase+((2.0*M_PI*freq[i])/sample_rate)),2.0*M_PI);
+	}
+	context->phase = phase;
+}
+
 void dss_trianglewave_reset(node_description *node)
 {
 	struct dss_trianglewave_context *context = node->context;
@@ -93,6 +93,14 @@
  * the perfect solution but saves repeatedly traversing the netlist
  * until all nodes have settled.
  *
+ * When a netlist has no feedback loops it is run a block of
+ * DISCRETE_BLOCK_SIZE samples at a time: each node is stepped over
+ * the whole block before moving on to the next node.  Modules that
+ * provide a step_block function process the block directly from
+ * per-sample buffers; all others are stepped one sample at a time
+ * with their inputs pointed into those buffers, so the results are
+ * the same as with the sample by sample update.
+ *
  * The best way to work out your system is generally to use a pen and
  * paper to draw a logical block diagram like the one above, it helps
  * to understand the system ,map the inputs and outputs and to work
@@ -3036,6 +3044,7 @@
 #define DISCRETE_MAX_OUTPUTS			16
 #define DISCRETE_MAX_WAVELOGS			10
 #define DISCRETE_MAX_CSVLOGS			10
+#define DISCRETE_BLOCK_SIZE				64
 
 
 
@@ -3261,6 +3270,7 @@ struct _discrete_module
 	size_t			contextsize;
 	void (*reset)(node_description *node);	/* Called to reset a node after creation or system reset */
 	void (*step)(node_description *node);	/* Called to execute one time delta of output update */
+	void (*step_block)(node_description *node, int samples);	/* Optional: execute samples time deltas into output_block */
 };
 typedef struct _discrete_module discrete_module;
 
@@ -3280,6 +3290,9 @@ struct _node_description
 	int				input_is_node;				/* Bit Flags.  1 in bit location means input_is_node */
 	const double *	input[DISCRETE_MAX_INPUTS];	/* Addresses of Input values */
 
+	double *		output_block;				/* Per-sample output values in block mode */
+	const double *	input_block[DISCRETE_MAX_INPUTS];	/* Per-sample input values in block mode */
+
 	discrete_module module;						/* Copy of the node's module info */
 	const discrete_sound_block *block;			/* Points to the node's setup block. */
 	void *			context;					/* Contextual information specific to this node type */
@@ -23,12 +23,28 @@
 
 #include <math.h>
 
-#include "sndintrf.h"
+#include "driver.h"
 #include "streams.h"
 #include "okim6295.h"
 
 #define MAX_SAMPLE_CHUNK	10000
 
+#define PHRASE_CACHE_HASH	64
+
+
+/* a phrase decoded to PCM; filled in as the phrase is played */
+struct phrase_cache
+{
+	struct phrase_cache *next;	/* next entry in the hash chain */
+	UINT32 offset;			/* ROM offset of the phrase (bank + start) */
+	UINT32 count;			/* total samples in the phrase */
+	UINT32 valid;			/* number of samples decoded so far */
+	UINT32 lastused;		/* value of usecount when the phrase was last started */
+	struct adpcm_state adpcm;/* ADPCM state after the last decoded sample */
+	UINT8 *rom;				/* copy of the ROM data the PCM came from */
+	INT16 *data;			/* decoded samples, before volume scaling */
+};
+
 
 /* struct describing a single playing ADPCM voice */
 struct ADPCMVoice
@@ -41,6 +57,9 @@ struct ADPCMVoice
 
 	struct adpcm_state adpcm;/* current ADPCM state */
 	UINT32 volume;			/* output volume */
+
+	struct phrase_cache *cache;	/* decoded phrase, or NULL to decode from ROM */
+	UINT8 rebuild;			/* 1 if adpcm must be recomputed before decoding from ROM */
 };
 
 struct okim6295
@@ -50,8 +69,14 @@ struct okim6295
 	INT32 command;
 	INT32 bank_offset;
 	UINT8 *region_base;		/* pointer to the base of the region */
+	UINT32 region_length;	/* length of the region */
 	sound_stream *stream;	/* which stream are we playing on? */
 	UINT32 master_clock;	/* master clock frequency */
+
+	struct phrase_cache *cache[PHRASE_CACHE_HASH];	/* decoded phrases */
+	UINT32 cache_size;		/* bytes held by decoded phrases */
+	UINT32 cache_budget;	/* maximum bytes for decoded phrases; 0 disables */
+	UINT32 usecount;		/* incremented each time a cached phrase is started */
 };
 
 /* step size index shift table */
@@ -178,6 +203,165 @@ INT16 clock_adpcm(struct adpcm_state *state, UINT8 nibble)
 
 
 
+/**********************************************************************************************
+
+     phrase cache -- phrases are decoded once and replayed from PCM afterwards
+
+     Each phrase is keyed by its ROM offset and length. The decoded samples do not
+     depend on the volume, so a phrase is cached the first time it plays and later
+     plays just scale the PCM. Since some drivers bank by copying data into the
+     sound region, a copy of the source bytes is kept and compared when the phrase
+     is started again. Once the budget is full, the least recently started phrases
+     that no voice is playing are freed to make room.
+
+***********************************************************************************************/
+
+INLINE UINT32 phrase_cache_bytes(UINT32 count)
+{
+	return sizeof(struct phrase_cache) + count / 2 + count * sizeof(INT16);
+}
+
+
+static void phrase_cache_evict(struct okim6295 *chip, UINT32 needed)
+{
+	while (chip->cache_size + needed > chip->cache_budget)
+	{
+		struct phrase_cache **victim = NULL, **link, *entry;
+		UINT32 oldest = 0;
+		int i, v;
+
+		/* find the least recently started phrase that no voice is playing */
+		for (i = 0; i < PHRASE_CACHE_HASH; i++)
+			for (link = &chip->cache[i]; *link != NULL; link = &(*link)->next)
+			{
+				entry = *link;
+				for (v = 0; v < OKIM6295_VOICES; v++)
+					if (chip->voice[v].cache == entry)
+						break;
+				if (v < OKIM6295_VOICES)
+					continue;
+				if (victim == NULL || chip->usecount - entry->lastused > oldest)
+				{
+					victim = link;
+					oldest = chip->usecount - entry->lastused;
+				}
+			}
+
+		/* if everything left is playing, there is no room */
+		if (victim == NULL)
+			break;
+
+		entry = *victim;
+		*victim = entry->next;
+		chip->cache_size -= phrase_cache_bytes(entry->count);
+		free(entry);
+	}
+}
+
+
+static struct phrase_cache *phrase_cache_find(struct okim6295 *chip, UINT32 offset, UINT32 count)
+{
+	const UINT8 *rom = chip->region_base + offset;
+	UINT32 bytes = count / 2;
+	struct phrase_cache **bucket = &chip->cache[(offset >> 4) % PHRASE_CACHE_HASH];
+	struct phrase_cache *entry;
+	int i;
+
+	if (offset + bytes > chip->region_length)
+		return NULL;
+
+	for (entry = *bucket; entry != NULL; entry = entry->next)
+		if (entry->offset == offset && entry->count == count)
+			break;
+
+	/* create a new entry, making room for it if needed */
+	if (entry == NULL)
+	{
+		UINT32 size = phrase_cache_bytes(count);
+
+		if (size > chip->cache_budget)
+			return NULL;
+		phrase_cache_evict(chip, size);
+		if (chip->cache_size + size > chip->cache_budget)
+			return NULL;
+		chip->cache_size += size;
+
+		entry = malloc_or_die(size);
+		entry->offset = offset;
+		entry->count = count;
+		entry->data = (INT16 *)(entry + 1);
+		entry->rom = (UINT8 *)(entry->data + count);
+		entry->valid = 0;
+		entry->lastused = ++chip->usecount;
+		reset_adpcm(&entry->adpcm);
+		memcpy(entry->rom, rom, bytes);
+		entry->next = *bucket;
+		*bucket = entry;
+		return entry;
+	}
+
+	/* if the ROM data changed underneath us, start over unless a voice is still using it */
+	if (memcmp(entry->rom, rom, bytes) != 0)
+	{
+		for (i = 0; i < OKIM6295_VOICES; i++)
+			if (chip->voice[i].cache == entry)
+				return NULL;
+		entry->valid = 0;
+		reset_adpcm(&entry->adpcm);
+		memcpy(entry->rom, rom, bytes);
+	}
+	entry->lastused = ++chip->usecount;
+	return entry;
+}
+
+
+static void phrase_rebuild_adpcm(struct ADPCMVoice *voice, const UINT8 *base)
+{
+	UINT32 sample;
+
+	/* the ADPCM state depends only on the nibbles played so far */
+	reset_adpcm(&voice->adpcm);
+	for (sample = 0; sample < voice->sample; sample++)
+		clock_adpcm(&voice->adpcm, base[sample / 2] >> (((sample & 1) << 2) ^ 4));
+	voice->rebuild = 0;
+}
+
+
+static void phrase_cache_detach(struct okim6295 *chip, struct ADPCMVoice *voice)
+{
+	struct phrase_cache *entry = voice->cache;
+
+	if (entry == NULL)
+		return;
+
+	/* a voice replaying PCM has not been clocking its own ADPCM state; rebuild it */
+	if (voice->sample == entry->valid)
+	{
+		voice->adpcm = entry->adpcm;
+		voice->rebuild = 0;
+	}
+	else if (voice->sample < entry->valid)
+		phrase_rebuild_adpcm(voice, entry->rom);
+	voice->cache = NULL;
+}
+
+
+static void phrase_cache_free(struct okim6295 *chip)
+{
+	int i;
+
+	for (i = 0; i < PHRASE_CACHE_HASH; i++)
+		while (chip->cache[i] != NULL)
+		{
+			struct phrase_cache *entry = chip->cache[i];
+			chip->cache[i] = entry->next;
+			free(entry);
+		}
+	chip->cache_size = 0;
+}
+
+
+
 /**********************************************************************************************
 
      generate_adpcm -- general ADPCM decoding routine
@@ -190,23 +374,68 @@ static void generate_adpcm(struct okim6295 *chip, struct ADPCMVoice *voice, INT1
 	if (voice->playing)
 	{
 		UINT8 *base = chip->region_base + chip->bank_offset + voice->base_offset;
+		struct phrase_cache *entry = voice->cache;
 		int sample = voice->sample;
 		int count = voice->count;
 
+		/* replay whatever part of the phrase has already been decoded */
+		if (entry != NULL && sample < entry->valid)
+		{
+			const INT16 *pcm = &entry->data[sample];
+			int cached = entry->valid - sample;
+
+			if (cached > samples)
+				cached = samples;
+			samples -= cached;
+			sample += cached;
+			while (cached--)
+				*buffer++ = *pcm++ * voice->volume / 256;
+
+			if (sample >= count)
+			{
+				voice->playing = 0;
+				voice->cache = NULL;
+			}
+		}
+
+		/* at the end of the decoded part, pick up its ADPCM state and keep decoding */
+		if (entry != NULL && sample == entry->valid)
+		{
+			voice->adpcm = entry->adpcm;
+			voice->rebuild = 0;
+		}
+
+		/* a voice restored from a state save only knows its position */
+		if (samples && voice->playing && voice->rebuild)
+		{
+			voice->sample = sample;
+			phrase_rebuild_adpcm(voice, base);
+		}
+
 		/* loop while we still have samples to generate */
-		while (samples)
+		while (samples && voice->playing)
 		{
 			/* compute the new amplitude and update the current step */
 			int nibble = base[sample / 2] >> (((sample & 1) << 2) ^ 4);
+			INT16 value = clock_adpcm(&voice->adpcm, nibble);
+
+			/* extend the cached phrase if we are the furthest along */
+			if (entry != NULL && sample == entry->valid)
+			{
+				entry->data[sample] = value;
+				entry->valid++;
+				entry->adpcm = voice->adpcm;
+			}
 
 			/* output to the buffer, scaling by the volume */
-			*buffer++ = clock_adpcm(&voice->adpcm, nibble) * voice->volume / 256;
+			*buffer++ = value * voice->volume / 256;
 			samples--;
 
 			/* next! */
 			if (++sample >= count)
 			{
 				voice->playing = 0;
+				voice->cache = NULL;
 				break;
 			}
 		}
@@ -297,6 +526,41 @@ static void adpcm_state_save_register(struct ADPCMVoice *voice, int i)
 	state_save_register_item(buf, i, voice->adpcm.step);
 	state_save_register_item(buf, i, voice->volume);
 	state_save_register_item(buf, i, voice->base_offset);
+	state_save_register_item(buf, i, voice->rebuild);
+}
+
+static void okim6295_presave(void *param)
+{
+	struct okim6295 *info = param;
+	int i;
+
+	/* voices replaying from the cache save only their position */
+	for (i = 0; i < OKIM6295_VOICES; i++)
+		if (info->voice[i].cache != NULL)
+			info->voice[i].rebuild = 1;
+}
+
+static void okim6295_postload(void *param)
+{
+	struct okim6295 *info = param;
+	int i;
+
+	for (i = 0; i < OKIM6295_VOICES; i++)
+	{
+		struct ADPCMVoice *voice = &info->voice[i];
+		struct phrase_cache *entry = NULL;
+
+		voice->cache = NULL;
+		if (!voice->playing || !voice->rebuild)
+			continue;
+
+		/* go back to replaying the phrase if it is still cached; otherwise the
+           ADPCM state is rebuilt from the ROM when it is next needed */
+		if (info->cache_budget != 0)
+			entry = phrase_cache_find(info, info->bank_offset + voice->base_offset, voice->count);
+		if (entry != NULL && voice->sample <= entry->valid)
+			voice->cache = entry;
+	}
 }
 
 static void okim6295_state_save_register(struct okim6295 *info, int sndindex)
@@ -310,6 +574,8 @@ static void okim6295_state_save_register(struct okim6295 *info, int sndindex)
 	state_save_register_item(buf, sndindex, info->bank_offset);
 	for (j = 0; j < OKIM6295_VOICES; j++)
 		adpcm_state_save_register(&info->voice[j], sndindex * 4 + j);
+	state_save_register_func_presave_ptr(okim6295_presave, info);
+	state_save_register_func_postload_ptr(okim6295_postload, info);
 }
 
 
@@ -335,8 +601,10 @@ static void *okim6295_start(int sndindex, int clock, const void *config)
 	info->command = -1;
 	info->bank_offset = 0;
 	info->region_base = memory_region(intf->region);
+	info->region_length = memory_region_length(intf->region);
 
 	info->master_clock = clock;
+	info->cache_budget = options_get_int(mame_options(), OPTION_ADPCMCACHE) * 1024;
 
 	/* generate the name and create the stream */
 	info->stream = stream_create(0, 1, clock/divisor, info, okim6295_update);
@@ -363,6 +631,19 @@ static void *okim6295_start(int sndindex, int clock, const void *config)
 
 ***********************************************************************************************/
 
+static void okim6295_stop(void *chip)
+{
+	phrase_cache_free(chip);
+}
+
+
+
+/**********************************************************************************************
+
+     OKIM6295_reset -- reset emulation of an OKIM6295-compatible chip
+
+***********************************************************************************************/
+
 static void okim6295_reset(void *chip)
 {
 	struct okim6295 *info = chip;
@@ -370,7 +651,10 @@ static void okim6295_reset(void *chip)
 
 	stream_update(info->stream);
 	for (i = 0; i < OKIM6295_VOICES; i++)
+	{
 		info->voice[i].playing = 0;
+		info->voice[i].cache = NULL;
+	}
 }
 
 
@@ -384,7 +668,14 @@ static void okim6295_reset(void *chip)
 void OKIM6295_set_bank_base(int which, int base)
 {
 	struct okim6295 *info = sndti_token(SOUND_OKIM6295, which);
+	int i;
+
 	stream_update(info->stream);
+
+	/* playing voices follow the new bank, so they can no longer replay from the cache */
+	if (base != info->bank_offset)
+		for (i = 0; i < OKIM6295_VOICES; i++)
+			phrase_cache_detach(info, &info->voice[i]);
 	info->bank_offset = base;
 }
 
@@ -477,7 +768,13 @@ static void OKIM6295_data_w(int num, int data)
 
 						/* also reset the ADPCM parameters */
 						reset_adpcm(&voice->adpcm);
+						voice->rebuild = 0;
 						voice->volume = volume_table[data & 0x0f];
+
+						/* replay from the decoded phrase if we have one */
+						voice->cache = NULL;
+						if (info->cache_budget != 0)
+							voice->cache = phrase_cache_find(info, info->bank_offset + start, voice->count);
 					}
 					else
 					{
@@ -519,6 +816,7 @@ static void OKIM6295_data_w(int num, int data)
 				struct ADPCMVoice *voice = &info->voice[i];
 
 				voice->playing = 0;
+				voice->cache = NULL;
 			}
 		}
 	}
@@ -662,7 +960,7 @@ void okim6295_get_info(void *token, UINT32 state, sndinfo *info)
 		/* --- the following bits of info are returned as pointers to data or functions --- */
 		case SNDINFO_PTR_SET_INFO:						info->set_info = okim6295_set_info;		break;
 		case SNDINFO_PTR_START:							info->start = okim6295_start;			break;
-		case SNDINFO_PTR_STOP:							/* nothing */							break;
+		case SNDINFO_PTR_STOP:							info->stop = okim6295_stop;				break;
 		case SNDINFO_PTR_RESET:							info->reset = okim6295_reset;			break;
 
 		/* --- the following bits of info are returned as NULL-terminated strings --- */
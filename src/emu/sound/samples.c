@@ -17,11 +17,24 @@ struct sample_channel
 	UINT8		paused;
 };
 
+struct sample_cache_entry
+{
+	UINT8		state;			/* SAMPLE_UNTRIED, SAMPLE_MISSING or SAMPLE_FOUND */
+	UINT32		lastused;		/* value of the use counter when last started */
+};
+
 struct samples_info
 {
 	int			numchannels;	/* how many channels */
 	struct sample_channel *channel;/* array of channels */
 	struct loaded_samples *samples;/* array of samples */
+
+	/* samples are loaded on first use and evicted least recently used first */
+	const char *const *samplenames;/* names of the samples to load */
+	struct sample_cache_entry *cache;/* per-sample load state */
+	UINT32		usecount;		/* incremented each time a sample is started */
+	UINT32		resident;		/* bytes of sample data currently loaded */
+	UINT32		budget;			/* maximum bytes of sample data to keep loaded; 0 for no limit */
 };
 
 
@@ -31,6 +44,10 @@ struct samples_info
 #define FRAC_MASK		(FRAC_ONE - 1)
 #define MAX_CHANNELS    100
 
+#define SAMPLE_UNTRIED	0
+#define SAMPLE_MISSING	1
+#define SAMPLE_FOUND	2
+
 
 /*-------------------------------------------------
     read_wav_sample - read a WAV file as a sample
@@ -42,7 +59,7 @@ struct samples_info
 #define intelLong(x) (((x << 24) | (((unsigned long) x) >> 24) | (( x & 0x0000ff00) << 8) | (( x & 0x00ff0000) >> 8)))
 #endif
 
-static int read_wav_sample(mame_file *f, struct loaded_sample *sample)
+static int read_wav_sample(mame_file *f, struct loaded_sample *sample, int evictable)
 {
 	unsigned long offset = 0;
 	UINT32 length, rate, filesize;
@@ -147,7 +164,7 @@ static int read_wav_sample(mame_file *f, struct loaded_sample *sample)
 		unsigned char *tempptr;
 		int sindex;
 
-		sample->data = auto_malloc(sizeof(*sample->data) * length);
+		sample->data = evictable ? malloc_or_die(sizeof(*sample->data) * length) : auto_malloc(sizeof(*sample->data) * length);
 		mame_fread(f, sample->data, length);
 
 		/* convert 8-bit data to signed samples */
@@ -158,7 +175,7 @@ static int read_wav_sample(mame_file *f, struct loaded_sample *sample)
 	else
 	{
 		/* 16-bit data is fine as-is */
-		sample->data = auto_malloc(sizeof(*sample->data) * (length/2));
+		sample->data = evictable ? malloc_or_die(sizeof(*sample->data) * (length/2)) : auto_malloc(sizeof(*sample->data) * (length/2));
 		mame_fread(f, sample->data, length);
 		sample->length /= 2;
 #ifndef LSB_FIRST
@@ -171,10 +188,11 @@ static int read_wav_sample(mame_file *f, struct loaded_sample *sample)
 
 
 /*-------------------------------------------------
-    readsamples - load all samples
+    alloc_samples - allocate an empty array of
+    samples for the given list of names
 -------------------------------------------------*/
 
-struct loaded_samples *readsamples(const char *const *samplenames, const char *basename)
+static struct loaded_samples *alloc_samples(const char *const *samplenames)
 {
 	struct loaded_samples *samples;
 	int skipfirst = 0;
@@ -199,33 +217,134 @@ struct loaded_samples *readsamples(const char *const *samplenames, const char *b
 	samples = auto_malloc(sizeof(struct loaded_samples) + (i-1) * sizeof(struct loaded_sample));
 	memset(samples, 0, sizeof(struct loaded_samples) + (i-1) * sizeof(struct loaded_sample));
 	samples->total = i;
+	return samples;
+}
+
+
+/*-------------------------------------------------
+    load_sample - open and read a single sample,
+    looking under the alternate basename if needed
+-------------------------------------------------*/
+
+static int load_sample(const char *const *samplenames, const char *basename, int samplenum, struct loaded_sample *sample, int evictable)
+{
+	int skipfirst = (samplenames[0][0] == '*') ? 1 : 0;
+	const char *name = samplenames[samplenum+skipfirst];
+	file_error filerr;
+	mame_file *f;
+	astring *fname;
+	int result = 0;
+
+	if (!name[0])
+		return 0;
+
+	fname = astring_assemble_3(astring_alloc(), basename, PATH_SEPARATOR, name);
+	filerr = mame_fopen(SEARCHPATH_SAMPLE, astring_c(fname), OPEN_FLAG_READ, &f);
+
+	if (filerr != FILERR_NONE && skipfirst)
+	{
+		astring_assemble_3(fname, samplenames[0] + 1, PATH_SEPARATOR, name);
+		filerr = mame_fopen(SEARCHPATH_SAMPLE, astring_c(fname), OPEN_FLAG_READ, &f);
+	}
+	if (filerr == FILERR_NONE)
+	{
+		result = read_wav_sample(f, sample, evictable);
+		mame_fclose(f);
+	}
+
+	astring_free(fname);
+	return result;
+}
+
+
+/*-------------------------------------------------
+    readsamples - load all samples
+-------------------------------------------------*/
+
+struct loaded_samples *readsamples(const char *const *samplenames, const char *basename)
+{
+	struct loaded_samples *samples = alloc_samples(samplenames);
+	int i;
 
 	/* load the samples */
-	for (i = 0; i < samples->total; i++)
-		if (samplenames[i+skipfirst][0])
-		{
-			file_error filerr;
-			mame_file *f;
-			astring *fname;
+	if (samples != NULL)
+		for (i = 0; i < samples->total; i++)
+			load_sample(samplenames, basename, i, &samples->sample[i], FALSE);
 
-			fname = astring_assemble_3(astring_alloc(), basename, PATH_SEPARATOR, samplenames[i+skipfirst]);
-			filerr = mame_fopen(SEARCHPATH_SAMPLE, astring_c(fname), OPEN_FLAG_READ, &f);
+	return samples;
+}
 
-			if (filerr != FILERR_NONE && skipfirst)
-			{
-				astring_assemble_3(fname, samplenames[0] + 1, PATH_SEPARATOR, samplenames[i+skipfirst]);
-				filerr = mame_fopen(SEARCHPATH_SAMPLE, astring_c(fname), OPEN_FLAG_READ, &f);
-			}
-			if (filerr == FILERR_NONE)
+
+/*-------------------------------------------------
+    sample_evict - free loaded samples, least
+    recently used first, until the data fits in
+    the budget; sample 'keep' is never freed
+-------------------------------------------------*/
+
+static void sample_evict(struct samples_info *info, int keep)
+{
+	while (info->resident > info->budget)
+	{
+		struct loaded_sample *victim = NULL;
+		UINT32 oldest = 0;
+		int i, ch;
+
+		/* find the least recently used sample that no channel is playing */
+		for (i = 0; i < info->samples->total; i++)
+		{
+			struct loaded_sample *sample = &info->samples->sample[i];
+
+			if (sample->data == NULL || i == keep)
+				continue;
+			for (ch = 0; ch < info->numchannels; ch++)
+				if (info->channel[ch].source == sample->data)
+					break;
+			if (ch < info->numchannels)
+				continue;
+			if (victim == NULL || info->usecount - info->cache[i].lastused > oldest)
 			{
-				read_wav_sample(f, &samples->sample[i]);
-				mame_fclose(f);
+				victim = sample;
+				oldest = info->usecount - info->cache[i].lastused;
 			}
-
-			astring_free(fname);
 		}
 
-	return samples;
+		/* if everything left is playing, we have to go over budget */
+		if (victim == NULL)
+			break;
+
+		info->resident -= victim->length * sizeof(*victim->data);
+		free(victim->data);
+		victim->data = NULL;
+	}
+}
+
+
+/*-------------------------------------------------
+    sample_fetch - make sure a sample is loaded,
+    reading it on first use or after eviction
+-------------------------------------------------*/
+
+static struct loaded_sample *sample_fetch(struct samples_info *info, int samplenum)
+{
+	struct loaded_sample *sample = &info->samples->sample[samplenum];
+	struct sample_cache_entry *entry = &info->cache[samplenum];
+
+	entry->lastused = ++info->usecount;
+	if (sample->data != NULL || entry->state == SAMPLE_MISSING)
+		return sample;
+
+	if (!load_sample(info->samplenames, Machine->gamedrv->name, samplenum, sample, TRUE))
+	{
+		entry->state = SAMPLE_MISSING;
+		return sample;
+	}
+	entry->state = SAMPLE_FOUND;
+
+	/* account for the new data, then make room for it without evicting it */
+	info->resident += sample->length * sizeof(*sample->data);
+	if (info->budget != 0)
+		sample_evict(info, samplenum);
+	return sample;
 }
 
 
@@ -253,7 +372,7 @@ void sample_start_n(int num,int channel,int samplenum,int loop)
 	stream_update(chan->stream);
 
 	/* update the parameters */
-	sample = &info->samples->sample[samplenum];
+	sample = sample_fetch(info, samplenum);
 	chan->source = sample->data;
 	chan->source_length = sample->length;
 	chan->source_num = sample->data ? samplenum : -1;
@@ -429,7 +548,10 @@ int sample_loaded_n(int num,int samplenum)
     {
         assert( samplenum < info->samples->total );
 
-        ret = (info->samples->sample[samplenum].data != NULL);
+        /* look for the sample the first time we're asked about it */
+        if (info->cache[samplenum].state == SAMPLE_UNTRIED)
+            sample_fetch(info, samplenum);
+        ret = (info->cache[samplenum].state == SAMPLE_FOUND);
     }
 
     return ret;
@@ -506,7 +628,7 @@ static void samples_postload(void *param)
 		/* attach any samples that were loaded and playing */
 		if (chan->source_num >= 0 && chan->source_num < info->samples->total)
 		{
-			struct loaded_sample *sample = &info->samples->sample[chan->source_num];
+			struct loaded_sample *sample = sample_fetch(info, chan->source_num);
 			chan->source = sample->data;
 			chan->source_length = sample->length;
 			if (!sample->data)
@@ -538,9 +660,16 @@ static void *samples_start(int sndindex, int clock, const void *config)
 	memset(info, 0, sizeof(*info));
 	sndintrf_register_token(info);
 
-	/* read audio samples */
+	/* set up the audio samples; they are read from disk on first use */
 	if (intf->samplenames)
-		info->samples = readsamples(intf->samplenames,Machine->gamedrv->name);
+		info->samples = alloc_samples(intf->samplenames);
+	if (info->samples != NULL)
+	{
+		info->samplenames = intf->samplenames;
+		info->cache = auto_malloc(sizeof(*info->cache) * info->samples->total);
+		memset(info->cache, 0, sizeof(*info->cache) * info->samples->total);
+		info->budget = options_get_int(mame_options(), OPTION_SAMPLECACHE) * 1024;
+	}
 
 	/* allocate channels */
 	info->numchannels = intf->channels;
@@ -575,6 +704,22 @@ static void *samples_start(int sndindex, int clock, const void *config)
 }
 
 
+static void samples_stop(void *token)
+{
+	struct samples_info *info = token;
+	int i;
+
+	/* free any sample data still loaded */
+	if (info->samples != NULL)
+		for (i = 0; i < info->samples->total; i++)
+			if (info->samples->sample[i].data != NULL)
+			{
+				free(info->samples->sample[i].data);
+				info->samples->sample[i].data = NULL;
+			}
+}
+
+
 
 /**************************************************************************
  * Generic get_info
@@ -598,7 +743,7 @@ void samples_get_info(void *token, UINT32 state, sndinfo *info)
 		/* --- the following bits of info are returned as pointers to data or functions --- */
         case SNDINFO_PTR_SET_INFO:                      info->set_info = samples_set_info;      break;
         case SNDINFO_PTR_START:                         info->start = samples_start;            break;
-        case SNDINFO_PTR_STOP:                          /* Nothing */                           break;
+        case SNDINFO_PTR_STOP:                          info->stop = samples_stop;              break;
         case SNDINFO_PTR_RESET:                         /* Nothing */                           break;
 
 		/* --- the following bits of info are returned as NULL-terminated strings --- */
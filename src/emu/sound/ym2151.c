@@ -38,10 +38,7 @@ typedef struct{
 	UINT32		dt1_i;					/* DT1 index * 32 */
 	UINT32		dt2;					/* current DT2 (detune 2) value */
 
-	signed int *connect;				/* operator output 'direction' */
-
 	/* only M1 (operator 0) is filled with this data: */
-	signed int *mem_connect;			/* where to put the delayed sample (MEM) */
 	INT32		mem_value;				/* delayed sample (MEM) value */
 
 	/* channel specific data; note: each operator number 0 contains channel specific data */
@@ -484,8 +481,6 @@ static const UINT8 lfo_noise_waveform[256] = {
 /* these variables stay here for speedup purposes only */
 static YM2151 * PSG;
 static signed int chanout[8];
-static signed int m2,c1,c2; /* Phase Modulation input for operators 2,3,4 */
-static signed int mem;		/* one sample delay memory */
 
 
 /* save output as raw 16-bit sample */
@@ -861,98 +856,6 @@ static TIMER_CALLBACK( timer_callback_chip_busy )
 
 
 
-INLINE void set_connect( YM2151Operator *om1, int cha, int v)
-{
-	YM2151Operator *om2 = om1+1;
-	YM2151Operator *oc1 = om1+2;
-
-	/* set connect algorithm */
-
-	/* MEM is simply one sample delay */
-
-	switch( v&7 )
-	{
-	case 0:
-		/* M1---C1---MEM---M2---C2---OUT */
-		om1->connect = &c1;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &m2;
-		break;
-
-	case 1:
-		/* M1------+-MEM---M2---C2---OUT */
-		/*      C1-+                     */
-		om1->connect = &mem;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &m2;
-		break;
-
-	case 2:
-		/* M1-----------------+-C2---OUT */
-		/*      C1---MEM---M2-+          */
-		om1->connect = &c2;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &m2;
-		break;
-
-	case 3:
-		/* M1---C1---MEM------+-C2---OUT */
-		/*                 M2-+          */
-		om1->connect = &c1;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &c2;
-		break;
-
-	case 4:
-		/* M1---C1-+-OUT */
-		/* M2---C2-+     */
-		/* MEM: not used */
-		om1->connect = &c1;
-		oc1->connect = &chanout[cha];
-		om2->connect = &c2;
-		om1->mem_connect = &mem;	/* store it anywhere where it will not be used */
-		break;
-
-	case 5:
-		/*    +----C1----+     */
-		/* M1-+-MEM---M2-+-OUT */
-		/*    +----C2----+     */
-		om1->connect = 0;	/* special mark */
-		oc1->connect = &chanout[cha];
-		om2->connect = &chanout[cha];
-		om1->mem_connect = &m2;
-		break;
-
-	case 6:
-		/* M1---C1-+     */
-		/*      M2-+-OUT */
-		/*      C2-+     */
-		/* MEM: not used */
-		om1->connect = &c1;
-		oc1->connect = &chanout[cha];
-		om2->connect = &chanout[cha];
-		om1->mem_connect = &mem;	/* store it anywhere where it will not be used */
-		break;
-
-	case 7:
-		/* M1-+     */
-		/* C1-+-OUT */
-		/* M2-+     */
-		/* C2-+     */
-		/* MEM: not used*/
-		om1->connect = &chanout[cha];
-		oc1->connect = &chanout[cha];
-		om2->connect = &chanout[cha];
-		om1->mem_connect = &mem;	/* store it anywhere where it will not be used */
-		break;
-	}
-}
-
-
 INLINE void refresh_EG(YM2151Operator * op)
 {
 	UINT32 kc;
@@ -1212,7 +1115,6 @@ void YM2151WriteReg(void *_chip, int r, int v)
 			chip->pan[ (r&7)*2    ] = (v & 0x40) ? ~0 : 0;
 			chip->pan[ (r&7)*2 +1 ] = (v & 0x80) ? ~0 : 0;
 			chip->connect[r&7] = v&7;
-			set_connect(op, r&7, v&7);
 			break;
 
 		case 0x08:	/* Key Code */
@@ -1385,15 +1287,6 @@ int YM2151ReadStatus( void *_chip )
 /*
 *   state save support for MAME
 */
-void YM2151Postload(void *chip)
-{
-	YM2151 *YM2151_chip = (YM2151 *)chip;
-	int j;
-
-	for (j=0; j<8; j++)
-		set_connect(&YM2151_chip->oper[j*4], j, YM2151_chip->connect[j]);
-}
-
 static void ym2151_state_save_register( YM2151 *chip, int sndindex )
 {
 	int j;
@@ -1492,14 +1385,8 @@ static void ym2151_state_save_register( YM2151 *chip, int sndindex )
 #endif
 
 	state_save_register_item_array(buf1, sndindex, chip->connect);
-
-	state_save_register_func_postload_ptr(YM2151Postload, chip);
 }
 #else
-void YM2151Postload(void *chip)
-{
-}
-
 static void ym2151_state_save_register( YM2151 *chip, int sndindex )
 {
 }
@@ -1694,114 +1581,151 @@ INLINE signed int op_calc1(YM2151Operator * OP, unsigned int env, signed int pm)
 
 #define volume_calc(OP) ((OP)->tl + ((UINT32)(OP)->volume) + (AM & (OP)->AMmask))
 
-INLINE void chan_calc(unsigned int chan)
+INLINE signed int op_out(YM2151Operator * OP, UINT32 AM, signed int pm)
 {
-	YM2151Operator *op;
-	unsigned int env;
-	UINT32 AM = 0;
-
-	m2 = c1 = c2 = mem = 0;
-	op = &PSG->oper[chan*4];	/* M1 */
-
-	*op->mem_connect = op->mem_value;	/* restore delayed sample (MEM) value to m2 or c2 */
+	unsigned int env = volume_calc(OP);
 
-	if (op->ams)
-		AM = PSG->lfa << (op->ams-1);
-	env = volume_calc(op);
-	{
-		INT32 out = op->fb_out_prev + op->fb_out_curr;
-		op->fb_out_prev = op->fb_out_curr;
-
-		if (!op->connect)
-			/* algorithm 5 */
-			mem = c1 = c2 = op->fb_out_prev;
-		else
-			/* other algorithms */
-			*op->connect = op->fb_out_prev;
-
-		op->fb_out_curr = 0;
-		if (env < ENV_QUIET)
-		{
-			if (!op->fb_shift)
-				out=0;
-			op->fb_out_curr = op_calc1(op, env, (out<<op->fb_shift) );
-		}
-	}
-
-	env = volume_calc(op+1);	/* M2 */
 	if (env < ENV_QUIET)
-		*(op+1)->connect += op_calc(op+1, env, m2);
+		return op_calc(OP, env, pm);
+	return 0;
+}
 
-	env = volume_calc(op+2);	/* C1 */
-	if (env < ENV_QUIET)
-		*(op+2)->connect += op_calc(op+2, env, c1);
+INLINE signed int noise_out(YM2151Operator * OP, UINT32 AM)
+{
+	unsigned int env = volume_calc(OP);
+	UINT32 noiseout;
 
-	env = volume_calc(op+3);	/* C2 */
-	if (env < ENV_QUIET)
-		chanout[chan]    += op_calc(op+3, env, c2);
+	noiseout = 0;
+	if (env < 0x3ff)
+		noiseout = (env ^ 0x3ff) * 2;	/* range of the YM2151 noise output is -2044 to 2040 */
+	return (PSG->noise_rng&0x10000) ? noiseout: -noiseout; /* bit 16 -> output */
+}
 
-	/* M1 */
-	op->mem_value = mem;
+/*  A channel is idle when all four operators sit at maximum attenuation:
+*   none of them can produce output then (env >= 0x3ff >= ENV_QUIET, also for
+*   noise), so once the feedback and MEM values have drained to zero, running
+*   chan_calc() would leave everything as it is. Algorithms 4, 6 and 7 keep
+*   their MEM value untouched, so it does not need to be zero for them.
+*   The envelope generator, LFO and noise keep running for idle channels.
+*/
+INLINE int chan_idle(YM2151Operator * op, UINT8 alg)
+{
+	if (op[0].volume < MAX_ATT_INDEX || op[1].volume < MAX_ATT_INDEX ||
+		op[2].volume < MAX_ATT_INDEX || op[3].volume < MAX_ATT_INDEX)
+		return 0;
+	if (op->fb_out_prev || op->fb_out_curr)
+		return 0;
+	return (op->mem_value == 0) || (alg == 4) || (alg == 6) || (alg == 7);
 }
-INLINE void chan7_calc(void)
+
+INLINE void chan_calc(unsigned int chan)
 {
 	YM2151Operator *op;
 	unsigned int env;
 	UINT32 AM = 0;
+	INT32 out, m1;
+	signed int c2, mem;
+	int noise = (chan == 7) && (PSG->noise & 0x80);
+	UINT8 alg = PSG->connect[chan];
 
-	m2 = c1 = c2 = mem = 0;
-	op = &PSG->oper[7*4];		/* M1 */
+	op = &PSG->oper[chan*4];	/* M1 */
 
-	*op->mem_connect = op->mem_value;	/* restore delayed sample (MEM) value to m2 or c2 */
+	if (chan_idle(op, alg))
+		return;
 
 	if (op->ams)
 		AM = PSG->lfa << (op->ams-1);
+
+	/* M1 feeds the rest of the channel with its previous output */
 	env = volume_calc(op);
+	out = op->fb_out_prev + op->fb_out_curr;
+	op->fb_out_prev = op->fb_out_curr;
+	m1 = op->fb_out_prev;
+
+	op->fb_out_curr = 0;
+	if (env < ENV_QUIET)
 	{
-		INT32 out = op->fb_out_prev + op->fb_out_curr;
-		op->fb_out_prev = op->fb_out_curr;
+		if (!op->fb_shift)
+			out=0;
+		op->fb_out_curr = op_calc1(op, env, (out<<op->fb_shift) );
+	}
 
-		if (!op->connect)
-			/* algorithm 5 */
-			mem = c1 = c2 = op->fb_out_prev;
-		else
-			/* other algorithms */
-			*op->connect = op->fb_out_prev;
+	/* op+1 is M2, op+2 is C1, op+3 is C2; MEM is simply one sample delay */
+	switch (alg)
+	{
+	case 0:
+		/* M1---C1---MEM---M2---C2---OUT */
+		c2 = op_out(op+1, AM, op->mem_value);
+		mem = op_out(op+2, AM, m1);
+		op->mem_value = mem;
+		break;
 
-		op->fb_out_curr = 0;
-		if (env < ENV_QUIET)
-		{
-			if (!op->fb_shift)
-				out=0;
-			op->fb_out_curr = op_calc1(op, env, (out<<op->fb_shift) );
-		}
-	}
+	case 1:
+		/* M1------+-MEM---M2---C2---OUT */
+		/*      C1-+                     */
+		c2 = op_out(op+1, AM, op->mem_value);
+		mem = m1 + op_out(op+2, AM, 0);
+		op->mem_value = mem;
+		break;
 
-	env = volume_calc(op+1);	/* M2 */
-	if (env < ENV_QUIET)
-		*(op+1)->connect += op_calc(op+1, env, m2);
+	case 2:
+		/* M1-----------------+-C2---OUT */
+		/*      C1---MEM---M2-+          */
+		c2 = m1 + op_out(op+1, AM, op->mem_value);
+		mem = op_out(op+2, AM, 0);
+		op->mem_value = mem;
+		break;
 
-	env = volume_calc(op+2);	/* C1 */
-	if (env < ENV_QUIET)
-		*(op+2)->connect += op_calc(op+2, env, c1);
+	case 3:
+		/* M1---C1---MEM------+-C2---OUT */
+		/*                 M2-+          */
+		c2 = op->mem_value + op_out(op+1, AM, 0);
+		mem = op_out(op+2, AM, m1);
+		op->mem_value = mem;
+		break;
 
-	env = volume_calc(op+3);	/* C2 */
-	if (PSG->noise & 0x80)
-	{
-		UINT32 noiseout;
+	case 4:
+		/* M1---C1-+-OUT */
+		/* M2---C2-+     */
+		/* MEM: not used */
+		c2 = op_out(op+1, AM, 0);
+		chanout[chan] = op_out(op+2, AM, m1);
+		break;
+
+	case 5:
+		/*    +----C1----+     */
+		/* M1-+-MEM---M2-+-OUT */
+		/*    +----C2----+     */
+		c2 = m1;
+		chanout[chan] = op_out(op+1, AM, op->mem_value) + op_out(op+2, AM, m1);
+		op->mem_value = m1;
+		break;
+
+	case 6:
+		/* M1---C1-+     */
+		/*      M2-+-OUT */
+		/*      C2-+     */
+		/* MEM: not used */
+		c2 = 0;
+		chanout[chan] = op_out(op+1, AM, 0) + op_out(op+2, AM, m1);
+		break;
 
-		noiseout = 0;
-		if (env < 0x3ff)
-			noiseout = (env ^ 0x3ff) * 2;	/* range of the YM2151 noise output is -2044 to 2040 */
-		chanout[7] += ((PSG->noise_rng&0x10000) ? noiseout: -noiseout); /* bit 16 -> output */
+	default:
+		/* M1-+     */
+		/* C1-+-OUT */
+		/* M2-+     */
+		/* C2-+     */
+		/* MEM: not used*/
+		c2 = 0;
+		chanout[chan] = m1 + op_out(op+1, AM, 0) + op_out(op+2, AM, 0);
+		break;
 	}
+
+	/* C2, replaced by the noise generator on channel 7 */
+	if (noise)
+		chanout[chan] += noise_out(op+3, AM);
 	else
-	{
-		if (env < ENV_QUIET)
-			chanout[7] += op_calc(op+3, env, c2);
-	}
-	/* M1 */
-	op->mem_value = mem;
+		chanout[chan] += op_out(op+3, AM, c2);
 }
 
 
@@ -2435,7 +2359,7 @@ void YM2151UpdateOne(void *chip, SAMP **buffers, int length)
 		SAVE_SINGLE_CHANNEL(5)
 		chan_calc(6);
 		SAVE_SINGLE_CHANNEL(6)
-		chan7_calc();
+		chan_calc(7);
 		SAVE_SINGLE_CHANNEL(7)
 
 		outl = chanout[0] & PSG->pan[0];
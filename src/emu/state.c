@@ -12,11 +12,15 @@
     Save state file format:
 
      0.. 7  'MAMESAVE"
-     8      Format version (this is format 1)
+     8      Format version (this is format 2)
      9      Flags
      a..13  Game name padded with \0
     14..17  Signature
-    18..end Save game data
+    18..1b  Size of the save game data plus this header, little-endian
+    1c..end Save game data, deflated
+
+    Format 1 files are identical up to 0x17 and follow the header with
+    the raw save game data; they can still be loaded.
 
 ***************************************************************************/
 
@@ -44,7 +48,10 @@
     CONSTANTS
 ***************************************************************************/
 
-#define SAVE_VERSION		1
+#define SAVE_VERSION		2
+#define SAVE_VERSION_RAW	1
+
+#define HEADER_SIZE			0x18
 
 #define TAG_STACK_SIZE		4
 
@@ -80,6 +87,17 @@ struct _ss_entry
 };
 
 
+typedef struct _ss_async ss_async;
+struct _ss_async
+{
+	osd_work_item *	item;				/* work item in flight, or NULL */
+	mame_file *		file;				/* file being written or prefetched */
+	UINT32			size;				/* size of the dump */
+	UINT8			save;				/* TRUE for a save, FALSE for a load prefetch */
+	UINT8			result;				/* 0 on success */
+};
+
+
 typedef struct _ss_func ss_func;
 struct _ss_func
 {
@@ -118,6 +136,16 @@ static UINT8 ss_registration_allowed;
 static UINT8 *ss_dump_array;
 static mame_file *ss_dump_file;
 static UINT32 ss_dump_size;
+static UINT8 ss_dump_in_memory;
+
+static UINT8 *ss_buffer;
+static UINT32 ss_buffer_size;
+static UINT8 *ss_zbuffer;
+static UINT32 ss_zbuffer_size;
+
+static osd_work_queue *ss_queue;
+static ss_async ss_job;
+static int ss_save_status;
 
 #ifdef MESS
 static const char ss_magic_num[8] = { 'M', 'E', 'S', 'S', 'S', 'A', 'V', 'E' };
@@ -131,6 +159,9 @@ static const char ss_magic_num[8] = { 'M', 'A', 'M', 'E', 'S', 'A', 'V', 'E' };
     FUNCTION PROTOTYPES
 ***************************************************************************/
 
+static void state_exit(running_machine *machine);
+static void wait_job(void);
+
 static void ss_c2(UINT8 *, UINT32);
 static void ss_c4(UINT8 *, UINT32);
 static void ss_c8(UINT8 *, UINT32);
@@ -154,6 +185,34 @@ void state_init(running_machine *machine)
 	ss_current_tag = 0;
 	ss_tag_stack_index = 0;
 	ss_registration_allowed = FALSE;
+
+	/* saves are compressed and written, and loads prefetched, on an I/O thread */
+	ss_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_IO);
+	memset(&ss_job, 0, sizeof(ss_job));
+	ss_save_status = -1;
+
+	add_exit_callback(machine, state_exit);
+}
+
+
+/*-------------------------------------------------
+    state_exit - free the persistent dump buffer
+-------------------------------------------------*/
+
+static void state_exit(running_machine *machine)
+{
+	/* let any save in flight reach the disk */
+	wait_job();
+	if (ss_queue != NULL)
+		osd_work_queue_free(ss_queue);
+	ss_queue = NULL;
+
+	if (ss_buffer != NULL)
+		free(ss_buffer);
+	if (ss_zbuffer != NULL)
+		free(ss_zbuffer);
+	ss_buffer = ss_zbuffer = NULL;
+	ss_buffer_size = ss_zbuffer_size = 0;
 }
 
 
@@ -577,7 +636,7 @@ static int compute_size_and_offsets(void)
 	int total_size;
 
 	/* start with the header size */
-	total_size = 0x18;
+	total_size = HEADER_SIZE;
 
 	/* iterate over entries */
 	for (entry = ss_registry; entry; entry = entry->next)
@@ -592,6 +651,40 @@ static int compute_size_and_offsets(void)
 }
 
 
+/*-------------------------------------------------
+    grow_buffer - grow a persistent buffer to
+    hold at least the given number of bytes;
+    returns NULL if out of memory, so that it
+    is safe to call from the I/O thread
+-------------------------------------------------*/
+
+static UINT8 *grow_buffer(UINT8 **buffer, UINT32 *cursize, UINT32 size)
+{
+	if (size > *cursize)
+	{
+		if (*buffer != NULL)
+			free(*buffer);
+		*buffer = malloc(size);
+		*cursize = (*buffer != NULL) ? size : 0;
+	}
+	return *buffer;
+}
+
+
+/*-------------------------------------------------
+    get_dump_buffer - return the persistent dump
+    buffer, growing it to hold at least the given
+    number of bytes
+-------------------------------------------------*/
+
+static UINT8 *get_dump_buffer(UINT32 size)
+{
+	if (grow_buffer(&ss_buffer, &ss_buffer_size, size) == NULL)
+		fatalerror("Out of memory for save state buffer");
+	return ss_buffer;
+}
+
+
 /*-------------------------------------------------
     call_hook_functions - loop through all the
     hook functions and call them
@@ -671,10 +764,10 @@ static int validate_header(const UINT8 *header, const char *gamename, UINT32 sig
 	}
 
 	/* check save state version */
-	if (header[8] != SAVE_VERSION)
+	if (header[8] != SAVE_VERSION && header[8] != SAVE_VERSION_RAW)
 	{
 		if (errormsg)
-			errormsg("%sWrong version in save file (%d, 1 expected)", error_prefix, header[8]);
+			errormsg("%sWrong version in save file (%d, %d expected)", error_prefix, header[8], SAVE_VERSION);
 		return -1;
 	}
 
@@ -710,7 +803,7 @@ static int validate_header(const UINT8 *header, const char *gamename, UINT32 sig
 int state_save_check_file(mame_file *file, const char *gamename, int validate_signature, void (CLIB_DECL *errormsg)(const char *fmt, ...))
 {
 	UINT32 signature = 0;
-	UINT8 header[0x18];
+	UINT8 header[HEADER_SIZE];
 
 	/* if we want to validate the signature, compute it */
 	if (validate_signature)
@@ -731,10 +824,207 @@ int state_save_check_file(mame_file *file, const char *gamename, int validate_si
 
 
 
+/***************************************************************************
+    ASYNCHRONOUS FILE I/O
+***************************************************************************/
+
+/*-------------------------------------------------
+    write_state_file - compress the dump in
+    ss_buffer and write it out, then close the
+    file; runs on the I/O thread
+-------------------------------------------------*/
+
+static int write_state_file(mame_file *file, UINT32 size)
+{
+	uLongf zsize = compressBound(size - HEADER_SIZE);
+	UINT8 rawsize[4];
+	int result = 1;
+
+	/* the header goes out as is, followed by the total size and the deflated data */
+	rawsize[0] = size;
+	rawsize[1] = size >> 8;
+	rawsize[2] = size >> 16;
+	rawsize[3] = size >> 24;
+	if (grow_buffer(&ss_zbuffer, &ss_zbuffer_size, zsize) != NULL &&
+		compress2(ss_zbuffer, &zsize, ss_buffer + HEADER_SIZE, size - HEADER_SIZE, Z_BEST_SPEED) == Z_OK &&
+		mame_fwrite(file, ss_buffer, HEADER_SIZE) == HEADER_SIZE &&
+		mame_fwrite(file, rawsize, 4) == 4 &&
+		mame_fwrite(file, ss_zbuffer, zsize) == zsize)
+		result = 0;
+
+	mame_fclose(file);
+	return result;
+}
+
+
+/*-------------------------------------------------
+    read_state_file - read a save file into
+    ss_buffer, inflating it if needed; safe to
+    run on the I/O thread
+-------------------------------------------------*/
+
+static int read_state_file(mame_file *file, UINT32 *size)
+{
+	UINT32 filesize = mame_fsize(file);
+	UINT8 header[HEADER_SIZE + 4];
+	UINT32 rawsize, zsize;
+	uLongf destlen;
+
+	/* read the common header */
+	mame_fseek(file, 0, SEEK_SET);
+	if (filesize < HEADER_SIZE || mame_fread(file, header, HEADER_SIZE) != HEADER_SIZE)
+		return 1;
+
+	/* anything but a compressed file is read raw and left for the header check */
+	if (header[8] != SAVE_VERSION)
+	{
+		if (grow_buffer(&ss_buffer, &ss_buffer_size, filesize) == NULL)
+			return 1;
+		memcpy(ss_buffer, header, HEADER_SIZE);
+		if (mame_fread(file, ss_buffer + HEADER_SIZE, filesize - HEADER_SIZE) != filesize - HEADER_SIZE)
+			return 1;
+		*size = filesize;
+		return 0;
+	}
+
+	/* compressed files carry their inflated size after the header */
+	if (filesize < HEADER_SIZE + 4 || mame_fread(file, &header[HEADER_SIZE], 4) != 4)
+		return 1;
+	rawsize = header[HEADER_SIZE] | (header[HEADER_SIZE + 1] << 8) | (header[HEADER_SIZE + 2] << 16) | (header[HEADER_SIZE + 3] << 24);
+	zsize = filesize - (HEADER_SIZE + 4);
+	if (rawsize < HEADER_SIZE)
+		return 1;
+
+	/* read the deflated data and inflate it behind the header */
+	if (grow_buffer(&ss_buffer, &ss_buffer_size, rawsize) == NULL || grow_buffer(&ss_zbuffer, &ss_zbuffer_size, zsize) == NULL)
+		return 1;
+	if (mame_fread(file, ss_zbuffer, zsize) != zsize)
+		return 1;
+	memcpy(ss_buffer, header, HEADER_SIZE);
+	destlen = rawsize - HEADER_SIZE;
+	if (uncompress(ss_buffer + HEADER_SIZE, &destlen, ss_zbuffer, zsize) != Z_OK || destlen != rawsize - HEADER_SIZE)
+		return 1;
+	*size = rawsize;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    async_callback - work item callback that
+    performs the queued save or prefetch
+-------------------------------------------------*/
+
+static void *async_callback(void *param, int threadid)
+{
+	ss_async *job = param;
+
+	if (job->save)
+		job->result = write_state_file(job->file, job->size);
+	else
+		job->result = read_state_file(job->file, &job->size);
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    start_job - queue a save or prefetch on the
+    I/O thread, or run it right away if there is
+    no queue
+-------------------------------------------------*/
+
+static void start_job(mame_file *file, UINT32 size, int save)
+{
+	ss_job.file = file;
+	ss_job.size = size;
+	ss_job.save = save;
+	ss_job.result = 0;
+	ss_job.item = NULL;
+	if (ss_queue != NULL)
+		ss_job.item = osd_work_item_queue(ss_queue, async_callback, &ss_job, 0);
+
+	/* without a thread, saves complete here; prefetches are left to the load */
+	if (ss_job.item == NULL && save)
+	{
+		async_callback(&ss_job, 0);
+		ss_save_status = ss_job.result;
+		ss_job.file = NULL;
+	}
+}
+
+
+/*-------------------------------------------------
+    wait_job - wait for the save or prefetch in
+    flight, if any, to complete
+-------------------------------------------------*/
+
+static void wait_job(void)
+{
+	if (ss_job.item == NULL)
+		return;
+
+	while (!osd_work_item_wait(ss_job.item, 100 * osd_ticks_per_second())) ;
+	osd_work_item_release(ss_job.item);
+	ss_job.item = NULL;
+
+	/* a finished save stays pending until polled; the writer closed its file */
+	if (ss_job.save)
+	{
+		ss_save_status = ss_job.result;
+		ss_job.file = NULL;
+	}
+}
+
+
+/*-------------------------------------------------
+    state_save_flush - wait for any save or load
+    prefetch in flight to complete
+-------------------------------------------------*/
+
+void state_save_flush(void)
+{
+	wait_job();
+	ss_job.file = NULL;
+}
+
+
+/*-------------------------------------------------
+    state_save_poll_save - check on a save handed
+    to the I/O thread by state_save_save_finish;
+    returns TRUE once when it has finished, with
+    *failed set if it could not be written
+-------------------------------------------------*/
+
+int state_save_poll_save(int *failed)
+{
+	/* reap the work item if it is done */
+	if (ss_job.item != NULL && ss_job.save && osd_work_item_wait(ss_job.item, 0))
+		wait_job();
+
+	if (ss_save_status < 0)
+		return FALSE;
+	*failed = ss_save_status;
+	ss_save_status = -1;
+	return TRUE;
+}
+
+
+
 /***************************************************************************
     SAVE STATE PROCESSING
 ***************************************************************************/
 
+/*-------------------------------------------------
+    state_save_get_size - return the number of
+    bytes a snapshot of the registered state
+    occupies
+-------------------------------------------------*/
+
+UINT32 state_save_get_size(void)
+{
+	return compute_size_and_offsets();
+}
+
+
 /*-------------------------------------------------
     state_save_save_begin - begin the process of
     saving
@@ -747,14 +1037,43 @@ int state_save_save_begin(mame_file *file)
 		return 1;
 
 	TRACE(logerror("Beginning save\n"));
+
+	/* the dump buffer may still be in use by the I/O thread */
+	state_save_flush();
 	ss_dump_file = file;
+	ss_dump_in_memory = FALSE;
 
 	/* compute the total dump size and the offsets of each element */
 	ss_dump_size = compute_size_and_offsets();
 	TRACE(logerror("   total size %u\n", ss_dump_size));
 
-	/* allocate memory for the array */
-	ss_dump_array = malloc_or_die(ss_dump_size);
+	/* reuse the persistent buffer for the array */
+	ss_dump_array = get_dump_buffer(ss_dump_size);
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_save_save_begin_memory - begin the
+    process of saving into a caller-provided
+    buffer of at least state_save_get_size() bytes
+-------------------------------------------------*/
+
+int state_save_save_begin_memory(void *buffer, UINT32 length)
+{
+	/* if we have illegal registrations, return an error */
+	if (ss_illegal_regs > 0)
+		return 1;
+
+	/* compute the total dump size and the offsets of each element */
+	ss_dump_size = compute_size_and_offsets();
+	if (length < ss_dump_size)
+		return 1;
+
+	/* the data goes straight into the caller's buffer */
+	ss_dump_array = buffer;
+	ss_dump_file = NULL;
+	ss_dump_in_memory = TRUE;
 	return 0;
 }
 
@@ -791,7 +1110,10 @@ void state_save_save_continue(void)
 
 /*-------------------------------------------------
     state_save_save_finish - finish saving the
-    file by writing the header and closing
+    file by writing the header, then hand the
+    dump to the I/O thread to compress, write,
+    and close; check on it with
+    state_save_poll_save
 -------------------------------------------------*/
 
 void state_save_save_finish(void)
@@ -801,6 +1123,15 @@ void state_save_save_finish(void)
 
 	TRACE(logerror("Finishing save\n"));
 
+	/* snapshots in memory have no header and nothing to write */
+	if (ss_dump_in_memory)
+	{
+		ss_dump_array = NULL;
+		ss_dump_size = 0;
+		ss_dump_in_memory = FALSE;
+		return;
+	}
+
 	/* compute the flags */
 #ifndef LSB_FIRST
 	flags |= SS_MSB_FIRST;
@@ -817,11 +1148,10 @@ void state_save_save_finish(void)
 	signature = get_signature();
 	*(UINT32 *)&ss_dump_array[0x14] = LITTLE_ENDIANIZE_INT32(signature);
 
-	/* write the file */
-	mame_fwrite(ss_dump_file, ss_dump_array, ss_dump_size);
+	/* compress and write the file in the background */
+	start_job(ss_dump_file, ss_dump_size, TRUE);
 
-	/* free memory and reset the global states */
-	free(ss_dump_array);
+	/* reset the global states; the buffer is kept for the next save */
 	ss_dump_array = NULL;
 	ss_dump_size = 0;
 	ss_dump_file = NULL;
@@ -833,6 +1163,21 @@ void state_save_save_finish(void)
     LOAD STATE PROCESSING
 ***************************************************************************/
 
+/*-------------------------------------------------
+    state_save_load_prefetch - start reading and
+    inflating a save file on the I/O thread; the
+    file must stay open until it is passed to
+    state_save_load_begin or state_save_flush
+    is called
+-------------------------------------------------*/
+
+void state_save_load_prefetch(mame_file *file)
+{
+	state_save_flush();
+	start_job(file, 0, FALSE);
+}
+
+
 /*-------------------------------------------------
     state_save_load_begin - begin the process
     of loading the state
@@ -840,18 +1185,33 @@ void state_save_save_finish(void)
 
 int state_save_load_begin(mame_file *file)
 {
+	int result;
+
 	TRACE(logerror("Beginning load\n"));
 
-	/* read the file into memory */
-	ss_dump_size = mame_fsize(file);
-	ss_dump_array = malloc_or_die(ss_dump_size);
+	/* pick up the prefetched data if it came from this file, otherwise read it now */
+	if (ss_job.item != NULL && !ss_job.save && ss_job.file == file)
+	{
+		wait_job();
+		result = ss_job.result;
+		ss_dump_size = ss_job.size;
+	}
+	else
+	{
+		state_save_flush();
+		result = read_state_file(file, &ss_dump_size);
+	}
+	ss_job.file = NULL;
+	if (result != 0)
+		return 1;
+
+	ss_dump_array = ss_buffer;
 	ss_dump_file = file;
-	mame_fread(ss_dump_file, ss_dump_array, ss_dump_size);
+	ss_dump_in_memory = FALSE;
 
 	/* verify the header and report an error if it doesn't match */
 	if (validate_header(ss_dump_array, NULL, get_signature(), popmessage, "Error: "))
 	{
-		free(ss_dump_array);
 		ss_dump_array = NULL;
 		ss_dump_size = 0;
 		ss_dump_file = NULL;
@@ -864,6 +1224,29 @@ int state_save_load_begin(mame_file *file)
 }
 
 
+/*-------------------------------------------------
+    state_save_load_begin_memory - begin the
+    process of loading from a buffer filled by
+    state_save_save_begin_memory
+-------------------------------------------------*/
+
+int state_save_load_begin_memory(const void *buffer, UINT32 length)
+{
+	TRACE(logerror("Beginning load from memory\n"));
+
+	/* the layout must match the current registrations exactly */
+	if (length != compute_size_and_offsets())
+		return 1;
+
+	/* read straight out of the caller's buffer */
+	ss_dump_array = (UINT8 *)buffer;
+	ss_dump_size = length;
+	ss_dump_file = NULL;
+	ss_dump_in_memory = TRUE;
+	return 0;
+}
+
+
 /*-------------------------------------------------
     state_save_load_continue - load all state in
     the current tag
@@ -876,10 +1259,11 @@ void state_save_load_continue(void)
 	int count;
 
 	/* first determine whether or not we need to convert the endianness of the data */
+	/* snapshots in memory are always in native order */
 #ifdef LSB_FIRST
-	need_convert = (ss_dump_array[9] & SS_MSB_FIRST) != 0;
+	need_convert = !ss_dump_in_memory && (ss_dump_array[9] & SS_MSB_FIRST) != 0;
 #else
-	need_convert = (ss_dump_array[9] & SS_MSB_FIRST) == 0;
+	need_convert = !ss_dump_in_memory && (ss_dump_array[9] & SS_MSB_FIRST) == 0;
 #endif
 
 	TRACE(logerror("Loading tag %d\n", ss_current_tag));
@@ -911,11 +1295,11 @@ void state_save_load_finish(void)
 {
 	TRACE(logerror("Finishing load\n"));
 
-	/* free memory and reset the global states */
-	free(ss_dump_array);
+	/* reset the global states; the buffer is kept for the next load */
 	ss_dump_array = NULL;
 	ss_dump_size = 0;
 	ss_dump_file = NULL;
+	ss_dump_in_memory = FALSE;
 }
 
 
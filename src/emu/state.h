@@ -99,6 +99,16 @@ void state_save_register_func_postload_ptr(void (*func)(void *), void *param);
 int  state_save_save_begin(mame_file *file);
 int  state_save_load_begin(mame_file *file);
 
+/* File saves finish on an I/O thread, which closes the file; loads can be prefetched there */
+int  state_save_poll_save(int *failed);
+void state_save_load_prefetch(mame_file *file);
+void state_save_flush(void);
+
+/* Snapshots in memory: native byte order, no header, sized by state_save_get_size() */
+UINT32 state_save_get_size(void);
+int  state_save_save_begin_memory(void *buffer, UINT32 length);
+int  state_save_load_begin_memory(const void *buffer, UINT32 length);
+
 void state_save_push_tag(int tag);
 void state_save_pop_tag(void);
 
@@ -24,6 +24,12 @@
 /* invalid logical index */
 #define INVALID_LOGICAL_INDEX			((tilemap_logical_index)~0)
 
+/* maximum number of horizontal bands a tilemap is drawn in */
+#define MAX_BANDS						16
+
+/* minimum height of a band; smaller draws are not worth splitting */
+#define MIN_BAND_HEIGHT					16
+
 
 
 /***************************************************************************
@@ -62,6 +68,15 @@ struct _blit_parameters
 };
 
 
+/* one horizontal band of a threaded tilemap draw */
+typedef struct _band_info band_info;
+struct _band_info
+{
+	tilemap *			tmap;					/* tilemap being drawn */
+	blit_parameters		blit;					/* blit parameters clipped to this band */
+};
+
+
 /* core tilemap structure */
 struct _tilemap
 {
@@ -129,6 +144,9 @@ static int				tilemap_instance;
 
 static UINT32			screen_width, screen_height;
 
+static osd_work_queue *	tilemap_queue;
+static int				tilemap_bands;
+
 
 
 /***************************************************************************
@@ -150,10 +168,14 @@ static void tile_update(tilemap *tmap, tilemap_logical_index logindex, UINT32 ca
 static UINT8 tile_draw(tilemap *tmap, const UINT8 *pendata, UINT32 x0, UINT32 y0, UINT32 palette_base, UINT8 category, UINT8 group, UINT8 flags);
 static UINT8 tile_draw_colortable(tilemap *tmap, const UINT8 *pendata, UINT32 x0, UINT32 y0, UINT32 palette_base, UINT8 category, UINT8 group, UINT8 flags);
 static UINT8 tile_draw_colortrans(tilemap *tmap, const UINT8 *pendata, UINT32 x0, UINT32 y0, UINT32 palette_base, UINT8 category, UINT8 group, UINT8 flags);
+static int tile_single_pen(tilemap *tmap, UINT8 flags);
+static UINT8 tile_fill(tilemap *tmap, UINT32 x0, UINT32 y0, pen_t pixel, pen_t mapindex, UINT8 category, UINT8 group, UINT8 flags);
 static UINT8 tile_apply_bitmask(tilemap *tmap, const UINT8 *maskdata, UINT32 x0, UINT32 y0, UINT8 category, UINT8 flags);
 
 /* drawing helpers */
 static void configure_blit_parameters(blit_parameters *blit, tilemap *tmap, mame_bitmap *dest, const rectangle *cliprect, UINT32 flags, UINT8 priority, UINT8 priority_mask);
+static void tilemap_draw_core(tilemap *tmap, const blit_parameters *blit);
+static void *tilemap_draw_band_callback(void *param, int threadid);
 static void tilemap_draw_instance(tilemap *tmap, const blit_parameters *blit, int xpos, int ypos);
 static void tilemap_draw_roz_core(tilemap *tmap, const blit_parameters *blit,
 		UINT32 startx, UINT32 starty, int incxx, int incxy, int incyx, int incyy, int wraparound);
@@ -272,6 +294,13 @@ void tilemap_init(running_machine *machine)
 	tilemap_instance = 0;
 
 	priority_bitmap = auto_bitmap_alloc(screen_width, screen_height, BITMAP_FORMAT_INDEXED8);
+
+	/* tall draws can be split into bands drawn on a work queue */
+	tilemap_bands = MIN(options_get_int(mame_options(), OPTION_TILEMAPBANDS), MAX_BANDS);
+	tilemap_queue = NULL;
+	if (tilemap_bands > 1)
+		tilemap_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+
 	add_exit_callback(machine, tilemap_exit);
 }
 
@@ -712,9 +741,9 @@ UINT8 *tilemap_get_tile_flags(tilemap *tmap)
 
 void tilemap_draw_primask(mame_bitmap *dest, const rectangle *cliprect, tilemap *tmap, UINT32 flags, UINT8 priority, UINT8 priority_mask)
 {
-	rectangle original_cliprect;
+	band_info band[MAX_BANDS];
 	blit_parameters blit;
-	int xpos, ypos;
+	int numbands, bandnum;
 
 	/* skip if disabled */
 	if (!tmap->enable)
@@ -723,7 +752,6 @@ void tilemap_draw_primask(mame_bitmap *dest, const rectangle *cliprect, tilemap
 profiler_mark(PROFILER_TILEMAP_DRAW);
 	/* configure the blit parameters based on the input parameters */
 	configure_blit_parameters(&blit, tmap, dest, cliprect, flags, priority, priority_mask);
-	original_cliprect = blit.cliprect;
 
 	/* if the whole map is dirty, mark it as such */
 	if (tmap->all_tiles_dirty)
@@ -732,91 +760,34 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 		tmap->all_tiles_dirty = FALSE;
 	}
 
-	/* XY scrolling playfield */
-	if (tmap->scrollrows == 1 && tmap->scrollcols == 1)
+	/* clamp the band count; too few rows per band and threading is not worth it */
+	numbands = MIN(tilemap_bands, (blit.cliprect.max_y - blit.cliprect.min_y + 1) / MIN_BAND_HEIGHT);
+	if (tilemap_queue == NULL || numbands <= 1)
 	{
-		int scrollx = effective_rowscroll(tmap, 0);
-		int scrolly = effective_colscroll(tmap, 0);
-
-		/* iterate to handle wraparound */
-		for (ypos = scrolly - tmap->height; ypos <= blit.cliprect.max_y; ypos += tmap->height)
-			for (xpos = scrollx - tmap->width; xpos <= blit.cliprect.max_x; xpos += tmap->width)
-				tilemap_draw_instance(tmap, &blit, xpos, ypos);
+		tilemap_draw_core(tmap, &blit);
+profiler_mark(PROFILER_END);
+		return;
 	}
 
-	/* scrolling rows + vertical scroll */
-	else if (tmap->scrollcols == 1)
-	{
-		const rectangle original_cliprect = blit.cliprect;
-		int rowheight = tmap->height / tmap->scrollrows;
-		int scrolly = effective_colscroll(tmap, 0);
-		int currow, nextrow;
-
-		/* iterate over rows in the tilemap */
-		for (currow = 0; currow < tmap->scrollrows; currow = nextrow)
-		{
-			int scrollx = effective_rowscroll(tmap, currow);
-
-			/* scan forward until we find a non-matching row */
-			for (nextrow = currow + 1; nextrow < tmap->scrollrows; nextrow++)
-				if (effective_rowscroll(tmap, nextrow) != scrollx)
-					break;
-
- 			/* skip if disabled */
-			if (scrollx == TILE_LINE_DISABLED)
-				continue;
-
-			/* iterate over Y to handle wraparound */
-			for (ypos = scrolly - tmap->height; ypos <= original_cliprect.max_y; ypos += tmap->height)
-			{
-				/* update the cliprect just for this set of rows */
-				blit.cliprect.min_y = currow * rowheight + ypos;
-				blit.cliprect.max_y = nextrow * rowheight - 1 + ypos;
-				sect_rect(&blit.cliprect, &original_cliprect);
-
-				/* iterate over X to handle wraparound */
-				for (xpos = scrollx - tmap->width; xpos <= original_cliprect.max_x; xpos += tmap->width)
-					tilemap_draw_instance(tmap, &blit, xpos, ypos);
-			}
-		}
-	}
+	/* bring every tile up to date here, so the workers never call back into the driver */
+	pixmap_update(tmap, NULL);
 
-	/* scrolling columns + horizontal scroll */
-	else if (tmap->scrollrows == 1)
+	/* split the cliprect into bands of nearly equal height; their rows, and so their
+	   destination and priority pixels, are disjoint */
+	for (bandnum = 0; bandnum < numbands; bandnum++)
 	{
-		const rectangle original_cliprect = blit.cliprect;
-		int colwidth = tmap->width / tmap->scrollcols;
-		int scrollx = effective_rowscroll(tmap, 0);
-		int curcol, nextcol;
-
-		/* iterate over columns in the tilemap */
-		for (curcol = 0; curcol < tmap->scrollcols; curcol = nextcol)
-		{
-			int scrolly	= effective_colscroll(tmap, curcol);
-
-			/* scan forward until we find a non-matching column */
-			for (nextcol = curcol + 1; nextcol < tmap->scrollcols; nextcol++)
-				if (effective_colscroll(tmap, nextcol) != scrolly)
-					break;
-
- 			/* skip if disabled */
-			if (scrolly == TILE_LINE_DISABLED)
-				continue;
-
-			/* iterate over X to handle wraparound */
-			for (xpos = scrollx - tmap->width; xpos <= original_cliprect.max_x; xpos += tmap->width)
-			{
-				/* update the cliprect just for this set of columns */
-				blit.cliprect.min_x = curcol * colwidth + xpos;
-				blit.cliprect.max_x = nextcol * colwidth - 1 + xpos;
-				sect_rect(&blit.cliprect, &original_cliprect);
+		int height = blit.cliprect.max_y - blit.cliprect.min_y + 1;
 
-				/* iterate over Y to handle wraparound */
-				for (ypos = scrolly - tmap->height; ypos <= original_cliprect.max_y; ypos += tmap->height)
-					tilemap_draw_instance(tmap, &blit, xpos, ypos);
-			}
-		}
+		band[bandnum].tmap = tmap;
+		band[bandnum].blit = blit;
+		band[bandnum].blit.cliprect.min_y = blit.cliprect.min_y + height * bandnum / numbands;
+		band[bandnum].blit.cliprect.max_y = blit.cliprect.min_y + height * (bandnum + 1) / numbands - 1;
 	}
+
+	/* queue them all and wait for the workers to finish; the bands live on our stack,
+	   so we can't return while any worker may still be reading them */
+	osd_work_item_queue_multiple(tilemap_queue, tilemap_draw_band_callback, numbands, band, sizeof(band[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+	while (!osd_work_queue_wait(tilemap_queue, 100 * osd_ticks_per_second())) ;
 profiler_mark(PROFILER_END);
 }
 
@@ -1015,6 +986,11 @@ static void tilemap_exit(running_machine *machine)
 		tilemap_list = next;
 	}
 	tilemap_tailptr = NULL;
+
+	/* free the band work queue */
+	if (tilemap_queue != NULL)
+		osd_work_queue_free(tilemap_queue);
+	tilemap_queue = NULL;
 }
 
 
@@ -1190,7 +1166,7 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 	}
 
 	/* mark it all clean */
-	if (mincol == 0 && minrow == 0 && maxcol == tmap->cols - 1 && maxcol == tmap->rows - 1)
+	if (mincol == 0 && minrow == 0 && maxcol == tmap->cols - 1 && maxrow == tmap->rows - 1)
 		tmap->all_tiles_clean = TRUE;
 
 profiler_mark(PROFILER_END);
@@ -1207,24 +1183,37 @@ static void tile_update(tilemap *tmap, tilemap_logical_index logindex, UINT32 co
 	UINT32 y0 = tmap->tileheight * row;
 	tilemap_memory_index memindex;
 	UINT32 flags;
+	int pen;
 
 profiler_mark(PROFILER_TILEMAP_UPDATE);
 
 	/* call the get info callback for the associated memory index */
 	memindex = tmap->logical_to_memory[logindex];
+	tmap->tileinfo.gfx = NULL;
 	(*tmap->tile_get_info)(Machine, &tmap->tileinfo, memindex, tmap->user_data);
 
 	/* apply the global tilemap flip to the returned flip flags */
 	flags = tmap->tileinfo.flags ^ (tmap->attributes & 0x03);
 
+	/* tiles made of a single pen are filled directly rather than drawn pixel by pixel */
+	pen = tile_single_pen(tmap, flags);
+
 	/* draw the tile, using either direct or transparent */
 	if (Machine->game_colortable != NULL)
 	{
-		if (tmap->type != TILEMAP_TYPE_COLORTABLE)
+		if (pen >= 0)
+		{
+			pen_t color = Machine->remapped_colortable[tmap->tileinfo.palette_base + pen];
+			pen_t mapindex = (tmap->type != TILEMAP_TYPE_COLORTABLE) ? pen : color;
+			tmap->tileflags[logindex] = tile_fill(tmap, x0, y0, color, mapindex, tmap->tileinfo.category, tmap->tileinfo.group, flags);
+		}
+		else if (tmap->type != TILEMAP_TYPE_COLORTABLE)
 			tmap->tileflags[logindex] = tile_draw_colortable(tmap, tmap->tileinfo.pen_data, x0, y0, tmap->tileinfo.palette_base, tmap->tileinfo.category, tmap->tileinfo.group, flags);
 		else
 			tmap->tileflags[logindex] = tile_draw_colortrans(tmap, tmap->tileinfo.pen_data, x0, y0, tmap->tileinfo.palette_base, tmap->tileinfo.category, tmap->tileinfo.group, flags);
 	}
+	else if (pen >= 0)
+		tmap->tileflags[logindex] = tile_fill(tmap, x0, y0, tmap->tileinfo.palette_base + pen, pen, tmap->tileinfo.category, tmap->tileinfo.group, flags);
 	else
 		tmap->tileflags[logindex] = tile_draw(tmap, tmap->tileinfo.pen_data, x0, y0, tmap->tileinfo.palette_base, tmap->tileinfo.category, tmap->tileinfo.group, flags);
 
@@ -1236,6 +1225,65 @@ profiler_mark(PROFILER_END);
 }
 
 
+/*-------------------------------------------------
+    tile_single_pen - return the only pen used
+    by the tile just fetched into tmap->tileinfo,
+    or -1 if it uses several or can't be told
+-------------------------------------------------*/
+
+static int tile_single_pen(tilemap *tmap, UINT8 flags)
+{
+	const tile_data *tileinfo = &tmap->tileinfo;
+	const gfx_element *gfx = tileinfo->gfx;
+	int packed;
+
+	/* only trust the element if the callback left the pen data pointing at it */
+	if (gfx == NULL || tileinfo->pen_data != gfx->gfxdata + tileinfo->code * gfx->char_modulo)
+		return -1;
+
+	/* the element must be laid out exactly as tile_draw would read it */
+	packed = ((flags & TILE_4BPP) != 0);
+	if (packed != ((gfx->flags & GFX_ELEMENT_PACKED) != 0) || gfx->width != tmap->tilewidth || gfx->height != tmap->tileheight)
+		return -1;
+	if (gfx->line_modulo != (packed ? gfx->width / 2 : gfx->width))
+		return -1;
+
+	return gfx_element_single_pen(gfx, tileinfo->code);
+}
+
+
+/*-------------------------------------------------
+    tile_fill - fill a single tile of the
+    tilemap's internal pixmap with one value;
+    mapindex is the pen_to_flags lookup value
+-------------------------------------------------*/
+
+static UINT8 tile_fill(tilemap *tmap, UINT32 x0, UINT32 y0, pen_t pixel, pen_t mapindex, UINT8 category, UINT8 group, UINT8 flags)
+{
+	UINT8 map = tmap->pen_to_flags[group * tmap->max_pen_to_flags + mapindex];
+	int height = tmap->tileheight;
+	int width = tmap->tilewidth;
+	int tx, ty;
+
+	/* OR in the force layer flags */
+	category |= flags & (TILE_FORCE_LAYER0 | TILE_FORCE_LAYER1 | TILE_FORCE_LAYER2);
+
+	/* flipping doesn't matter, every pixel is the same */
+	for (ty = 0; ty < height; ty++)
+	{
+		UINT16 *pixptr = BITMAP_ADDR16(tmap->pixmap, y0 + ty, x0);
+		UINT8 *flagsptr = BITMAP_ADDR8(tmap->flagsmap, y0 + ty, x0);
+
+		for (tx = 0; tx < width; tx++)
+			pixptr[tx] = pixel;
+		memset(flagsptr, map | category, width);
+	}
+
+	/* all pixels map to the same flags, so none are mixed */
+	return 0;
+}
+
+
 /*-------------------------------------------------
     tile_draw - draw a single tile to the
     tilemap's internal pixmap, using the pen as
@@ -1675,6 +1723,118 @@ static void configure_blit_parameters(blit_parameters *blit, tilemap *tmap, mame
 }
 
 
+/*-------------------------------------------------
+    tilemap_draw_core - draw a tilemap to the
+    destination within the blit cliprect,
+    handling scrolling and wraparound
+-------------------------------------------------*/
+
+static void tilemap_draw_core(tilemap *tmap, const blit_parameters *_blit)
+{
+	blit_parameters blit = *_blit;
+	int xpos, ypos;
+
+	/* XY scrolling playfield */
+	if (tmap->scrollrows == 1 && tmap->scrollcols == 1)
+	{
+		int scrollx = effective_rowscroll(tmap, 0);
+		int scrolly = effective_colscroll(tmap, 0);
+
+		/* iterate to handle wraparound */
+		for (ypos = scrolly - tmap->height; ypos <= blit.cliprect.max_y; ypos += tmap->height)
+			for (xpos = scrollx - tmap->width; xpos <= blit.cliprect.max_x; xpos += tmap->width)
+				tilemap_draw_instance(tmap, &blit, xpos, ypos);
+	}
+
+	/* scrolling rows + vertical scroll */
+	else if (tmap->scrollcols == 1)
+	{
+		const rectangle original_cliprect = blit.cliprect;
+		int rowheight = tmap->height / tmap->scrollrows;
+		int scrolly = effective_colscroll(tmap, 0);
+		int currow, nextrow;
+
+		/* iterate over rows in the tilemap */
+		for (currow = 0; currow < tmap->scrollrows; currow = nextrow)
+		{
+			int scrollx = effective_rowscroll(tmap, currow);
+
+			/* scan forward until we find a non-matching row */
+			for (nextrow = currow + 1; nextrow < tmap->scrollrows; nextrow++)
+				if (effective_rowscroll(tmap, nextrow) != scrollx)
+					break;
+
+ 			/* skip if disabled */
+			if (scrollx == TILE_LINE_DISABLED)
+				continue;
+
+			/* iterate over Y to handle wraparound */
+			for (ypos = scrolly - tmap->height; ypos <= original_cliprect.max_y; ypos += tmap->height)
+			{
+				/* update the cliprect just for this set of rows */
+				blit.cliprect.min_y = currow * rowheight + ypos;
+				blit.cliprect.max_y = nextrow * rowheight - 1 + ypos;
+				sect_rect(&blit.cliprect, &original_cliprect);
+
+				/* iterate over X to handle wraparound */
+				for (xpos = scrollx - tmap->width; xpos <= original_cliprect.max_x; xpos += tmap->width)
+					tilemap_draw_instance(tmap, &blit, xpos, ypos);
+			}
+		}
+	}
+
+	/* scrolling columns + horizontal scroll */
+	else if (tmap->scrollrows == 1)
+	{
+		const rectangle original_cliprect = blit.cliprect;
+		int colwidth = tmap->width / tmap->scrollcols;
+		int scrollx = effective_rowscroll(tmap, 0);
+		int curcol, nextcol;
+
+		/* iterate over columns in the tilemap */
+		for (curcol = 0; curcol < tmap->scrollcols; curcol = nextcol)
+		{
+			int scrolly	= effective_colscroll(tmap, curcol);
+
+			/* scan forward until we find a non-matching column */
+			for (nextcol = curcol + 1; nextcol < tmap->scrollcols; nextcol++)
+				if (effective_colscroll(tmap, nextcol) != scrolly)
+					break;
+
+ 			/* skip if disabled */
+			if (scrolly == TILE_LINE_DISABLED)
+				continue;
+
+			/* iterate over X to handle wraparound */
+			for (xpos = scrollx - tmap->width; xpos <= original_cliprect.max_x; xpos += tmap->width)
+			{
+				/* update the cliprect just for this set of columns */
+				blit.cliprect.min_x = curcol * colwidth + xpos;
+				blit.cliprect.max_x = nextcol * colwidth - 1 + xpos;
+				sect_rect(&blit.cliprect, &original_cliprect);
+
+				/* iterate over Y to handle wraparound */
+				for (ypos = scrolly - tmap->height; ypos <= original_cliprect.max_y; ypos += tmap->height)
+					tilemap_draw_instance(tmap, &blit, xpos, ypos);
+			}
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+    tilemap_draw_band_callback - work item
+    callback that draws a single band
+-------------------------------------------------*/
+
+static void *tilemap_draw_band_callback(void *param, int threadid)
+{
+	band_info *band = param;
+	tilemap_draw_core(band->tmap, &band->blit);
+	return NULL;
+}
+
+
 /*-------------------------------------------------
     tilemap_draw_instance - draw a single
     instance of the tilemap to the internal
@@ -425,6 +425,8 @@ struct _tile_data
 	UINT8 			category;		/* defaults to 0; range from 0..15 */
 	UINT8			group;			/* defaults to 0; range from 0..TILEMAP_NUM_GROUPS */
 	UINT8 			flags;			/* defaults to 0; one or more of TILE_* flags above */
+	const gfx_element *gfx;			/* set by SET_TILE_INFO; used to detect single-pen tiles */
+	UINT32			code;			/* set by SET_TILE_INFO; element within gfx */
 };
 
 
@@ -591,6 +593,8 @@ INLINE void tileinfo_set(running_machine *machine, tile_data *tileinfo, int gfxn
 	tileinfo->pen_data = gfx->gfxdata + code * gfx->char_modulo;
 	tileinfo->palette_base = gfx->color_base + gfx->color_granularity * rawcolor;
 	tileinfo->flags = flags;
+	tileinfo->gfx = gfx;
+	tileinfo->code = code;
 	if (gfx->flags & GFX_ELEMENT_PACKED)
 		tileinfo->flags |= TILE_4BPP;
 }
@@ -38,6 +38,9 @@
 
 #define QUARK_HASH_SIZE		389
 
+#define VALIDITY_CACHE_FILENAME		"validity.cache"
+#define VALIDITY_CACHE_SIGNATURE	"# MAME validity cache v1"
+
 
 
 /*************************************
@@ -1463,3 +1466,91 @@ int mame_validitychecks(const game_driver *curdriver)
 
 	return error;
 }
+
+
+
+/*************************************
+ *
+ *  Validity cache
+ *
+ *************************************/
+
+/*
+    The cache lists the source files whose drivers have passed the
+    checks. Its first line holds the build ID and a CRC of the driver
+    list, so a different build ignores everything that follows.
+*/
+
+static UINT32 driver_list_crc(void)
+{
+	UINT32 crc = 0;
+	int drivnum;
+
+	for (drivnum = 0; drivers[drivnum]; drivnum++)
+	{
+		crc = crc32(crc, (const UINT8 *)drivers[drivnum]->name, (UINT32)strlen(drivers[drivnum]->name) + 1);
+		crc = crc32(crc, (const UINT8 *)drivers[drivnum]->source_file, (UINT32)strlen(drivers[drivnum]->source_file) + 1);
+	}
+	return crc;
+}
+
+
+static void strip_newline(char *line)
+{
+	int length = strlen(line);
+	while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+		line[--length] = 0;
+}
+
+
+int mame_validitychecks_cached(core_options *options, const game_driver *curdriver)
+{
+	astring *passed;
+	char header[256];
+	char line[1024];
+	mame_file *file;
+	int found = FALSE;
+	int error;
+
+	if (!options_get_bool(options, OPTION_VALIDITYCACHE))
+		return mame_validitychecks(curdriver);
+
+	/* read back the source files that passed with this build */
+	sprintf(header, VALIDITY_CACHE_SIGNATURE " %08X %s", driver_list_crc(), build_id);
+	passed = astring_alloc();
+	if (mame_fopen_options(options, SEARCHPATH_CONFIG, VALIDITY_CACHE_FILENAME, OPEN_FLAG_READ, &file) == FILERR_NONE)
+	{
+		if (mame_fgets(line, sizeof(line), file) != NULL)
+		{
+			strip_newline(line);
+			if (strcmp(line, header) == 0)
+				while (mame_fgets(line, sizeof(line), file) != NULL)
+				{
+					strip_newline(line);
+					if (line[0] == 0)
+						continue;
+					if (strcmp(line, curdriver->source_file) == 0)
+						found = TRUE;
+					astring_catc(astring_catc(passed, line), "\n");
+				}
+		}
+		mame_fclose(file);
+	}
+
+	if (found)
+	{
+		mame_printf_verbose("Validity checks: %s already passed with this build\n", curdriver->source_file);
+		astring_free(passed);
+		return 0;
+	}
+
+	/* run them for real, and remember a pass */
+	error = mame_validitychecks(curdriver);
+	if (error == 0 && mame_fopen_options(options, SEARCHPATH_CONFIG, VALIDITY_CACHE_FILENAME, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &file) == FILERR_NONE)
+	{
+		mame_fprintf(file, "%s\n%s%s\n", header, astring_c(passed), curdriver->source_file);
+		mame_fclose(file);
+	}
+	astring_free(passed);
+	return error;
+}
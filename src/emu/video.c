@@ -13,6 +13,7 @@
 #include "driver.h"
 #include "profiler.h"
 #include "png.h"
+#include "aviio.h"
 #include "debugger.h"
 #include "video/vector.h"
 #include "render.h"
@@ -39,12 +40,57 @@
 #define SUBSECONDS_PER_SPEED_UPDATE	(ATTOSECONDS_PER_SECOND / 4)
 #define PAUSED_REFRESH_RATE			30
 
+#define MOVIE_QUEUE_FRAMES			8			/* frames that may be waiting on the encoder */
+
 
 
 /***************************************************************************
     TYPE DEFINITIONS
 ***************************************************************************/
 
+typedef struct _movie_capture movie_capture;
+
+
+typedef struct _movie_frame movie_frame;
+struct _movie_frame
+{
+	movie_capture *			capture;			/* capture that owns this frame */
+	osd_work_item *			item;				/* work item encoding this frame, or NULL if idle */
+	mame_bitmap *			bitmap;				/* copy of the snapshot bitmap */
+	INT16 *					sound;				/* interleaved stereo samples leading up to the frame */
+	UINT32					samples;			/* number of stereo samples */
+	UINT32					soundalloc;			/* number of stereo samples allocated */
+	UINT32					repeat;				/* frames dropped just before this one */
+};
+
+
+struct _movie_capture
+{
+	/* encoding queue; owned by the emulation thread */
+	osd_work_queue *		queue;				/* I/O queue that does the encoding */
+	movie_frame				frame[MOVIE_QUEUE_FRAMES]; /* ring of frames being encoded */
+	UINT32					nextframe;			/* index of the next frame to fill */
+	UINT32					repeat;				/* frames dropped since the last one queued */
+	UINT32					frames;				/* total frames offered */
+	UINT32					dropped;			/* total frames dropped */
+	INT16 *					sound;				/* stereo samples gathered since the last queued frame */
+	UINT32					samples;			/* number of stereo samples gathered */
+	UINT32					soundalloc;			/* number of stereo samples allocated */
+
+	/* output state; owned by the encoder */
+	mame_file *				mngfile;			/* MNG file, or NULL for an AVI */
+	char *					aviname;			/* name of the AVI file to create */
+	avi_file *				avi;				/* AVI file once created */
+	bitmap_t *				yuvbitmap;			/* last frame converted to YUY16 */
+	UINT32					sample_rate;		/* sample rate of the AVI audio */
+	double					rate;				/* frame rate */
+	char					software[64];		/* MNG Software text */
+	char					system[256];		/* MNG System text */
+	UINT32					written;			/* frames written */
+	volatile int			error;				/* set once the encoder fails */
+};
+
+
 typedef struct _internal_screen_info internal_screen_info;
 struct _internal_screen_info
 {
@@ -68,8 +114,7 @@ struct _internal_screen_info
 	emu_timer *				scanline0_timer;	/* scanline 0 timer */
 
 	/* movie recording */
-	mame_file *				movie_file;			/* handle to the open movie file */
-	UINT32 					movie_frame;		/* current movie frame number */
+	movie_capture *			movie;				/* movie being recorded, or NULL */
 };
 
 
@@ -187,7 +232,12 @@ static mame_bitmap *get_snapshot_bitmap(running_machine *machine, int scrnum);
 static file_error mame_fopen_next(const char *pathoption, const char *extension, mame_file **file);
 
 /* movie recording */
+static void movie_begin(running_machine *machine, int scrnum, movie_capture *capture);
 static void movie_record_frame(running_machine *machine, int scrnum);
+static void *movie_encode_frame(void *param, int threadid);
+static int movie_write_mng(movie_capture *capture, movie_frame *frame);
+static int movie_write_avi(movie_capture *capture, movie_frame *frame);
+static void rgb32_to_yuy16(bitmap_t *dest, const bitmap_t *source);
 
 /* crosshair rendering */
 static void crosshair_init(video_private *viddata);
@@ -368,6 +418,9 @@ void video_init(running_machine *machine)
 	filename = options_get_string(mame_options(), OPTION_MNGWRITE);
 	if (filename[0] != 0)
 		video_movie_begin_recording(machine, 0, filename);
+	filename = options_get_string(mame_options(), OPTION_AVIWRITE);
+	if (filename[0] != 0)
+		video_avi_begin_recording(machine, 0, filename);
 }
 
 
@@ -1793,7 +1846,7 @@ static file_error mame_fopen_next(const char *pathoption, const char *extension,
 
 
 /***************************************************************************
-    MNG MOVIE RECORDING
+    MOVIE RECORDING
 ***************************************************************************/
 
 /*-------------------------------------------------
@@ -1805,7 +1858,7 @@ int video_is_movie_active(running_machine *machine, int scrnum)
 {
 	video_private *viddata = machine->video_data;
 	internal_screen_info *info = &viddata->scrinfo[scrnum];
-	return (info->movie_file != NULL);
+	return (info->movie != NULL);
 }
 
 
@@ -1816,101 +1869,434 @@ int video_is_movie_active(running_machine *machine, int scrnum)
 
 void video_movie_begin_recording(running_machine *machine, int scrnum, const char *name)
 {
-	video_private *viddata = machine->video_data;
-	internal_screen_info *info = &viddata->scrinfo[scrnum];
+	movie_capture *capture;
 	file_error filerr;
+	mame_file *file;
 
-	/* close any existing movie file */
-	if (info->movie_file != NULL)
-		video_movie_end_recording(machine, scrnum);
-
-	/* create a new movie file and start recording */
+	/* create a new movie file */
 	if (name != NULL)
-		filerr = mame_fopen(SEARCHPATH_MOVIE, name, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &info->movie_file);
+		filerr = mame_fopen(SEARCHPATH_MOVIE, name, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &file);
 	else
-		filerr = mame_fopen_next(SEARCHPATH_MOVIE, "mng", &info->movie_file);
-	info->movie_frame = 0;
+		filerr = mame_fopen_next(SEARCHPATH_MOVIE, "mng", &file);
+	if (filerr != FILERR_NONE)
+		return;
+
+	/* and start recording into it */
+	capture = malloc_or_die(sizeof(*capture));
+	memset(capture, 0, sizeof(*capture));
+	capture->mngfile = file;
+	movie_begin(machine, scrnum, capture);
+}
+
+
+/*-------------------------------------------------
+    video_avi_begin_recording - begin recording
+    of an AVI movie with sound
+-------------------------------------------------*/
+
+void video_avi_begin_recording(running_machine *machine, int scrnum, const char *name)
+{
+	movie_capture *capture;
+	file_error filerr;
+	mame_file *file;
+
+	/* create the file in the movie path, as for MNGs; aviio reopens it by its full name */
+	filerr = mame_fopen(SEARCHPATH_MOVIE, name, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &file);
+	if (filerr != FILERR_NONE)
+		return;
+
+	/* the AVI headers are written once the first frame tells us its size */
+	capture = malloc_or_die(sizeof(*capture));
+	memset(capture, 0, sizeof(*capture));
+	capture->aviname = mame_strdup(mame_file_full_name(file));
+	mame_fclose(file);
+	capture->sample_rate = machine->sample_rate;
+	movie_begin(machine, scrnum, capture);
 }
 
 
 /*-------------------------------------------------
     video_movie_end_recording - stop recording of
-    a MNG movie
+    a movie, waiting for queued frames to finish
 -------------------------------------------------*/
 
 void video_movie_end_recording(running_machine *machine, int scrnum)
 {
 	video_private *viddata = machine->video_data;
 	internal_screen_info *info = &viddata->scrinfo[scrnum];
+	movie_capture *capture = info->movie;
+	int framenum;
+
+	if (capture == NULL)
+		return;
+	info->movie = NULL;
+
+	/* let the encoder drain, then free the frames */
+	for (framenum = 0; framenum < MOVIE_QUEUE_FRAMES; framenum++)
+	{
+		movie_frame *frame = &capture->frame[framenum];
+		if (frame->item != NULL)
+		{
+			while (!osd_work_item_wait(frame->item, 100 * osd_ticks_per_second())) ;
+			osd_work_item_release(frame->item);
+		}
+		if (frame->bitmap != NULL)
+			bitmap_free(frame->bitmap);
+		if (frame->sound != NULL)
+			free(frame->sound);
+	}
+	if (capture->queue != NULL)
+		osd_work_queue_free(capture->queue);
+
+	/* frames dropped at the very end still need their repeats and sound */
+	if (capture->avi != NULL && capture->repeat > 0 && !capture->error)
+	{
+		movie_frame tail = { 0 };
+
+		tail.capture = capture;
+		tail.sound = capture->sound;
+		tail.samples = capture->samples;
+		tail.repeat = capture->repeat;
+		if (!movie_write_avi(capture, &tail))
+			capture->error = TRUE;
+	}
 
-	/* close the file if it exists */
-	if (info->movie_file != NULL)
+	/* close the output */
+	if (capture->mngfile != NULL)
 	{
-		mng_capture_stop(mame_core_file(info->movie_file));
-		mame_fclose(info->movie_file);
-		info->movie_file = NULL;
-		info->movie_frame = 0;
+		if (capture->written > 0)
+			mng_capture_stop(mame_core_file(capture->mngfile));
+		mame_fclose(capture->mngfile);
 	}
+	if (capture->avi != NULL)
+		avi_close(capture->avi);
+	if (capture->error)
+		mame_printf_error("Error writing movie; recording stopped after %d frames\n", capture->written);
+	if (capture->dropped > 0)
+		mame_printf_info("Movie recording dropped %d of %d frames\n", capture->dropped, capture->frames);
+
+	/* free everything else */
+	if (capture->yuvbitmap != NULL)
+		bitmap_free(capture->yuvbitmap);
+	if (capture->sound != NULL)
+		free(capture->sound);
+	if (capture->aviname != NULL)
+		free(capture->aviname);
+	free(capture);
 }
 
 
 /*-------------------------------------------------
-    movie_record_frame - record a frame of a
-    movie
+    video_avi_add_sound - add a block of mixed
+    stereo samples to any AVI being recorded
+-------------------------------------------------*/
+
+void video_avi_add_sound(running_machine *machine, const INT16 *sound, int numsamples)
+{
+	video_private *viddata = machine->video_data;
+	int scrnum;
+
+	for (scrnum = 0; scrnum < MAX_SCREENS; scrnum++)
+	{
+		movie_capture *capture = viddata->scrinfo[scrnum].movie;
+
+		/* samples wait here until the next frame is queued */
+		if (capture != NULL && capture->aviname != NULL)
+		{
+			if (capture->samples + numsamples > capture->soundalloc)
+			{
+				capture->soundalloc = (capture->samples + numsamples) * 2;
+				capture->sound = realloc(capture->sound, capture->soundalloc * 2 * sizeof(capture->sound[0]));
+				if (capture->sound == NULL)
+					fatalerror("Out of memory recording movie sound\n");
+			}
+			memcpy(&capture->sound[capture->samples * 2], sound, numsamples * 2 * sizeof(sound[0]));
+			capture->samples += numsamples;
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+    movie_begin - attach a new capture to a
+    screen
+-------------------------------------------------*/
+
+static void movie_begin(running_machine *machine, int scrnum, movie_capture *capture)
+{
+	video_private *viddata = machine->video_data;
+	internal_screen_info *info = &viddata->scrinfo[scrnum];
+	int framenum;
+
+	/* close any existing movie */
+	if (info->movie != NULL)
+		video_movie_end_recording(machine, scrnum);
+
+	/* encoding happens in order on a single I/O thread */
+	capture->queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_IO);
+	for (framenum = 0; framenum < MOVIE_QUEUE_FRAMES; framenum++)
+		capture->frame[framenum].capture = capture;
+
+	/* fill in the text and rate now, while the machine is ours to look at */
+	sprintf(capture->software, APPNAME " %s", build_version);
+	sprintf(capture->system, "%s %s", machine->gamedrv->manufacturer, machine->gamedrv->description);
+	capture->rate = ATTOSECONDS_TO_HZ(info->state->refresh);
+	info->movie = capture;
+}
+
+
+/*-------------------------------------------------
+    movie_record_frame - queue a frame of a movie
+    for encoding, dropping it if the encoder is
+    too far behind
 -------------------------------------------------*/
 
 static void movie_record_frame(running_machine *machine, int scrnum)
 {
 	video_private *viddata = machine->video_data;
 	internal_screen_info *info = &viddata->scrinfo[scrnum];
-	const rgb_t *palette;
+	movie_capture *capture = info->movie;
+	movie_frame *frame;
+	mame_bitmap *bitmap;
+	INT16 *sound;
+	UINT32 alloc;
+	int y;
 
-	/* only record if we have a file */
-	if (info->movie_file != NULL)
+	/* only record if we have a movie */
+	if (capture == NULL)
+		return;
+
+	/* stop if the encoder has given up */
+	if (capture->error)
 	{
-		png_info pnginfo = { 0 };
-		mame_bitmap *bitmap;
-		png_error error;
+		video_movie_end_recording(machine, scrnum);
+		return;
+	}
 
-		profiler_mark(PROFILER_MOVIE_REC);
+	profiler_mark(PROFILER_MOVIE_REC);
 
-		/* get the bitmap */
-		bitmap = get_snapshot_bitmap(machine, scrnum);
-		if (bitmap == NULL)
+	/* if the oldest frame is still being encoded, drop this one; the encoder repeats the previous frame in its place */
+	capture->frames++;
+	frame = &capture->frame[capture->nextframe];
+	if (frame->item != NULL)
+	{
+		if (!osd_work_item_wait(frame->item, 0))
+		{
+			capture->repeat++;
+			capture->dropped++;
+			profiler_mark(PROFILER_END);
 			return;
+		}
+		osd_work_item_release(frame->item);
+		frame->item = NULL;
+	}
+
+	/* get the bitmap */
+	bitmap = get_snapshot_bitmap(machine, scrnum);
+	if (bitmap == NULL)
+	{
+		profiler_mark(PROFILER_END);
+		return;
+	}
+
+	/* copy it into the frame */
+	if (frame->bitmap == NULL || frame->bitmap->width != bitmap->width || frame->bitmap->height != bitmap->height)
+	{
+		if (frame->bitmap != NULL)
+			bitmap_free(frame->bitmap);
+		frame->bitmap = bitmap_alloc(bitmap->width, bitmap->height, bitmap->format);
+	}
+	for (y = 0; y < bitmap->height; y++)
+		memcpy(BITMAP_ADDR32(frame->bitmap, y, 0), BITMAP_ADDR32(bitmap, y, 0), bitmap->width * sizeof(UINT32));
+
+	/* hand over the sound gathered so far by swapping buffers */
+	sound = frame->sound;
+	alloc = frame->soundalloc;
+	frame->sound = capture->sound;
+	frame->soundalloc = capture->soundalloc;
+	frame->samples = capture->samples;
+	capture->sound = sound;
+	capture->soundalloc = alloc;
+	capture->samples = 0;
+
+	/* account for any frames dropped in between */
+	frame->repeat = capture->repeat;
+	capture->repeat = 0;
+
+	/* queue it; without a queue, encode in place */
+	if (capture->queue != NULL)
+		frame->item = osd_work_item_queue(capture->queue, movie_encode_frame, frame, 0);
+	if (frame->item == NULL)
+		movie_encode_frame(frame, 0);
+	capture->nextframe = (capture->nextframe + 1) % MOVIE_QUEUE_FRAMES;
+
+	profiler_mark(PROFILER_END);
+}
+
+
+/*-------------------------------------------------
+    movie_encode_frame - work callback to write
+    one queued frame
+-------------------------------------------------*/
+
+static void *movie_encode_frame(void *param, int threadid)
+{
+	movie_frame *frame = param;
+	movie_capture *capture = frame->capture;
+
+	/* once we've failed, ignore everything else */
+	if (capture->error)
+		return NULL;
+
+	if (capture->mngfile != NULL)
+	{
+		if (!movie_write_mng(capture, frame))
+			capture->error = TRUE;
+	}
+	else
+	{
+		if (!movie_write_avi(capture, frame))
+			capture->error = TRUE;
+	}
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    movie_write_mng - PNG-encode a frame into the
+    MNG; dropped frames are simply left out
+-------------------------------------------------*/
+
+static int movie_write_mng(movie_capture *capture, movie_frame *frame)
+{
+	core_file *file = mame_core_file(capture->mngfile);
+	png_info pnginfo = { 0 };
+	png_error error;
 
-		/* track frames */
-		if (info->movie_frame++ == 0)
+	/* start the capture with the first frame */
+	if (capture->written == 0)
+	{
+		png_add_text(&pnginfo, "Software", capture->software);
+		png_add_text(&pnginfo, "System", capture->system);
+		error = mng_capture_start(file, frame->bitmap, capture->rate);
+		if (error != PNGERR_NONE)
 		{
-			char text[256];
+			png_free(&pnginfo);
+			return FALSE;
+		}
+	}
+
+	/* write the frame */
+	error = mng_capture_frame(file, &pnginfo, frame->bitmap, 0, NULL);
+	png_free(&pnginfo);
+	if (error != PNGERR_NONE)
+		return FALSE;
+	capture->written++;
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    movie_write_avi - write a frame and its sound
+    into the AVI, repeating the previous frame for
+    any that were dropped; a frame without a
+    bitmap writes only the repeats
+-------------------------------------------------*/
+
+static int movie_write_avi(movie_capture *capture, movie_frame *frame)
+{
+	UINT32 count = frame->repeat + (frame->bitmap != NULL);
+	INT16 temp[1024];
+	UINT32 index;
+
+	/* create the file with the first frame */
+	if (capture->avi == NULL)
+	{
+		avi_movie_info info;
+
+		info.video_format = FORMAT_YUY2;
+		info.video_timescale = (UINT32)(capture->rate * 1000000.0 + 0.5);
+		info.video_sampletime = 1000000;
+		info.video_numsamples = 0;
+		info.video_width = frame->bitmap->width & ~1;
+		info.video_height = frame->bitmap->height;
+		info.video_depth = 16;
+		info.audio_format = 0;
+		info.audio_timescale = capture->sample_rate;
+		info.audio_sampletime = 1;
+		info.audio_numsamples = 0;
+		info.audio_channels = 2;
+		info.audio_samplebits = 16;
+		info.audio_samplerate = capture->sample_rate;
+
+		capture->yuvbitmap = bitmap_alloc(info.video_width, info.video_height, BITMAP_FORMAT_YUY16);
+		if (capture->yuvbitmap == NULL || info.video_width == 0)
+			return FALSE;
+		if (avi_create(capture->aviname, &info, &capture->avi) != AVIERR_NONE)
+			return FALSE;
+	}
 
-			/* set up the text fields in the movie info */
-			sprintf(text, APPNAME " %s", build_version);
-			png_add_text(&pnginfo, "Software", text);
-			sprintf(text, "%s %s", machine->gamedrv->manufacturer, machine->gamedrv->description);
-			png_add_text(&pnginfo, "System", text);
+	/* spread the sound evenly over the repeated frames and this one */
+	for (index = 0; index < count; index++)
+	{
+		UINT32 first = (UINT64)frame->samples * index / count;
+		UINT32 last = (UINT64)frame->samples * (index + 1) / count;
+		int channel;
 
-			/* start the capture */
-			error = mng_capture_start(mame_core_file(info->movie_file), bitmap, ATTOSECONDS_TO_HZ(viddata->scrinfo[scrnum].state->refresh));
-			if (error != PNGERR_NONE)
+		for (channel = 0; channel < 2; channel++)
+		{
+			UINT32 sampnum, chunk, i;
+
+			for (sampnum = first; sampnum < last; sampnum += chunk)
 			{
-				png_free(&pnginfo);
-				video_movie_end_recording(machine, scrnum);
-				return;
+				chunk = MIN(last - sampnum, ARRAY_LENGTH(temp));
+				for (i = 0; i < chunk; i++)
+					temp[i] = frame->sound[(sampnum + i) * 2 + channel];
+				if (avi_append_sound_samples(capture->avi, channel, temp, chunk) != AVIERR_NONE)
+					return FALSE;
 			}
 		}
 
-		/* write the next frame */
-		palette = (machine->palette != NULL) ? palette_entry_list_adjusted(machine->palette) : NULL;
-		error = mng_capture_frame(mame_core_file(info->movie_file), &pnginfo, bitmap, machine->drv->total_colors, palette);
-		png_free(&pnginfo);
-		if (error != PNGERR_NONE)
+		/* the repeats reuse the previous frame; the last pass converts this one */
+		if (index == frame->repeat)
+			rgb32_to_yuy16(capture->yuvbitmap, frame->bitmap);
+		if (avi_append_video_frame_yuy16(capture->avi, capture->yuvbitmap) != AVIERR_NONE)
+			return FALSE;
+		capture->written++;
+	}
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    rgb32_to_yuy16 - convert an RGB32 bitmap to
+    YUY16, averaging chroma over each pixel pair
+-------------------------------------------------*/
+
+static void rgb32_to_yuy16(bitmap_t *dest, const bitmap_t *source)
+{
+	int width = MIN(dest->width, source->width) & ~1;
+	int height = MIN(dest->height, source->height);
+	int x, y;
+
+	for (y = 0; y < height; y++)
+	{
+		const UINT32 *src = (const UINT32 *)source->base + y * source->rowpixels;
+		UINT16 *dst = (UINT16 *)dest->base + y * dest->rowpixels;
+
+		for (x = 0; x < width; x += 2)
 		{
-			video_movie_end_recording(machine, scrnum);
-			return;
+			int r0 = RGB_RED(src[x]), g0 = RGB_GREEN(src[x]), b0 = RGB_BLUE(src[x]);
+			int r1 = RGB_RED(src[x + 1]), g1 = RGB_GREEN(src[x + 1]), b1 = RGB_BLUE(src[x + 1]);
+			int r = r0 + r1, g = g0 + g1, b = b0 + b1;
+			int y0 = ((66 * r0 + 129 * g0 + 25 * b0 + 128) >> 8) + 16;
+			int y1 = ((66 * r1 + 129 * g1 + 25 * b1 + 128) >> 8) + 16;
+			int cb = ((-38 * r - 74 * g + 112 * b + 256) >> 9) + 128;
+			int cr = ((112 * r - 94 * g - 18 * b + 256) >> 9) + 128;
+
+			dst[x] = (y0 << 8) | cb;
+			dst[x + 1] = (y1 << 8) | cr;
 		}
-
-		profiler_mark(PROFILER_END);
 	}
 }
 
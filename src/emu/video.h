@@ -156,11 +156,15 @@ void video_save_active_screen_snapshots(running_machine *machine);
 
 /* ----- movie recording ----- */
 
-/* Movie recording */
+/* Movie recording; frames are encoded in the background and dropped if the encoder falls behind */
 int video_is_movie_active(running_machine *machine, int scrnum);
 void video_movie_begin_recording(running_machine *machine, int scrnum, const char *name);
+void video_avi_begin_recording(running_machine *machine, int scrnum, const char *name);
 void video_movie_end_recording(running_machine *machine, int scrnum);
 
+/* feed mixed stereo samples to any AVI being recorded */
+void video_avi_add_sound(running_machine *machine, const INT16 *sound, int numsamples);
+
 
 /* ----- crosshair rendering ----- */
 
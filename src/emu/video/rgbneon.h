@@ -0,0 +1,333 @@
+/***************************************************************************
+
+    rgbneon.h
+
+    NEON optimized RGB utilities.
+
+    The results are bit-for-bit identical to rgbgen.h, including its
+    wraparound and truncation behavior.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#ifndef __RGBNEON__
+#define __RGBNEON__
+
+#include <arm_neon.h>
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/* intermediate RGB values are stored in an int16x4_t, blue in lane 0 */
+typedef int16x4_t rgbint;
+
+/* intermediate RGB values are stored in an int16x4_t, blue in lane 0 */
+typedef int16x4_t rgbaint;
+
+
+
+/***************************************************************************
+    BASIC CONVERSIONS
+***************************************************************************/
+
+/*-------------------------------------------------
+    rgb_comp_to_rgbint - converts a trio of RGB
+    components to an rgbint type
+-------------------------------------------------*/
+
+INLINE void rgb_comp_to_rgbint(rgbint *rgb, INT16 r, INT16 g, INT16 b)
+{
+	*rgb = vcreate_s16(((UINT64)(UINT16)r << 32) | ((UINT64)(UINT16)g << 16) | (UINT64)(UINT16)b);
+}
+
+
+/*-------------------------------------------------
+    rgba_comp_to_rgbint - converts a quad of RGB
+    components to an rgbint type
+-------------------------------------------------*/
+
+INLINE void rgba_comp_to_rgbaint(rgbaint *rgb, INT16 a, INT16 r, INT16 g, INT16 b)
+{
+	*rgb = vcreate_s16(((UINT64)(UINT16)a << 48) | ((UINT64)(UINT16)r << 32) | ((UINT64)(UINT16)g << 16) | (UINT64)(UINT16)b);
+}
+
+
+/*-------------------------------------------------
+    rgb_to_rgbint - converts a packed trio of RGB
+    components to an rgbint type
+-------------------------------------------------*/
+
+INLINE void rgb_to_rgbint(rgbint *rgb, rgb_t color)
+{
+	*rgb = vreinterpret_s16_u16(vget_low_u16(vmovl_u8(vcreate_u8(color & 0x00ffffff))));
+}
+
+
+/*-------------------------------------------------
+    rgba_to_rgbaint - converts a packed quad of RGB
+    components to an rgbint type
+-------------------------------------------------*/
+
+INLINE void rgba_to_rgbaint(rgbaint *rgb, rgb_t color)
+{
+	*rgb = vreinterpret_s16_u16(vget_low_u16(vmovl_u8(vcreate_u8(color))));
+}
+
+
+/*-------------------------------------------------
+    rgbint_to_rgb - converts an rgbint back to
+    a packed trio of RGB values
+-------------------------------------------------*/
+
+INLINE rgb_t rgbint_to_rgb(const rgbint *color)
+{
+	uint16x4_t temp = vreinterpret_u16_s16(*color);
+	return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(temp, temp))), 0) & 0x00ffffff;
+}
+
+
+/*-------------------------------------------------
+    rgbaint_to_rgba - converts an rgbint back to
+    a packed quad of RGB values
+-------------------------------------------------*/
+
+INLINE rgb_t rgbaint_to_rgba(const rgbaint *color)
+{
+	uint16x4_t temp = vreinterpret_u16_s16(*color);
+	return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(temp, temp))), 0);
+}
+
+
+/*-------------------------------------------------
+    rgbint_to_rgb_clamp - converts an rgbint back
+    to a packed trio of RGB values, clamping them
+    to bytes first
+-------------------------------------------------*/
+
+INLINE rgb_t rgbint_to_rgb_clamp(const rgbint *color)
+{
+	return vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(*color, *color))), 0) & 0x00ffffff;
+}
+
+
+/*-------------------------------------------------
+    rgbaint_to_rgba_clamp - converts an rgbint back
+    to a packed quad of RGB values, clamping them
+    to bytes first
+-------------------------------------------------*/
+
+INLINE rgb_t rgbaint_to_rgba_clamp(const rgbaint *color)
+{
+	return vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(*color, *color))), 0);
+}
+
+
+
+/***************************************************************************
+    CORE MATH
+***************************************************************************/
+
+/*-------------------------------------------------
+    rgbint_add - add two rgbint values
+-------------------------------------------------*/
+
+INLINE void rgbint_add(rgbint *color1, const rgbint *color2)
+{
+	*color1 = vadd_s16(*color1, *color2);
+}
+
+
+/*-------------------------------------------------
+    rgbaint_add - add two rgbaint values
+-------------------------------------------------*/
+
+INLINE void rgbaint_add(rgbaint *color1, const rgbaint *color2)
+{
+	*color1 = vadd_s16(*color1, *color2);
+}
+
+
+/*-------------------------------------------------
+    rgbint_sub - subtract two rgbint values
+-------------------------------------------------*/
+
+INLINE void rgbint_sub(rgbint *color1, const rgbint *color2)
+{
+	*color1 = vsub_s16(*color1, *color2);
+}
+
+
+/*-------------------------------------------------
+    rgbaint_sub - subtract two rgbaint values
+-------------------------------------------------*/
+
+INLINE void rgbaint_sub(rgbaint *color1, const rgbaint *color2)
+{
+	*color1 = vsub_s16(*color1, *color2);
+}
+
+
+/*-------------------------------------------------
+    rgbint_subr - reverse subtract two rgbint
+    values
+-------------------------------------------------*/
+
+INLINE void rgbint_subr(rgbint *color1, const rgbint *color2)
+{
+	*color1 = vsub_s16(*color2, *color1);
+}
+
+
+/*-------------------------------------------------
+    rgbaint_subr - reverse subtract two rgbaint
+    values
+-------------------------------------------------*/
+
+INLINE void rgbaint_subr(rgbaint *color1, const rgbaint *color2)
+{
+	*color1 = vsub_s16(*color2, *color1);
+}
+
+
+
+/***************************************************************************
+    HIGHER LEVEL OPERATIONS
+***************************************************************************/
+
+/*-------------------------------------------------
+    rgbint_blend - blend two colors by the given
+    scale factor
+-------------------------------------------------*/
+
+INLINE void rgbint_blend(rgbint *color1, const rgbint *color2, UINT8 color1scale)
+{
+	int32x4_t sum = vmull_n_s16(*color1, (INT16)color1scale + 1);
+	sum = vmlal_n_s16(sum, *color2, 255 - (INT16)color1scale);
+	*color1 = vshrn_n_s32(sum, 8);
+}
+
+
+/*-------------------------------------------------
+    rgbaint_blend - blend two colors by the given
+    scale factor
+-------------------------------------------------*/
+
+INLINE void rgbaint_blend(rgbaint *color1, const rgbaint *color2, UINT8 color1scale)
+{
+	rgbint_blend(color1, color2, color1scale);
+}
+
+
+/*-------------------------------------------------
+    rgbint_scale_and_clamp - scale the given
+    color by an 8.8 scale factor and clamp to
+    byte values
+-------------------------------------------------*/
+
+INLINE void rgbint_scale_and_clamp(rgbint *color, INT16 colorscale)
+{
+	/* the scaled value is truncated to 16 bits before clamping, as in rgbgen.h */
+	int16x4_t temp = vshrn_n_s32(vmull_n_s16(*color, colorscale), 8);
+	*color = vmin_s16(vmax_s16(temp, vdup_n_s16(0)), vdup_n_s16(255));
+}
+
+
+/*-------------------------------------------------
+    rgbaint_scale_and_clamp - scale the given
+    color by an 8.8 scale factor and clamp to
+    byte values
+-------------------------------------------------*/
+
+INLINE void rgbaint_scale_and_clamp(rgbaint *color, INT16 colorscale)
+{
+	rgbint_scale_and_clamp(color, colorscale);
+}
+
+
+/*-------------------------------------------------
+    rgbneon_bilinear - runs the packed bilinear
+    filter of rgbgen.h on all four pairs at once;
+    returns the red/blue pair in lane 0 and the
+    alpha/green pair in lane 1, unmasked
+-------------------------------------------------*/
+
+INLINE uint32x2_t rgbneon_bilinear(rgb_t rgb00, rgb_t rgb01, rgb_t rgb10, rgb_t rgb11, UINT8 u, UINT8 v, int ashift, UINT32 amask)
+{
+	uint32x4_t mask = vcombine_u32(vcreate_u32(((UINT64)amask << 32) | 0x00ff00ff), vcreate_u32(((UINT64)amask << 32) | 0x00ff00ff));
+	uint32x4_t color0, color1;
+	uint32x2_t top, bottom;
+
+	/* lanes are rb0, ag0, rb1, ag1 */
+	color0 = vcombine_u32(vcreate_u32(((UINT64)(rgb00 >> ashift) << 32) | rgb00), vcreate_u32(((UINT64)(rgb10 >> ashift) << 32) | rgb10));
+	color1 = vcombine_u32(vcreate_u32(((UINT64)(rgb01 >> ashift) << 32) | rgb01), vcreate_u32(((UINT64)(rgb11 >> ashift) << 32) | rgb11));
+	color0 = vandq_u32(color0, mask);
+	color1 = vandq_u32(color1, mask);
+
+	/* horizontal pass; the arithmetic wraps at 32 bits just like the scalar code */
+	color0 = vaddq_u32(color0, vshrq_n_u32(vmulq_n_u32(vsubq_u32(color1, color0), u), 8));
+	color0 = vandq_u32(color0, mask);
+
+	/* vertical pass */
+	top = vget_low_u32(color0);
+	bottom = vget_high_u32(color0);
+	return vadd_u32(top, vshr_n_u32(vmul_n_u32(vsub_u32(bottom, top), v), 8));
+}
+
+
+/*-------------------------------------------------
+    rgb_bilinear_filter - bilinear filter between
+    four pixel values
+-------------------------------------------------*/
+
+INLINE rgb_t rgb_bilinear_filter(rgb_t rgb00, rgb_t rgb01, rgb_t rgb10, rgb_t rgb11, UINT8 u, UINT8 v)
+{
+	uint32x2_t result = rgbneon_bilinear(rgb00, rgb01, rgb10, rgb11, u, v, 0, 0x0000ff00);
+	return (vget_lane_u32(result, 1) & 0x0000ff00) | (vget_lane_u32(result, 0) & 0x00ff00ff);
+}
+
+
+/*-------------------------------------------------
+    rgba_bilinear_filter - bilinear filter between
+    four pixel values
+-------------------------------------------------*/
+
+INLINE rgb_t rgba_bilinear_filter(rgb_t rgb00, rgb_t rgb01, rgb_t rgb10, rgb_t rgb11, UINT8 u, UINT8 v)
+{
+	uint32x2_t result = rgbneon_bilinear(rgb00, rgb01, rgb10, rgb11, u, v, 8, 0x00ff00ff);
+	return ((vget_lane_u32(result, 1) << 8) & 0xff00ff00) | (vget_lane_u32(result, 0) & 0x00ff00ff);
+}
+
+
+/*-------------------------------------------------
+    rgbint_bilinear_filter - bilinear filter between
+    four pixel values
+-------------------------------------------------*/
+
+INLINE void rgbint_bilinear_filter(rgbint *color, rgb_t rgb00, rgb_t rgb01, rgb_t rgb10, rgb_t rgb11, UINT8 u, UINT8 v)
+{
+	uint32x2_t result = rgbneon_bilinear(rgb00, rgb01, rgb10, rgb11, u, v, 0, 0x0000ff00);
+	UINT32 rb = vget_lane_u32(result, 0);
+	UINT32 ag = vget_lane_u32(result, 1);
+	rgb_comp_to_rgbint(color, rb >> 16, ag >> 8, rb);
+}
+
+
+/*-------------------------------------------------
+    rgbaint_bilinear_filter - bilinear filter between
+    four pixel values
+-------------------------------------------------*/
+
+INLINE void rgbaint_bilinear_filter(rgbaint *color, rgb_t rgb00, rgb_t rgb01, rgb_t rgb10, rgb_t rgb11, UINT8 u, UINT8 v)
+{
+	uint32x2_t result = rgbneon_bilinear(rgb00, rgb01, rgb10, rgb11, u, v, 8, 0x00ff00ff);
+	UINT32 rb = vget_lane_u32(result, 0);
+	UINT32 ag = vget_lane_u32(result, 1);
+	rgba_comp_to_rgbaint(color, ag >> 16, rb >> 16, ag, rb);
+}
+
+
+#endif /* __RGBNEON__ */
@@ -18,6 +18,8 @@
 #include "rgbsse.h"
 #elif defined(__ALTIVEC__)
 #include "rgbvmx.h"
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include "rgbneon.h"
 #else
 #include "rgbgen.h"
 #endif
@@ -2212,7 +2212,7 @@ static avi_error soundbuf_flush(avi_file *file, int only_flush_full)
 
 		/* add up the samples */
 		if (channelsamples > 0)
-			file->info.audio_numsamples = stream->samples += channelsamples;
+			file->info.audio_numsamples = stream->samples += MIN(channelsamples, chunksamples);
 
 		/* advance past those */
 		processedsamples += chunksamples;
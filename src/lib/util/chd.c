@@ -53,6 +53,10 @@
 
 #define NO_MATCH					(~0)
 
+#define DEFAULT_CACHE_HUNKS			16			/* decompressed hunks kept in the LRU cache */
+#define DEFAULT_READAHEAD_HUNKS		2			/* hunks read ahead of sequential reads */
+#define COMPRESS_SLOTS				16			/* hunks in flight when compressing in parallel */
+
 
 
 /***************************************************************************
@@ -102,6 +106,31 @@ struct _crcmap_entry
 };
 
 
+/* a single entry in the LRU hunk cache */
+typedef struct _hunk_cache_entry hunk_cache_entry;
+struct _hunk_cache_entry
+{
+	UINT32					hunknum;		/* hunk held here, or ~0 if empty */
+	UINT64					lastused;		/* LRU stamp of the most recent use */
+	UINT8 *					data;			/* decompressed hunk data */
+};
+
+
+/* a hunk being compressed on a worker thread */
+typedef struct _compress_slot compress_slot;
+struct _compress_slot
+{
+	chd_file *				chd;			/* CHD being compressed */
+	osd_work_item *			item;			/* pending compression work, or NULL */
+	void *					codecdata;		/* this slot's private codec state */
+	UINT8 *					data;			/* copy of the source hunk */
+	UINT8 *					compressed;		/* compressed result */
+	UINT32					crc;			/* CRC of the source hunk */
+	UINT32					length;			/* length of the compressed result */
+	chd_error				err;			/* result of compression */
+};
+
+
 /* a single metadata entry */
 typedef struct _metadata_entry metadata_entry;
 struct _metadata_entry
@@ -130,6 +159,14 @@ struct _chd_file
 	UINT8 *					cache;			/* hunk cache pointer */
 	UINT32					cachehunk;		/* index of currently cached hunk */
 
+	hunk_cache_entry *		hunkcache;		/* LRU cache of decompressed hunks, or NULL */
+	UINT8 *					hunkcachedata;	/* memory backing the LRU cache */
+	UINT32					hunkcachesize;	/* number of hunks in the LRU cache */
+	UINT32					readahead;		/* hunks to read ahead of sequential reads */
+	UINT64					lrustamp;		/* most recent LRU stamp handed out */
+	UINT32					lasthunk;		/* last hunk read by chd_read */
+	chd_cache_stats			cachestats;		/* LRU cache statistics */
+
 	UINT8 *					compare;		/* hunk compare pointer */
 	UINT32					comparehunk;	/* index of current compare data */
 
@@ -147,6 +184,9 @@ struct _chd_file
 	struct MD5Context		compmd5; 		/* running MD5 during compression */
 	struct sha1_ctx			compsha1; 		/* running SHA1 during compression */
 	UINT32					comphunk;		/* next hunk we will compress */
+	osd_work_queue *		compqueue;		/* work queue for parallel compression, or NULL */
+	compress_slot *			compslot;		/* ring of hunks being compressed in parallel */
+	UINT32					compwritten;	/* next hunk to write out of the ring */
 
 	UINT8					verifying;		/* are we verifying? */
 	struct MD5Context		vermd5; 		/* running MD5 during verification */
@@ -157,6 +197,10 @@ struct _chd_file
 	osd_work_item *			workitem;		/* active work item, or NULL if none */
 	UINT32					async_hunknum;	/* hunk index for asynchronous operations */
 	void *					async_buffer;	/* buffer pointer for asynchronous operations */
+
+	osd_work_item *			readaheaditem;	/* active read-ahead work item, or NULL if none */
+	UINT32					readaheadhunk;	/* first hunk to read ahead */
+	UINT32					readaheadend;	/* hunk after the last one to read ahead */
 };
 
 
@@ -196,6 +240,14 @@ static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 /* internal async operations */
 static void *async_read_callback(void *param, int threadid);
 static void *async_write_callback(void *param, int threadid);
+static void *readahead_callback(void *param, int threadid);
+static void *compress_callback(void *param, int threadid);
+
+/* internal parallel compression */
+static void compress_pipeline_init(chd_file *chd);
+static void compress_pipeline_free(chd_file *chd);
+static chd_error compress_write_hunk(chd_file *chd, UINT32 hunknum, const void *data, const compress_slot *slot);
+static chd_error compress_flush_hunk(chd_file *chd);
 
 /* internal header operations */
 static chd_error header_validate(const chd_header *header);
@@ -205,7 +257,16 @@ static chd_error header_write(core_file *file, const chd_header *header);
 /* internal hunk read/write */
 static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum);
 static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest);
-static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src);
+static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src, const compress_slot *slot);
+
+/* internal LRU hunk cache */
+static int hunk_cache_alloc(chd_file *chd);
+static void hunk_cache_free(chd_file *chd);
+static hunk_cache_entry *hunk_cache_find(chd_file *chd, UINT32 hunknum);
+static chd_error hunk_cache_fill(chd_file *chd, UINT32 hunknum, hunk_cache_entry **result);
+static chd_error hunk_read_through_cache(chd_file *chd, UINT32 hunknum, UINT8 *dest);
+static void hunk_cache_invalidate(chd_file *chd, UINT32 hunknum);
+static void queue_readahead(chd_file *chd, UINT32 hunknum);
 
 /* internal map access */
 static chd_error map_write_initial(core_file *file, chd_file *parent, const chd_header *header);
@@ -224,6 +285,9 @@ static chd_error metadata_set_length(chd_file *chd, UINT64 offset, UINT32 length
 /* zlib compression codec */
 static chd_error zlib_codec_init(chd_file *chd);
 static void zlib_codec_free(chd_file *chd);
+static chd_error zlib_codec_alloc_data(zlib_codec_data **result);
+static void zlib_codec_free_data(zlib_codec_data *data);
+static chd_error zlib_codec_deflate(zlib_codec_data *data, const void *src, UINT32 srclength, UINT8 *dest, UINT32 *length);
 static chd_error zlib_codec_compress(chd_file *chd, const void *src, UINT32 *length);
 static chd_error zlib_codec_decompress(chd_file *chd, UINT32 srclength, void *dest);
 static voidpf zlib_fast_alloc(voidpf opaque, uInt items, uInt size);
@@ -469,6 +533,16 @@ INLINE void wait_for_pending_async(chd_file *chd)
 		if (!wait_successful)
 			osd_break_into_debugger("Pending async operation never completed!");
 	}
+
+	/* read-ahead has no result, so finish it off completely */
+	if (chd->readaheaditem != NULL)
+	{
+		int wait_successful = osd_work_item_wait(chd->readaheaditem, 10 * osd_ticks_per_second());
+		if (!wait_successful)
+			osd_break_into_debugger("Pending read-ahead never completed!");
+		osd_work_item_release(chd->readaheaditem);
+		chd->readaheaditem = NULL;
+	}
 }
 
 
@@ -649,6 +723,11 @@ chd_error chd_open_file(core_file *file, int mode, chd_file *parent, chd_file **
 	newchd->cachehunk = ~0;
 	newchd->comparehunk = ~0;
 
+	/* the LRU cache is allocated on the first read */
+	newchd->hunkcachesize = DEFAULT_CACHE_HUNKS;
+	newchd->readahead = DEFAULT_READAHEAD_HUNKS;
+	newchd->lasthunk = ~0;
+
 	/* allocate the temporary compressed buffer */
 	newchd->compressed = malloc(newchd->header.hunkbytes);
 	if (newchd->compressed == NULL)
@@ -774,6 +853,9 @@ void chd_close(chd_file *chd)
 	/* wait for any pending async operations */
 	wait_for_pending_async(chd);
 
+	/* abandon any compression still in flight */
+	compress_pipeline_free(chd);
+
 	/* kill the work queue and any work item */
 	if (chd->workitem != NULL)
 		osd_work_item_release(chd->workitem);
@@ -788,7 +870,8 @@ void chd_close(chd_file *chd)
 	if (chd->compressed != NULL)
 		free(chd->compressed);
 
-	/* free the hunk cache and compare data */
+	/* free the hunk caches and compare data */
+	hunk_cache_free(chd);
 	if (chd->compare != NULL)
 		free(chd->compare);
 	if (chd->cache != NULL)
@@ -969,6 +1052,8 @@ cleanup:
 
 chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 {
+	chd_error err;
+
 	/* punt if NULL or invalid */
 	if (chd == NULL || chd->cookie != COOKIE_VALUE)
 		return CHDERR_INVALID_PARAMETER;
@@ -981,7 +1066,15 @@ chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 	wait_for_pending_async(chd);
 
 	/* perform the read */
-	return hunk_read_into_memory(chd, hunknum, buffer);
+	err = hunk_read_through_cache(chd, hunknum, buffer);
+	if (err != CHDERR_NONE)
+		return err;
+
+	/* if the reads are sequential, decompress the next few hunks while this one is consumed */
+	if (hunknum == chd->lasthunk + 1)
+		queue_readahead(chd, hunknum + 1);
+	chd->lasthunk = hunknum;
+	return CHDERR_NONE;
 }
 
 
@@ -1035,7 +1128,7 @@ chd_error chd_write(chd_file *chd, UINT32 hunknum, const void *buffer)
 	wait_for_pending_async(chd);
 
 	/* then write out the hunk */
-	return hunk_write_from_memory(chd, hunknum, buffer);
+	return hunk_write_from_memory(chd, hunknum, buffer, NULL);
 }
 
 
@@ -1070,6 +1163,51 @@ chd_error chd_write_async(chd_file *chd, UINT32 hunknum, const void *buffer)
 }
 
 
+/*-------------------------------------------------
+    chd_set_cache - set the number of hunks held
+    in the LRU cache and how many hunks to read
+    ahead of sequential reads; zero hunks turns
+    the cache off
+-------------------------------------------------*/
+
+chd_error chd_set_cache(chd_file *chd, UINT32 hunks, UINT32 readahead)
+{
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE)
+		return CHDERR_INVALID_PARAMETER;
+
+	/* wait for any pending async operations */
+	wait_for_pending_async(chd);
+
+	/* drop the current cache; the next read allocates one of the new size */
+	hunk_cache_free(chd);
+	chd->hunkcachesize = hunks;
+
+	/* read-ahead can use at most half the cache so it never evicts itself */
+	chd->readahead = MIN(readahead, hunks / 2);
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    chd_get_cache_stats - return statistics about
+    the LRU hunk cache
+-------------------------------------------------*/
+
+chd_error chd_get_cache_stats(chd_file *chd, chd_cache_stats *stats)
+{
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE)
+		return CHDERR_INVALID_PARAMETER;
+
+	/* wait for any pending async operations */
+	wait_for_pending_async(chd);
+
+	*stats = chd->cachestats;
+	return CHDERR_NONE;
+}
+
+
 /*-------------------------------------------------
     chd_async_complete - get the result of a
     completed work item and clear it out of the
@@ -1342,6 +1480,8 @@ chd_error chd_compress_begin(chd_file *chd)
 	chd->compressing = TRUE;
 	chd->comphunk = 0;
 
+	/* spread the codec work across threads if we can */
+	compress_pipeline_init(chd);
 	return CHDERR_NONE;
 }
 
@@ -1353,20 +1493,70 @@ chd_error chd_compress_begin(chd_file *chd)
 
 chd_error chd_compress_hunk(chd_file *chd, const void *data, double *curratio)
 {
-	UINT32 thishunk = chd->comphunk++;
-	UINT64 sourceoffset = (UINT64)thishunk * (UINT64)chd->header.hunkbytes;
-	UINT32 bytestochecksum;
-	const void *crcdata;
+	UINT32 thishunk;
 	chd_error err;
 
 	/* error if in the wrong state */
 	if (!chd->compressing)
 		return CHDERR_INVALID_STATE;
+	thishunk = chd->comphunk++;
+
+	/* without a pipeline, just write out the hunk */
+	if (chd->compslot == NULL)
+		err = compress_write_hunk(chd, thishunk, data, NULL);
+
+	/* otherwise, hand the hunk to a worker, writing out the oldest one first if the ring is full */
+	else
+	{
+		compress_slot *slot = &chd->compslot[thishunk % COMPRESS_SLOTS];
+
+		err = CHDERR_NONE;
+		if (thishunk - chd->compwritten >= COMPRESS_SLOTS)
+			err = compress_flush_hunk(chd);
+		if (err != CHDERR_NONE)
+			return err;
+
+		memcpy(slot->data, data, chd->header.hunkbytes);
+		slot->item = osd_work_item_queue(chd->compqueue, compress_callback, slot, 0);
+		if (slot->item == NULL)
+			compress_callback(slot, 0);
+
+		/* drain everything after the final hunk so the last ratio is exact */
+		while (err == CHDERR_NONE && chd->comphunk >= chd->header.totalhunks && chd->compwritten < chd->comphunk)
+			err = compress_flush_hunk(chd);
+	}
+	if (err != CHDERR_NONE)
+		return err;
+
+	/* update the ratio with what has been written so far */
+	if (curratio != NULL && chd->compwritten > 0)
+	{
+		UINT64 curlength = core_fsize(chd->file);
+		*curratio = 1.0 - (double)curlength / (double)((UINT64)chd->compwritten * (UINT64)chd->header.hunkbytes);
+	}
+
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    compress_write_hunk - write a hunk to a CHD
+    being compressed and fold it into the
+    running checksums, in hunk order
+-------------------------------------------------*/
+
+static chd_error compress_write_hunk(chd_file *chd, UINT32 thishunk, const void *data, const compress_slot *slot)
+{
+	UINT64 sourceoffset = (UINT64)thishunk * (UINT64)chd->header.hunkbytes;
+	UINT32 bytestochecksum;
+	const void *crcdata;
+	chd_error err;
 
 	/* write out the hunk */
-	err = hunk_write_from_memory(chd, thishunk, data);
+	err = hunk_write_from_memory(chd, thishunk, data, slot);
 	if (err != CHDERR_NONE)
 		return err;
+	chd->compwritten = thishunk + 1;
 
 	/* if we are lossy, then we need to use the decompressed version in */
 	/* the cache as our MD5/SHA1 source */
@@ -1392,14 +1582,28 @@ chd_error chd_compress_hunk(chd_file *chd, const void *data, double *curratio)
 		(chd->map[thishunk].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
 		crcmap_add_entry(chd, thishunk);
 
-	/* update the ratio */
-	if (curratio != NULL)
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    compress_flush_hunk - wait for the oldest hunk
+    in the compression ring and write it out
+-------------------------------------------------*/
+
+static chd_error compress_flush_hunk(chd_file *chd)
+{
+	UINT32 hunknum = chd->compwritten;
+	compress_slot *slot = &chd->compslot[hunknum % COMPRESS_SLOTS];
+
+	/* wait for the worker to finish with it */
+	if (slot->item != NULL)
 	{
-		UINT64 curlength = core_fsize(chd->file);
-		*curratio = 1.0 - (double)curlength / (double)((UINT64)chd->comphunk * (UINT64)chd->header.hunkbytes);
+		while (!osd_work_item_wait(slot->item, 10 * osd_ticks_per_second())) ;
+		osd_work_item_release(slot->item);
+		slot->item = NULL;
 	}
-
-	return CHDERR_NONE;
+	return compress_write_hunk(chd, hunknum, slot->data, slot);
 }
 
 
@@ -1410,10 +1614,24 @@ chd_error chd_compress_hunk(chd_file *chd, const void *data, double *curratio)
 
 chd_error chd_compress_finish(chd_file *chd)
 {
+	chd_error err;
+
 	/* error if in the wrong state */
 	if (!chd->compressing)
 		return CHDERR_INVALID_STATE;
 
+	/* write out anything still in flight */
+	if (chd->compslot != NULL)
+	{
+		while (chd->compwritten < chd->comphunk)
+		{
+			err = compress_flush_hunk(chd);
+			if (err != CHDERR_NONE)
+				return err;
+		}
+		compress_pipeline_free(chd);
+	}
+
 	/* compute the final MD5/SHA1 values */
 	MD5Final(chd->header.md5, &chd->compmd5);
 	sha1_final(&chd->compsha1);
@@ -1585,7 +1803,7 @@ static void *async_read_callback(void *param, int threadid)
 	chd_error err;
 
 	/* read the hunk into the cache */
-	err = hunk_read_into_memory(chd, chd->async_hunknum, chd->async_buffer);
+	err = hunk_read_through_cache(chd, chd->async_hunknum, chd->async_buffer);
 
 	/* return the error */
 	return (void *)err;
@@ -1603,13 +1821,53 @@ static void *async_write_callback(void *param, int threadid)
 	chd_error err;
 
 	/* write the hunk from memory */
-	err = hunk_write_from_memory(chd, chd->async_hunknum, chd->async_buffer);
+	err = hunk_write_from_memory(chd, chd->async_hunknum, chd->async_buffer, NULL);
 
 	/* return the error */
 	return (void *)err;
 }
 
 
+/*-------------------------------------------------
+    readahead_callback - decompress upcoming
+    hunks into the LRU cache
+-------------------------------------------------*/
+
+static void *readahead_callback(void *param, int threadid)
+{
+	chd_file *chd = param;
+	hunk_cache_entry *entry;
+	UINT32 hunknum;
+
+	/* errors are left for the real read to report */
+	for (hunknum = chd->readaheadhunk; hunknum < chd->readaheadend; hunknum++)
+		if (hunk_cache_find(chd, hunknum) == NULL)
+		{
+			if (hunk_cache_fill(chd, hunknum, &entry) != CHDERR_NONE)
+				break;
+			chd->cachestats.readahead++;
+		}
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    compress_callback - CRC and compress a hunk
+    on a worker thread
+-------------------------------------------------*/
+
+static void *compress_callback(void *param, int threadid)
+{
+	compress_slot *slot = param;
+	UINT32 hunkbytes = slot->chd->header.hunkbytes;
+
+	/* the caller writes the result out in hunk order once we are done */
+	slot->crc = crc32(0, slot->data, hunkbytes);
+	slot->err = zlib_codec_deflate(slot->codecdata, slot->data, hunkbytes, slot->compressed, &slot->length);
+	return NULL;
+}
+
+
 
 /***************************************************************************
     INTERNAL HEADER OPERATIONS
@@ -1902,12 +2160,46 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 }
 
 
+/*-------------------------------------------------
+    hunk_read_through_cache - read a hunk into
+    memory via the LRU cache
+-------------------------------------------------*/
+
+static chd_error hunk_read_through_cache(chd_file *chd, UINT32 hunknum, UINT8 *dest)
+{
+	hunk_cache_entry *entry;
+	chd_error err;
+
+	/* A/V hunks decode according to the codec configuration, so never cache them */
+	if (chd->codecintf->config != NULL || !hunk_cache_alloc(chd))
+		return hunk_read_into_memory(chd, hunknum, dest);
+
+	/* find the hunk, or decompress it into the least recently used entry */
+	entry = hunk_cache_find(chd, hunknum);
+	if (entry != NULL)
+	{
+		chd->cachestats.hits++;
+		entry->lastused = ++chd->lrustamp;
+	}
+	else
+	{
+		chd->cachestats.misses++;
+		err = hunk_cache_fill(chd, hunknum, &entry);
+		if (err != CHDERR_NONE)
+			return err;
+	}
+
+	memcpy(dest, entry->data, chd->header.hunkbytes);
+	return CHDERR_NONE;
+}
+
+
 /*-------------------------------------------------
     hunk_write_from_memory - write a hunk from
     memory into a CHD
 -------------------------------------------------*/
 
-static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src)
+static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src, const compress_slot *slot)
 {
 	map_entry *entry = &chd->map[hunknum];
 	map_entry newentry;
@@ -1920,8 +2212,11 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 	if (hunknum > chd->maxhunk)
 		chd->maxhunk = hunknum;
 
-	/* first compute the CRC of the original data */
-	newentry.crc = crc32(0, &src[0], chd->header.hunkbytes);
+	/* anything cached for this hunk is about to be stale */
+	hunk_cache_invalidate(chd, hunknum);
+
+	/* first compute the CRC of the original data, unless a compression worker already has */
+	newentry.crc = (slot != NULL) ? slot->crc : crc32(0, &src[0], chd->header.hunkbytes);
 
 	/* if we're not a lossy codec, compute the CRC and look for matches */
 	if (!chd->codecintf->lossy)
@@ -1968,9 +2263,14 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 		}
 	}
 
-	/* now try compressing the data */
+	/* now try compressing the data, or pick up the compression worker's result */
 	err = CHDERR_COMPRESSION_ERROR;
-	if (chd->codecintf->compress != NULL)
+	if (slot != NULL)
+	{
+		err = slot->err;
+		bytes = slot->length;
+	}
+	else if (chd->codecintf->compress != NULL)
 		err = (*chd->codecintf->compress)(chd, src, &bytes);
 
 	/* if that worked, and we're lossy, decompress and CRC the result */
@@ -1984,7 +2284,7 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 	/* if we succeeded in compressing the data, replace our data pointer and mark it so */
 	if (err == CHDERR_NONE)
 	{
-		data = chd->compressed;
+		data = (slot != NULL) ? slot->compressed : chd->compressed;
 		newentry.length = bytes;
 		newentry.flags = MAP_ENTRY_TYPE_COMPRESSED;
 	}
@@ -2023,6 +2323,265 @@ write_entry:
 
 
 
+/***************************************************************************
+    INTERNAL LRU HUNK CACHE
+***************************************************************************/
+
+/*-------------------------------------------------
+    hunk_cache_alloc - make sure the LRU cache
+    is allocated; returns FALSE if the cache is
+    disabled or out of memory
+-------------------------------------------------*/
+
+static int hunk_cache_alloc(chd_file *chd)
+{
+	UINT32 entnum;
+
+	/* if we already have one, or don't want one, we're done */
+	if (chd->hunkcache != NULL || chd->hunkcachesize == 0)
+		return (chd->hunkcache != NULL);
+
+	/* allocate the entries and the hunk data */
+	chd->hunkcache = malloc(chd->hunkcachesize * sizeof(chd->hunkcache[0]));
+	chd->hunkcachedata = malloc((size_t)chd->hunkcachesize * chd->header.hunkbytes);
+	if (chd->hunkcache == NULL || chd->hunkcachedata == NULL)
+	{
+		/* carry on uncached rather than failing the read */
+		hunk_cache_free(chd);
+		chd->hunkcachesize = 0;
+		return FALSE;
+	}
+
+	/* all entries start out empty */
+	for (entnum = 0; entnum < chd->hunkcachesize; entnum++)
+	{
+		chd->hunkcache[entnum].hunknum = ~0;
+		chd->hunkcache[entnum].lastused = 0;
+		chd->hunkcache[entnum].data = chd->hunkcachedata + (size_t)entnum * chd->header.hunkbytes;
+	}
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_free - free the LRU cache
+-------------------------------------------------*/
+
+static void hunk_cache_free(chd_file *chd)
+{
+	if (chd->hunkcache != NULL)
+		free(chd->hunkcache);
+	if (chd->hunkcachedata != NULL)
+		free(chd->hunkcachedata);
+	chd->hunkcache = NULL;
+	chd->hunkcachedata = NULL;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_find - return the LRU cache entry
+    holding a hunk, or NULL if it isn't cached
+-------------------------------------------------*/
+
+static hunk_cache_entry *hunk_cache_find(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 entnum;
+
+	/* the cache is small enough that a linear scan is far cheaper than decompressing */
+	if (chd->hunkcache != NULL)
+		for (entnum = 0; entnum < chd->hunkcachesize; entnum++)
+			if (chd->hunkcache[entnum].hunknum == hunknum)
+				return &chd->hunkcache[entnum];
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_fill - decompress a hunk into the
+    least recently used LRU cache entry
+-------------------------------------------------*/
+
+static chd_error hunk_cache_fill(chd_file *chd, UINT32 hunknum, hunk_cache_entry **result)
+{
+	hunk_cache_entry *entry = &chd->hunkcache[0];
+	osd_ticks_t start;
+	chd_error err;
+	UINT32 entnum;
+
+	/* pick the victim */
+	for (entnum = 1; entnum < chd->hunkcachesize; entnum++)
+		if (chd->hunkcache[entnum].lastused < entry->lastused)
+			entry = &chd->hunkcache[entnum];
+	entry->hunknum = ~0;
+	entry->lastused = 0;
+
+	/* read and decompress, keeping track of the time spent */
+	start = osd_ticks();
+	err = hunk_read_into_memory(chd, hunknum, entry->data);
+	chd->cachestats.decompress_time += osd_ticks() - start;
+	if (err != CHDERR_NONE)
+		return err;
+
+	/* mark the entry valid and most recently used */
+	entry->hunknum = hunknum;
+	entry->lastused = ++chd->lrustamp;
+	*result = entry;
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_invalidate - drop a hunk that is
+    being rewritten from the LRU cache, along with
+    any hunks that refer to its data
+-------------------------------------------------*/
+
+static void hunk_cache_invalidate(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 entnum;
+
+	if (chd->hunkcache != NULL)
+		for (entnum = 0; entnum < chd->hunkcachesize; entnum++)
+		{
+			hunk_cache_entry *entry = &chd->hunkcache[entnum];
+			map_entry *mapentry;
+
+			if (entry->hunknum == ~0)
+				continue;
+			mapentry = &chd->map[entry->hunknum];
+			if (entry->hunknum == hunknum || ((mapentry->flags & MAP_ENTRY_FLAG_TYPE_MASK) == MAP_ENTRY_TYPE_SELF_HUNK && mapentry->offset == hunknum))
+			{
+				entry->hunknum = ~0;
+				entry->lastused = 0;
+			}
+		}
+}
+
+
+/*-------------------------------------------------
+    queue_readahead - start decompressing the
+    hunks following a sequential read
+-------------------------------------------------*/
+
+static void queue_readahead(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 end;
+
+	/* only bother if read-ahead is on and the cache is in use */
+	if (chd->readahead == 0 || chd->hunkcache == NULL)
+		return;
+
+	/* skip over what we already have */
+	end = MIN(hunknum + chd->readahead, chd->header.totalhunks);
+	while (hunknum < end && hunk_cache_find(chd, hunknum) != NULL)
+		hunknum++;
+	if (hunknum >= end)
+		return;
+
+	/* if no queue yet, create one on the fly */
+	if (chd->workqueue == NULL)
+	{
+		chd->workqueue = osd_work_queue_alloc(WORK_QUEUE_FLAG_IO);
+		if (chd->workqueue == NULL)
+			return;
+	}
+
+	/* queue the work; if that fails, the hunks are simply read when asked for */
+	chd->readaheadhunk = hunknum;
+	chd->readaheadend = end;
+	chd->readaheaditem = osd_work_item_queue(chd->workqueue, readahead_callback, chd, 0);
+}
+
+
+
+/***************************************************************************
+    INTERNAL PARALLEL COMPRESSION
+***************************************************************************/
+
+/*-------------------------------------------------
+    compress_pipeline_init - set up a ring of
+    hunks so that compression can run on worker
+    threads; on failure, compression simply
+    stays on the calling thread
+-------------------------------------------------*/
+
+static void compress_pipeline_init(chd_file *chd)
+{
+	int slotnum;
+
+	/* only zlib codecs can be run with private state; A/V stays serial */
+	compress_pipeline_free(chd);
+	if (chd->header.compression != CHDCOMPRESSION_ZLIB && chd->header.compression != CHDCOMPRESSION_ZLIB_PLUS)
+		return;
+
+	/* allocate the queue and the ring */
+	chd->compqueue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	chd->compslot = malloc(COMPRESS_SLOTS * sizeof(chd->compslot[0]));
+	if (chd->compqueue == NULL || chd->compslot == NULL)
+		goto error;
+	memset(chd->compslot, 0, COMPRESS_SLOTS * sizeof(chd->compslot[0]));
+
+	/* each slot gets its own buffers and deflater */
+	for (slotnum = 0; slotnum < COMPRESS_SLOTS; slotnum++)
+	{
+		compress_slot *slot = &chd->compslot[slotnum];
+
+		slot->chd = chd;
+		slot->data = malloc(chd->header.hunkbytes);
+		slot->compressed = malloc(chd->header.hunkbytes);
+		if (slot->data == NULL || slot->compressed == NULL)
+			goto error;
+		if (zlib_codec_alloc_data((zlib_codec_data **)&slot->codecdata) != CHDERR_NONE)
+			goto error;
+	}
+	chd->compwritten = chd->comphunk;
+	return;
+
+error:
+	compress_pipeline_free(chd);
+}
+
+
+/*-------------------------------------------------
+    compress_pipeline_free - wait for and free
+    the parallel compression ring
+-------------------------------------------------*/
+
+static void compress_pipeline_free(chd_file *chd)
+{
+	int slotnum;
+
+	/* free the slots, waiting for any work that is still in flight */
+	if (chd->compslot != NULL)
+	{
+		for (slotnum = 0; slotnum < COMPRESS_SLOTS; slotnum++)
+		{
+			compress_slot *slot = &chd->compslot[slotnum];
+
+			if (slot->item != NULL)
+			{
+				while (!osd_work_item_wait(slot->item, 10 * osd_ticks_per_second())) ;
+				osd_work_item_release(slot->item);
+			}
+			if (slot->codecdata != NULL)
+				zlib_codec_free_data(slot->codecdata);
+			if (slot->compressed != NULL)
+				free(slot->compressed);
+			if (slot->data != NULL)
+				free(slot->data);
+		}
+		free(chd->compslot);
+		chd->compslot = NULL;
+	}
+
+	/* free the queue */
+	if (chd->compqueue != NULL)
+		osd_work_queue_free(chd->compqueue);
+	chd->compqueue = NULL;
+}
+
+
+
 /***************************************************************************
     INTERNAL MAP ACCESS
 ***************************************************************************/
@@ -2445,6 +3004,24 @@ static chd_error metadata_set_length(chd_file *chd, UINT64 offset, UINT32 length
 -------------------------------------------------*/
 
 static chd_error zlib_codec_init(chd_file *chd)
+{
+	zlib_codec_data *data;
+	chd_error err;
+
+	/* allocate the codec state */
+	err = zlib_codec_alloc_data(&data);
+	if (err == CHDERR_NONE)
+		chd->codecdata = data;
+	return err;
+}
+
+
+/*-------------------------------------------------
+    zlib_codec_alloc_data - allocate and
+    initialize a set of ZLIB streams
+-------------------------------------------------*/
+
+static chd_error zlib_codec_alloc_data(zlib_codec_data **result)
 {
 	zlib_codec_data *data;
 	chd_error err;
@@ -2487,7 +3064,7 @@ static chd_error zlib_codec_init(chd_file *chd)
 
 	/* handle an error */
 	if (err == CHDERR_NONE)
-		chd->codecdata = data;
+		*result = data;
 	else
 		free(data);
 
@@ -2502,8 +3079,17 @@ static chd_error zlib_codec_init(chd_file *chd)
 
 static void zlib_codec_free(chd_file *chd)
 {
-	zlib_codec_data *data = chd->codecdata;
+	zlib_codec_free_data(chd->codecdata);
+}
+
 
+/*-------------------------------------------------
+    zlib_codec_free_data - free a set of ZLIB
+    streams
+-------------------------------------------------*/
+
+static void zlib_codec_free_data(zlib_codec_data *data)
+{
 	/* deinit the streams */
 	if (data != NULL)
 	{
@@ -2528,15 +3114,26 @@ static void zlib_codec_free(chd_file *chd)
 
 static chd_error zlib_codec_compress(chd_file *chd, const void *src, UINT32 *length)
 {
-	zlib_codec_data *data = chd->codecdata;
+	return zlib_codec_deflate(chd->codecdata, src, chd->header.hunkbytes, chd->compressed, length);
+}
+
+
+/*-------------------------------------------------
+    zlib_codec_deflate - compress a hunk with the
+    given ZLIB streams; the output buffer must be
+    as large as the input
+-------------------------------------------------*/
+
+static chd_error zlib_codec_deflate(zlib_codec_data *data, const void *src, UINT32 srclength, UINT8 *dest, UINT32 *length)
+{
 	int zerr;
 
-	/* reset the decompressor */
+	/* reset the compressor */
 	data->deflater.next_in = (void *)src;
-	data->deflater.avail_in = chd->header.hunkbytes;
+	data->deflater.avail_in = srclength;
 	data->deflater.total_in = 0;
-	data->deflater.next_out = chd->compressed;
-	data->deflater.avail_out = chd->header.hunkbytes;
+	data->deflater.next_out = dest;
+	data->deflater.avail_out = srclength;
 	data->deflater.total_out = 0;
 	zerr = deflateReset(&data->deflater);
 	if (zerr != Z_OK)
@@ -2546,7 +3143,7 @@ static chd_error zlib_codec_compress(chd_file *chd, const void *src, UINT32 *len
 	zerr = deflate(&data->deflater, Z_FINISH);
 
 	/* if we ended up with more data than we started with, return an error */
-	if (zerr != Z_STREAM_END || data->deflater.total_out >= chd->header.hunkbytes)
+	if (zerr != Z_STREAM_END || data->deflater.total_out >= srclength)
 		return CHDERR_COMPRESSION_ERROR;
 
 	/* otherwise, fill in the length and return success */
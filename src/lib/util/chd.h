@@ -202,6 +202,17 @@ struct _chd_header
 };
 
 
+/* LRU hunk cache statistics */
+typedef struct _chd_cache_stats chd_cache_stats;
+struct _chd_cache_stats
+{
+	UINT64	hits;						/* reads satisfied from the cache */
+	UINT64	misses;						/* reads that had to decompress their hunk */
+	UINT64	readahead;					/* hunks decompressed ahead of sequential reads */
+	osd_ticks_t decompress_time;		/* time spent reading and decompressing into the cache */
+};
+
+
 /* A/V codec decompression configuration */
 typedef struct _av_codec_decompress_config av_codec_decompress_config;
 struct _av_codec_decompress_config
@@ -272,6 +283,12 @@ chd_error chd_write_async(chd_file *chd, UINT32 hunknum, const void *buffer);
 /* wait for a previously issued async read/write to complete and return the error */
 chd_error chd_async_complete(chd_file *chd);
 
+/* set the number of decompressed hunks to cache and how far to read ahead of sequential reads */
+chd_error chd_set_cache(chd_file *chd, UINT32 hunks, UINT32 readahead);
+
+/* return statistics about the hunk cache */
+chd_error chd_get_cache_stats(chd_file *chd, chd_cache_stats *stats);
+
 
 
 /* ----- metadata management ----- */
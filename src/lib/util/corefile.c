@@ -504,19 +504,28 @@ char *core_fgets(char *s, int n, core_file *file)
 
 /*-------------------------------------------------
     core_fbuffer - return a pointer to the file
-    buffer; if it doesn't yet exist, load the
-    file into RAM first
+    buffer; if it doesn't yet exist, map the file
+    or load it into RAM first
 -------------------------------------------------*/
 
 const void *core_fbuffer(core_file *file)
 {
 	file_error filerr;
 	UINT32 read_length;
+	const void *base;
 
 	/* if we already have data, just return it */
 	if (file->data != NULL)
 		return file->data;
 
+	/* read-only files can be used in place if the OSD can map them; the mapping lives as long as the OSD file */
+	if ((file->openflags & OPEN_FLAG_WRITE) == 0 && osd_map(file->file, &base) == FILERR_NONE)
+	{
+		file->data = (UINT8 *)base;
+		file->data_allocated = FALSE;
+		return file->data;
+	}
+
 	/* allocate some memory */
 	file->data = malloc(file->length);
 	if (file->data == NULL)
@@ -10,6 +10,7 @@
 ***************************************************************************/
 
 #include "osdcore.h"
+#include "corestr.h"
 #include "unzip.h"
 
 #include <ctype.h>
@@ -22,7 +23,10 @@
 ***************************************************************************/
 
 /* number of open files to cache */
-#define ZIP_CACHE_SIZE	8
+#define ZIP_CACHE_SIZE	32
+
+/* minimum number of buckets in each index hash table */
+#define ZIP_MIN_HASH_SIZE	16
 
 /* offsets in end of central directory structure */
 #define ZIPESIG			0x00
@@ -103,14 +107,23 @@ static zip_file *zip_cache[ZIP_CACHE_SIZE];
 
 /* cache management */
 static void free_zip_file(zip_file *zip);
+static void promote_cache_entry(int cachenum);
 
 /* ZIP file parsing */
 static zip_error read_ecd(zip_file *zip);
-static zip_error get_compressed_data_offset(zip_file *zip, UINT64 *offset);
+static int parse_file_header(zip_file *zip, UINT32 cd_pos, zip_file_header *header);
+static zip_error build_index(zip_file *zip);
+static file_error read_zip_data(zip_file *zip, void *buffer, UINT64 offset, UINT32 length, UINT32 *actual);
+static zip_error get_compressed_data_offset(zip_file *zip, const zip_file_header *header, UINT64 *offset);
+
+/* index helpers */
+static UINT32 hash_crc(zip_file *zip, UINT32 crc);
+static UINT32 hash_filename(zip_file *zip, const char *filename);
+static int filename_match(const zip_file_header *header, const char *filename);
 
 /* decompression interfaces */
-static zip_error decompress_data_type_0(zip_file *zip, UINT64 offset, void *buffer, UINT32 length);
-static zip_error decompress_data_type_8(zip_file *zip, UINT64 offset, void *buffer, UINT32 length);
+static zip_error decompress_data_type_0(zip_file *zip, const zip_file_header *header, UINT64 offset, void *buffer, UINT32 length);
+static zip_error decompress_data_type_8(zip_file *zip, const zip_file_header *header, UINT64 offset, void *buffer, UINT32 length);
 
 
 
@@ -134,16 +147,17 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 	/* ensure we start with a NULL result */
 	*zip = NULL;
 
-	/* see if we are in the cache, and reopen if so */
+	/* see if we are in the cache, and share the existing entry if so */
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
 	{
 		zip_file *cached = zip_cache[cachenum];
 
-		/* if we have a valid entry and it matches our filename, use it and remove from the cache */
+		/* if we have a valid entry and it matches our filename, use it and move it to the top */
 		if (cached != NULL && cached->filename != NULL && strcmp(filename, cached->filename) == 0)
 		{
+			cached->refcount++;
+			promote_cache_entry(cachenum);
 			*zip = cached;
-			zip_cache[cachenum] = NULL;
 			return ZIPERR_NONE;
 		}
 	}
@@ -153,6 +167,15 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 	if (newzip == NULL)
 		return ZIPERR_OUT_OF_MEMORY;
 	memset(newzip, 0, sizeof(*newzip));
+	newzip->refcount = 1;
+
+	/* allocate the lock that serializes reads from multiple threads */
+	newzip->lock = osd_lock_alloc();
+	if (newzip->lock == NULL)
+	{
+		ziperr = ZIPERR_OUT_OF_MEMORY;
+		goto error;
+	}
 
 	/* open the file */
 	filerr = osd_open(filename, OPEN_FLAG_READ, &newzip->file, &newzip->length);
@@ -190,6 +213,11 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 		goto error;
 	}
 
+	/* index the central directory by CRC and filename */
+	ziperr = build_index(newzip);
+	if (ziperr != ZIPERR_NONE)
+		goto error;
+
 	/* make a copy of the filename for caching purposes */
 	string = malloc(strlen(filename) + 1);
 	if (string == NULL)
@@ -199,6 +227,23 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 	}
 	strcpy(string, filename);
 	newzip->filename = string;
+
+	/* find the first NULL entry in the cache */
+	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
+		if (zip_cache[cachenum] == NULL)
+			break;
+
+	/* if no room left in the cache, free the bottommost entry nobody is using */
+	if (cachenum == ARRAY_LENGTH(zip_cache))
+		while (--cachenum >= 0 && zip_cache[cachenum]->refcount != 0) ;
+	if (cachenum >= 0)
+	{
+		if (zip_cache[cachenum] != NULL)
+			free_zip_file(zip_cache[cachenum]);
+		zip_cache[cachenum] = newzip;
+		promote_cache_entry(cachenum);
+	}
+
 	*zip = newzip;
 	return ZIPERR_NONE;
 
@@ -209,32 +254,33 @@ error:
 
 
 /*-------------------------------------------------
-    zip_file_close - close a ZIP file and add it
-    to the cache
+    zip_file_close - release a reference to a ZIP
+    file, leaving it in the cache when possible
 -------------------------------------------------*/
 
 void zip_file_close(zip_file *zip)
 {
 	int cachenum;
 
+	/* other opens still need the file */
+	if (--zip->refcount > 0)
+		return;
+
 	/* close the open files */
 	if (zip->file != NULL)
 		osd_close(zip->file);
 	zip->file = NULL;
 
-	/* find the first NULL entry in the cache */
+	/* move to the top of the cache if we are in it */
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
-		if (zip_cache[cachenum] == NULL)
-			break;
-
-	/* if no room left in the cache, free the bottommost entry */
-	if (cachenum == ARRAY_LENGTH(zip_cache))
-		free_zip_file(zip_cache[--cachenum]);
+		if (zip_cache[cachenum] == zip)
+		{
+			promote_cache_entry(cachenum);
+			return;
+		}
 
-	/* move everyone else down and place us at the top */
-	if (cachenum != 0)
-		memmove(&zip_cache[1], &zip_cache[0], cachenum * sizeof(zip_cache[0]));
-	zip_cache[0] = zip;
+	/* we were never cached, or the cache was cleared while we were open */
+	free_zip_file(zip);
 }
 
 
@@ -247,11 +293,12 @@ void zip_file_cache_clear(void)
 {
 	int cachenum;
 
-	/* clear call cache entries */
+	/* clear call cache entries; files still open are freed when closed */
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
 		if (zip_cache[cachenum] != NULL)
 		{
-			free_zip_file(zip_cache[cachenum]);
+			if (zip_cache[cachenum]->refcount == 0)
+				free_zip_file(zip_cache[cachenum]);
 			zip_cache[cachenum] = NULL;
 		}
 }
@@ -289,38 +336,12 @@ const zip_file_header *zip_file_next_file(zip_file *zip)
 		zip->header.raw = NULL;
 	}
 
-	/* if we're at or past the end, we're done */
-	if (zip->cd_pos >= zip->ecd.cd_size)
-		return NULL;
-
 	/* extract file header info */
-	zip->header.raw                 = zip->cd + zip->cd_pos;
-	zip->header.rawlength           = ZIPCFN;
-	zip->header.signature           = read_dword(zip->header.raw + ZIPCENSIG);
-	zip->header.version_created     = read_word (zip->header.raw + ZIPCVER);
-	zip->header.version_needed      = read_word (zip->header.raw + ZIPCVXT);
-	zip->header.bit_flag            = read_word (zip->header.raw + ZIPCFLG);
-	zip->header.compression         = read_word (zip->header.raw + ZIPCMTHD);
-	zip->header.file_time           = read_word (zip->header.raw + ZIPCTIM);
-	zip->header.file_date           = read_word (zip->header.raw + ZIPCDAT);
-	zip->header.crc                 = read_dword(zip->header.raw + ZIPCCRC);
-	zip->header.compressed_length   = read_dword(zip->header.raw + ZIPCSIZ);
-	zip->header.uncompressed_length = read_dword(zip->header.raw + ZIPCUNC);
-	zip->header.filename_length     = read_word (zip->header.raw + ZIPCFNL);
-	zip->header.extra_field_length  = read_word (zip->header.raw + ZIPCXTL);
-	zip->header.file_comment_length = read_word (zip->header.raw + ZIPCCML);
-	zip->header.start_disk_number   = read_word (zip->header.raw + ZIPDSK);
-	zip->header.internal_attributes = read_word (zip->header.raw + ZIPINT);
-	zip->header.external_attributes = read_dword(zip->header.raw + ZIPEXT);
-	zip->header.local_header_offset = read_dword(zip->header.raw + ZIPOFST);
-	zip->header.filename            = (char *)zip->header.raw + ZIPCFN;
-
-	/* make sure we have enough data */
-	zip->header.rawlength += zip->header.filename_length;
-	zip->header.rawlength += zip->header.extra_field_length;
-	zip->header.rawlength += zip->header.file_comment_length;
-	if (zip->cd_pos + zip->header.rawlength > zip->ecd.cd_size)
+	if (!parse_file_header(zip, zip->cd_pos, &zip->header))
+	{
+		zip->header.raw = NULL;
 		return NULL;
+	}
 
 	/* NULL terminate the filename */
 	zip->header.saved = zip->header.raw[ZIPCFN + zip->header.filename_length];
@@ -338,32 +359,72 @@ const zip_file_header *zip_file_next_file(zip_file *zip)
 -------------------------------------------------*/
 
 zip_error zip_file_decompress(zip_file *zip, void *buffer, UINT32 length)
+{
+	return zip_file_decompress_entry(zip, &zip->header, buffer, length);
+}
+
+
+/*-------------------------------------------------
+    zip_file_find - look up a file in the
+    central directory index by name and/or CRC
+-------------------------------------------------*/
+
+const zip_file_header *zip_file_find(zip_file *zip, const char *filename, UINT32 crc, UINT32 flags)
+{
+	UINT32 entrynum;
+
+	/* CRC lookups walk the CRC chain, checking the name if requested */
+	if (flags & ZIP_FIND_CRC)
+	{
+		for (entrynum = zip->crchash[hash_crc(zip, crc)]; entrynum != ~0; entrynum = zip->crcnext[entrynum])
+			if (zip->entry[entrynum].crc == crc && (!(flags & ZIP_FIND_NAME) || filename_match(&zip->entry[entrynum], filename)))
+				return &zip->entry[entrynum];
+	}
+
+	/* name-only lookups walk the filename chain */
+	else if (flags & ZIP_FIND_NAME)
+	{
+		for (entrynum = zip->namehash[hash_filename(zip, filename)]; entrynum != ~0; entrynum = zip->namenext[entrynum])
+			if (filename_match(&zip->entry[entrynum], filename))
+				return &zip->entry[entrynum];
+	}
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    zip_file_decompress_entry - decompress a
+    specific file from a ZIP into the target
+    buffer; safe to call from multiple threads
+-------------------------------------------------*/
+
+zip_error zip_file_decompress_entry(zip_file *zip, const zip_file_header *header, void *buffer, UINT32 length)
 {
     zip_error ziperr;
     UINT64 offset;
 
     /* if we don't have enough buffer, error */
-    if (length < zip->header.uncompressed_length)
+    if (length < header->uncompressed_length)
     	return ZIPERR_BUFFER_TOO_SMALL;
 
     /* make sure the info in the header aligns with what we know */
-	if (zip->header.start_disk_number != zip->ecd.disk_number)
+	if (header->start_disk_number != zip->ecd.disk_number)
 		return ZIPERR_UNSUPPORTED;
 
     /* get the compressed data offset */
-    ziperr = get_compressed_data_offset(zip, &offset);
+    ziperr = get_compressed_data_offset(zip, header, &offset);
     if (ziperr != ZIPERR_NONE)
     	return ziperr;
 
     /* handle compression types */
-    switch (zip->header.compression)
+    switch (header->compression)
     {
     	case 0:
-    		ziperr = decompress_data_type_0(zip, offset, buffer, length);
+    		ziperr = decompress_data_type_0(zip, header, offset, buffer, length);
     		break;
 
 		case 8:
-    		ziperr = decompress_data_type_8(zip, offset, buffer, length);
+    		ziperr = decompress_data_type_8(zip, header, offset, buffer, length);
     		break;
 
     	default:
@@ -396,11 +457,35 @@ static void free_zip_file(zip_file *zip)
 			free(zip->ecd.raw);
 		if (zip->cd != NULL)
 			free(zip->cd);
+		if (zip->entry != NULL)
+			free(zip->entry);
+		if (zip->names != NULL)
+			free(zip->names);
+		if (zip->crchash != NULL)
+			free(zip->crchash);
+		if (zip->lock != NULL)
+			osd_lock_free(zip->lock);
 		free(zip);
 	}
 }
 
 
+/*-------------------------------------------------
+    promote_cache_entry - move a cache entry to
+    the top of the cache
+-------------------------------------------------*/
+
+static void promote_cache_entry(int cachenum)
+{
+	zip_file *zip = zip_cache[cachenum];
+
+	/* move everyone else down and place us at the top */
+	if (cachenum != 0)
+		memmove(&zip_cache[1], &zip_cache[0], cachenum * sizeof(zip_cache[0]));
+	zip_cache[0] = zip;
+}
+
+
 
 /***************************************************************************
     ZIP FILE PARSING
@@ -479,39 +564,213 @@ static zip_error read_ecd(zip_file *zip)
 }
 
 
+/*-------------------------------------------------
+    parse_file_header - extract a central
+    directory entry; returns FALSE if it runs
+    past the end of the central directory
+-------------------------------------------------*/
+
+static int parse_file_header(zip_file *zip, UINT32 cd_pos, zip_file_header *header)
+{
+	/* if we're at or past the end, we're done */
+	if (cd_pos + ZIPCFN > zip->ecd.cd_size)
+		return FALSE;
+
+	/* extract file header info */
+	header->raw                 = zip->cd + cd_pos;
+	header->rawlength           = ZIPCFN;
+	header->signature           = read_dword(header->raw + ZIPCENSIG);
+	header->version_created     = read_word (header->raw + ZIPCVER);
+	header->version_needed      = read_word (header->raw + ZIPCVXT);
+	header->bit_flag            = read_word (header->raw + ZIPCFLG);
+	header->compression         = read_word (header->raw + ZIPCMTHD);
+	header->file_time           = read_word (header->raw + ZIPCTIM);
+	header->file_date           = read_word (header->raw + ZIPCDAT);
+	header->crc                 = read_dword(header->raw + ZIPCCRC);
+	header->compressed_length   = read_dword(header->raw + ZIPCSIZ);
+	header->uncompressed_length = read_dword(header->raw + ZIPCUNC);
+	header->filename_length     = read_word (header->raw + ZIPCFNL);
+	header->extra_field_length  = read_word (header->raw + ZIPCXTL);
+	header->file_comment_length = read_word (header->raw + ZIPCCML);
+	header->start_disk_number   = read_word (header->raw + ZIPDSK);
+	header->internal_attributes = read_word (header->raw + ZIPINT);
+	header->external_attributes = read_dword(header->raw + ZIPEXT);
+	header->local_header_offset = read_dword(header->raw + ZIPOFST);
+	header->filename            = (char *)header->raw + ZIPCFN;
+
+	/* make sure we have enough data */
+	header->rawlength += header->filename_length;
+	header->rawlength += header->extra_field_length;
+	header->rawlength += header->file_comment_length;
+	return (cd_pos + header->rawlength <= zip->ecd.cd_size);
+}
+
+
+/*-------------------------------------------------
+    build_index - parse the whole central
+    directory once and hash it by CRC and by
+    filename
+-------------------------------------------------*/
+
+static zip_error build_index(zip_file *zip)
+{
+	zip_file_header header;
+	UINT32 namelength = 0;
+	UINT32 entrynum;
+	UINT32 cd_pos;
+	char *name;
+
+	/* count the entries and the space needed for their names */
+	for (cd_pos = 0; parse_file_header(zip, cd_pos, &header); cd_pos += header.rawlength)
+	{
+		zip->entries++;
+		namelength += header.filename_length + 1;
+	}
+
+	/* size the hash tables to the next power of two above the entry count */
+	for (zip->hashmask = ZIP_MIN_HASH_SIZE; zip->hashmask < zip->entries; zip->hashmask *= 2) ;
+	zip->hashmask--;
+
+	/* allocate everything; the four hash arrays share one block */
+	zip->entry = malloc(MAX(zip->entries, 1) * sizeof(zip->entry[0]));
+	zip->names = malloc(namelength + 1);
+	zip->crchash = malloc((2 * (zip->hashmask + 1) + 2 * zip->entries) * sizeof(zip->crchash[0]));
+	if (zip->entry == NULL || zip->names == NULL || zip->crchash == NULL)
+		return ZIPERR_OUT_OF_MEMORY;
+	zip->namehash = zip->crchash + zip->hashmask + 1;
+	zip->crcnext = zip->namehash + zip->hashmask + 1;
+	zip->namenext = zip->crcnext + zip->entries;
+	memset(zip->crchash, 0xff, 2 * (zip->hashmask + 1) * sizeof(zip->crchash[0]));
+
+	/* fill in the entries; insert in reverse so each chain is in directory order */
+	name = zip->names;
+	for (cd_pos = 0, entrynum = 0; entrynum < zip->entries; cd_pos += zip->entry[entrynum++].rawlength)
+	{
+		zip_file_header *entry = &zip->entry[entrynum];
+
+		parse_file_header(zip, cd_pos, entry);
+		memcpy(name, entry->filename, entry->filename_length);
+		name[entry->filename_length] = 0;
+		entry->filename = name;
+		name += entry->filename_length + 1;
+	}
+	for (entrynum = zip->entries; entrynum-- > 0; )
+	{
+		UINT32 crcbucket = hash_crc(zip, zip->entry[entrynum].crc);
+		UINT32 namebucket = hash_filename(zip, zip->entry[entrynum].filename);
+
+		zip->crcnext[entrynum] = zip->crchash[crcbucket];
+		zip->crchash[crcbucket] = entrynum;
+		zip->namenext[entrynum] = zip->namehash[namebucket];
+		zip->namehash[namebucket] = entrynum;
+	}
+	return ZIPERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    read_zip_data - read from the ZIP file,
+    reopening it if needed; serialized so that
+    several threads can decompress at once
+-------------------------------------------------*/
+
+static file_error read_zip_data(zip_file *zip, void *buffer, UINT64 offset, UINT32 length, UINT32 *actual)
+{
+	file_error filerr = FILERR_NONE;
+
+	osd_lock_acquire(zip->lock);
+
+	/* make sure the file handle is open */
+	if (zip->file == NULL)
+		filerr = osd_open(zip->filename, OPEN_FLAG_READ, &zip->file, &zip->length);
+
+	/* read the data */
+	if (filerr == FILERR_NONE)
+		filerr = osd_read(zip->file, buffer, offset, length, actual);
+
+	osd_lock_release(zip->lock);
+	return filerr;
+}
+
+
 /*-------------------------------------------------
     get_compressed_data_offset - return the
     offset of the compressed data
 -------------------------------------------------*/
 
-static zip_error get_compressed_data_offset(zip_file *zip, UINT64 *offset)
+static zip_error get_compressed_data_offset(zip_file *zip, const zip_file_header *header, UINT64 *offset)
 {
+	UINT8 buffer[ZIPNAME];
 	file_error error;
 	UINT32 read_length;
 
-	/* make sure the file handle is open */
-	if (zip->file == NULL)
-	{
-		int filerr = osd_open(zip->filename, OPEN_FLAG_READ, &zip->file, &zip->length);
-		if (filerr != FILERR_NONE)
-			return ZIPERR_FILE_ERROR;
-	}
-
 	/* now go read the fixed-sized part of the local file header */
-	error = osd_read(zip->file, zip->buffer, zip->header.local_header_offset, ZIPNAME, &read_length);
+	error = read_zip_data(zip, buffer, header->local_header_offset, ZIPNAME, &read_length);
 	if (error != FILERR_NONE || read_length != ZIPNAME)
 		return (error == FILERR_NONE) ? ZIPERR_FILE_TRUNCATED : ZIPERR_FILE_ERROR;
 
 	/* compute the final offset */
-	*offset = zip->header.local_header_offset + ZIPNAME;
-	*offset += read_word(zip->buffer + ZIPFNLN);
-	*offset += read_word(zip->buffer + ZIPXTRALN);
+	*offset = header->local_header_offset + ZIPNAME;
+	*offset += read_word(buffer + ZIPFNLN);
+	*offset += read_word(buffer + ZIPXTRALN);
 
 	return ZIPERR_NONE;
 }
 
 
 
+/***************************************************************************
+    INDEX HELPERS
+***************************************************************************/
+
+/*-------------------------------------------------
+    hash_crc - return the CRC hash bucket
+-------------------------------------------------*/
+
+static UINT32 hash_crc(zip_file *zip, UINT32 crc)
+{
+	return (crc ^ (crc >> 16)) & zip->hashmask;
+}
+
+
+/*-------------------------------------------------
+    hash_filename - return the filename hash
+    bucket, which covers only the part after the
+    last '/' and ignores case
+-------------------------------------------------*/
+
+static UINT32 hash_filename(zip_file *zip, const char *filename)
+{
+	const char *base = strrchr(filename, '/');
+	UINT32 hash = 0;
+
+	for (base = (base != NULL) ? base + 1 : filename; *base != 0; base++)
+		hash = hash * 31 + tolower((UINT8)*base);
+	return hash & zip->hashmask;
+}
+
+
+/*-------------------------------------------------
+    filename_match - compare a ZIP filename to
+    the expected filename, ignoring any leading
+    directories in the ZIP
+-------------------------------------------------*/
+
+static int filename_match(const zip_file_header *header, const char *filename)
+{
+	int length = strlen(filename);
+	const char *zipfile;
+
+	/* the ZIP filename must end with the one we want */
+	if (length > header->filename_length)
+		return FALSE;
+	zipfile = header->filename + header->filename_length - length;
+
+	return (core_stricmp(filename, zipfile) == 0 && (zipfile == header->filename || zipfile[-1] == '/'));
+}
+
+
+
 /***************************************************************************
     DECOMPRESSION INTERFACES
 ***************************************************************************/
@@ -521,16 +780,16 @@ static zip_error get_compressed_data_offset(zip_file *zip, UINT64 *offset)
     type 0 data (which is uncompressed)
 -------------------------------------------------*/
 
-static zip_error decompress_data_type_0(zip_file *zip, UINT64 offset, void *buffer, UINT32 length)
+static zip_error decompress_data_type_0(zip_file *zip, const zip_file_header *header, UINT64 offset, void *buffer, UINT32 length)
 {
 	file_error filerr;
 	UINT32 read_length;
 
 	/* the data is uncompressed; just read it */
-	filerr = osd_read(zip->file, buffer, offset, zip->header.compressed_length, &read_length);
+	filerr = read_zip_data(zip, buffer, offset, header->compressed_length, &read_length);
 	if (filerr != FILERR_NONE)
 		return ZIPERR_FILE_ERROR;
-	else if (read_length != zip->header.compressed_length)
+	else if (read_length != header->compressed_length)
 		return ZIPERR_FILE_TRUNCATED;
 	else
 		return ZIPERR_NONE;
@@ -542,16 +801,17 @@ static zip_error decompress_data_type_0(zip_file *zip, UINT64 offset, void *buff
     type 8 data (which is deflated)
 -------------------------------------------------*/
 
-static zip_error decompress_data_type_8(zip_file *zip, UINT64 offset, void *buffer, UINT32 length)
+static zip_error decompress_data_type_8(zip_file *zip, const zip_file_header *header, UINT64 offset, void *buffer, UINT32 length)
 {
-    UINT32 input_remaining = zip->header.compressed_length;
+    UINT32 input_remaining = header->compressed_length;
+    UINT8 inbuffer[ZIP_DECOMPRESS_BUFSIZE];
     UINT32 read_length;
     z_stream stream;
     int filerr;
     int zerr;
 
 	/* make sure we don't need a newer mechanism */
-	if (zip->header.version_needed > 0x14)
+	if (header->version_needed > 0x14)
 		return ZIPERR_UNSUPPORTED;
 
     /* reset the stream */
@@ -568,7 +828,7 @@ static zip_error decompress_data_type_8(zip_file *zip, UINT64 offset, void *buff
     while (1)
 	{
 		/* read in the next chunk of data */
-		filerr = osd_read(zip->file, zip->buffer, offset, MIN(input_remaining, sizeof(zip->buffer)), &read_length);
+		filerr = read_zip_data(zip, inbuffer, offset, MIN(input_remaining, sizeof(inbuffer)), &read_length);
 		if (filerr != FILERR_NONE)
 		{
 			inflateEnd(&stream);
@@ -584,7 +844,7 @@ static zip_error decompress_data_type_8(zip_file *zip, UINT64 offset, void *buff
 		}
 
 		/* fill out the input data */
-		stream.next_in = zip->buffer;
+		stream.next_in = inbuffer;
 		stream.avail_in = read_length;
 		input_remaining -= read_length;
 
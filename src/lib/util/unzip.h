@@ -23,6 +23,10 @@
 
 #define ZIP_DECOMPRESS_BUFSIZE	16384
 
+/* flags for zip_file_find */
+#define ZIP_FIND_NAME			0x0001		/* filename must match */
+#define ZIP_FIND_CRC			0x0002		/* CRC must match */
+
 /* Error types */
 enum _zip_error
 {
@@ -106,7 +110,17 @@ struct _zip_file
 	UINT32			cd_pos;					/* position in central directory */
 	zip_file_header	header;					/* current file header */
 
-	UINT8			buffer[ZIP_DECOMPRESS_BUFSIZE];	/* buffer for decompression */
+	osd_lock *		lock;					/* lock protecting the file handle */
+	int				refcount;				/* number of outstanding opens */
+
+	zip_file_header *entry;					/* indexed central directory entries */
+	UINT32			entries;				/* number of indexed entries */
+	char *			names;					/* NULL-terminated copies of the entry filenames */
+	UINT32			hashmask;				/* mask for the hash tables below */
+	UINT32 *		crchash;				/* head of each CRC hash chain */
+	UINT32 *		namehash;				/* head of each filename hash chain */
+	UINT32 *		crcnext;				/* next entry in each CRC hash chain */
+	UINT32 *		namenext;				/* next entry in each filename hash chain */
 };
 
 
@@ -139,5 +153,11 @@ const zip_file_header *zip_file_next_file(zip_file *zip);
 /* decompress the most recently found file in the ZIP */
 zip_error zip_file_decompress(zip_file *zip, void *buffer, UINT32 length);
 
+/* find a file by name and/or CRC using the central directory index */
+const zip_file_header *zip_file_find(zip_file *zip, const char *filename, UINT32 crc, UINT32 flags);
+
+/* decompress a file found with zip_file_find; may be called from several threads at once */
+zip_error zip_file_decompress_entry(zip_file *zip, const zip_file_header *header, void *buffer, UINT32 length);
+
 
 #endif	/* __UNZIP_H__ */
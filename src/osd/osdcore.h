@@ -165,6 +165,32 @@ file_error osd_read(osd_file *file, void *buffer, UINT64 offset, UINT32 length,
 file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 length, UINT32 *actual);
 
 
+/*-----------------------------------------------------------------------------
+    osd_map: map the entire contents of an open file into memory
+
+    Parameters:
+
+        file - handle to a file previously opened via osd_open with only
+            OPEN_FLAG_READ
+
+        base - pointer to a const void * to receive the address of the
+            first byte of the file; this is only valid if the function
+            returns FILERR_NONE
+
+    Return value:
+
+        a file_error describing any error that occurred while mapping the
+        file, or FILERR_NONE if no error occurred
+
+    Notes:
+
+        The mapping remains valid until the file is closed with osd_close.
+        OSDs that cannot map files should return FILERR_FAILURE; callers
+        must be prepared to fall back to osd_read.
+-----------------------------------------------------------------------------*/
+file_error osd_map(osd_file *file, const void **base);
+
+
 /*-----------------------------------------------------------------------------
     osd_rmfile: deletes a file
 
@@ -180,6 +206,32 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 l
 file_error osd_rmfile(const char *filename);
 
 
+/*-----------------------------------------------------------------------------
+    osd_stat: return the size and last modification time of a file
+
+    Parameters:
+
+        filename - path to the file to examine
+
+        filesize - pointer to a UINT64 to receive the size of the file
+
+        modified - pointer to a UINT64 to receive an OSD-dependent timestamp
+            of the last modification to the file; the only guarantee is
+            that it changes whenever the file contents are rewritten
+
+    Return value:
+
+        a file_error describing any error that occurred while examining
+        the file, or FILERR_NONE if no error occurred
+
+    Notes:
+
+        OSDs that cannot provide modification times should return
+        FILERR_FAILURE; callers must treat such files as always changed.
+-----------------------------------------------------------------------------*/
+file_error osd_stat(const char *filename, UINT64 *filesize, UINT64 *modified);
+
+
 /*-----------------------------------------------------------------------------
     osd_get_physical_drive_geometry: if the given path points to a physical
         drive, return the geometry of that drive
@@ -89,6 +89,17 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 l
 }
 
 
+//============================================================
+//  osd_map
+//============================================================
+
+file_error osd_map(osd_file *file, const void **base)
+{
+	// there is no portable way to map a file; callers will read it instead
+	return FILERR_FAILURE;
+}
+
+
 //============================================================
 //  osd_close
 //============================================================
@@ -101,6 +112,17 @@ file_error osd_close(osd_file *file)
 }
 
 
+//============================================================
+//  osd_stat
+//============================================================
+
+file_error osd_stat(const char *filename, UINT64 *filesize, UINT64 *modified)
+{
+	// there is no portable way to get a modification time
+	return FILERR_FAILURE;
+}
+
+
 //============================================================
 //  osd_get_physical_drive_geometry
 //============================================================
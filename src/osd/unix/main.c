@@ -327,6 +327,10 @@ const options_entry mame_unix_options[] =
 	{ NULL,                       NULL,       OPTION_HEADER,     "WINDOWS SOUND OPTIONS" },
 	{ "audio_latency(1-5)",       "2",        0,                 "set audio latency (increase to reduce glitches)" },
 
+	// framebuffer options
+	{ NULL,                       NULL,       OPTION_HEADER,     "FRAMEBUFFER OPTIONS" },
+	{ "fbformat",                 "auto",     0,                 "framebuffer pixel format: rgb888, bgr888, rgb565, rgb565be, or 'auto' to match /dev/fb0" },
+
 	// input options
 	{ NULL,                       NULL,       OPTION_HEADER,     "INPUT DEVICE OPTIONS" },
 	{ "dual_lightgun;dual",       "0",        OPTION_BOOLEAN,    "enable dual lightgun input" },
@@ -334,17 +338,46 @@ const options_entry mame_unix_options[] =
 	{ NULL }
 };
 
-struct rgb888 {
-    uint8_t b;
-    uint8_t g;
-    uint8_t r;
-    uint8_t a;
-};
-
 #define DRAW_WIDTH_MAX  LCD_SCREEN_WIDTH
 #define DRAW_HEIGHT_MAX LCD_SCREEN_HEIGHT
 
 render_target *g_render_target = NULL;
+
+/* software rendering is split into this many bands on g_render_queue */
+osd_work_queue *g_render_queue = NULL;
+int g_render_bands = 1;
+
+/* one rasterizer per supported framebuffer pixel format, instantiated at the end of this file */
+typedef void (*fb_draw_func)(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue, int numbands);
+
+void drawdd_rgb888_draw_primitives_threaded(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue, int numbands);
+void drawdd_bgr888_draw_primitives_threaded(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue, int numbands);
+void drawdd_rgb565_draw_primitives_threaded(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue, int numbands);
+void drawdd_rgb565be_draw_primitives_threaded(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue, int numbands);
+
+struct fb_format {
+    const char *name;
+    uint32_t bits_per_pixel;
+    uint32_t red_offset, green_offset, blue_offset;
+    fb_draw_func draw;
+};
+
+/* 'auto' takes the first entry matching the framebuffer layout; big-endian 565 must be asked for */
+static const struct fb_format g_fb_formats[] = {
+    { "rgb888",   32, 16, 8, 0,  drawdd_rgb888_draw_primitives_threaded },
+    { "bgr888",   32, 0,  8, 16, drawdd_bgr888_draw_primitives_threaded },
+    { "rgb565",   16, 11, 5, 0,  drawdd_rgb565_draw_primitives_threaded },
+    { "rgb565be", 16, 11, 5, 0,  drawdd_rgb565be_draw_primitives_threaded },
+};
+
+/* frames are rasterized straight into the mapped framebuffer, flipping pages when there are two */
+int g_fb_fd = -1;
+struct fb_var_screeninfo g_fb_vinfo;
+uint8_t *g_fb_base = NULL;
+uint32_t g_fb_line_length = 0;
+int g_fb_pages = 1;
+int g_fb_page = 0;
+const struct fb_format *g_fb_format = NULL;
 uint16_t read_key_state(void)
 {
 #if 1
@@ -492,6 +525,36 @@ void joystick_init(void)
     g_joystick_fd = fd;
 }
 
+void fb_select_format(const char *name)
+{
+    size_t i;
+    for (i = 0; i < sizeof(g_fb_formats) / sizeof(g_fb_formats[0]); i++) {
+        const struct fb_format *format = &g_fb_formats[i];
+        if (strcmp(name, "auto") == 0) {
+            if (format->bits_per_pixel == g_fb_vinfo.bits_per_pixel &&
+                format->red_offset == g_fb_vinfo.red.offset &&
+                format->green_offset == g_fb_vinfo.green.offset &&
+                format->blue_offset == g_fb_vinfo.blue.offset) {
+                break;
+            }
+        } else if (strcmp(name, format->name) == 0) {
+            break;
+        }
+    }
+
+    if (i == sizeof(g_fb_formats) / sizeof(g_fb_formats[0])) {
+        fprintf(stderr, "Unsupported framebuffer format '%s' (%ubpp, r%u g%u b%u)\n", name,
+            g_fb_vinfo.bits_per_pixel, g_fb_vinfo.red.offset, g_fb_vinfo.green.offset, g_fb_vinfo.blue.offset);
+        exit(1);
+    }
+    if (g_fb_formats[i].bits_per_pixel != g_fb_vinfo.bits_per_pixel) {
+        fprintf(stderr, "Framebuffer format '%s' needs %ubpp, /dev/fb0 is %ubpp\n", name,
+            g_fb_formats[i].bits_per_pixel, g_fb_vinfo.bits_per_pixel);
+        exit(1);
+    }
+    g_fb_format = &g_fb_formats[i];
+}
+
 int g_osd_inited = 0;
 void osd_init(running_machine *machine)
 {
@@ -508,6 +571,7 @@ void osd_init(running_machine *machine)
     	input_device_item_add(input_device, "test", &g_key_map[i], g_key_map[i].key_val, get_key_state);
     }
     joystick_init();
+    fb_select_format(options_get_string(mame_options(), "fbformat"));
     if (g_osd_inited != 0) {
         printf("already inited.\n");
         return;
@@ -524,7 +588,6 @@ void set_thread_affinity(uint32_t cpu)
 }
 
 #include <pthread.h>
-struct rgb888 *g_draw_buff = NULL;
 struct hdmi_rgba *g_test_hdmi_fb_bp;
 
 struct hdmi_rgba {
@@ -554,11 +617,6 @@ void lcd_test(int width, int height)
     sleep(1);
 }
 
-void output_hdmi_fb(struct rgb888 *pixels, int width, int height)
-{
-    memcpy(g_test_hdmi_fb_bp, pixels, sizeof(struct rgb888) * width * height);
-}
-
 void *check_key(void *arg)
 {
     set_thread_affinity(3);
@@ -619,43 +677,95 @@ void osd_update_audio_stream(INT16 *buffer, int samples_this_frame)
 
 void osd_update(int skip_redraw)
 {
-	if ((g_render_target == NULL) || (g_draw_buff == NULL)) {
+	render_primitive_list *head;
+	uint8_t *dest;
+	uint32_t pitch;
+	int page;
+
+	if ((g_render_target == NULL) || (g_fb_format == NULL)) {
 		return;
 	}
 
-	render_target_set_bounds(g_render_target, DRAW_WIDTH_MAX, DRAW_HEIGHT_MAX, 0);
-	render_primitive_list *head = render_target_get_primitives(g_render_target);
+	render_target_set_bounds(g_render_target, g_fb_vinfo.xres, g_fb_vinfo.yres, 0);
+	head = render_target_get_primitives(g_render_target);
 	if (head == NULL) {
 		printf("get primitives failed.\n");
 		return;
 	}
 
-	drawdd_rgb888_draw_primitives(head, g_draw_buff, DRAW_WIDTH_MAX, DRAW_HEIGHT_MAX, DRAW_WIDTH_MAX);
-    output_hdmi_fb(g_draw_buff, DRAW_HEIGHT_MAX, DRAW_WIDTH_MAX);
+	/* nothing to do if the frame is identical to the one on screen */
+	if (head->unchanged) {
+		return;
+	}
+
+	/* draw into the hidden page if we have one, otherwise straight into the visible one */
+	page = (g_fb_page + 1) % g_fb_pages;
+	dest = g_fb_base + (size_t)page * g_fb_vinfo.yres * g_fb_line_length;
+	pitch = g_fb_line_length / (g_fb_vinfo.bits_per_pixel / 8);
+
+	osd_lock_acquire(head->lock);
+	(*g_fb_format->draw)(head->head, dest, g_fb_vinfo.xres, g_fb_vinfo.yres, pitch, g_render_queue, g_render_bands);
+	osd_lock_release(head->lock);
+
+	if (g_fb_pages > 1) {
+		g_fb_vinfo.yoffset = page * g_fb_vinfo.yres;
+		if (ioctl(g_fb_fd, FBIOPAN_DISPLAY, &g_fb_vinfo) == 0) {
+			g_fb_page = page;
+		}
+	}
 }
 
 void hdmi_fb_init(void)
 {
+    struct fb_var_screeninfo vinfo;
+    struct fb_fix_screeninfo finfo;
+    int screensize;
+    char *fbp;
+
     int fbfd = open("/dev/fb0", O_RDWR);
     if (fbfd == -1) {
         perror("Error opening framebuffer device");
         exit(1);
     }
 
-    struct fb_var_screeninfo vinfo;
     if (ioctl(fbfd, FBIOGET_VSCREENINFO, &vinfo)) {
         perror("Error reading variable information");
         exit(1);
     }
 
-    int screensize = vinfo.yres_virtual * vinfo.xres_virtual * vinfo.bits_per_pixel / 8;
-    char *fbp = (char *)mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED, fbfd, 0);
-    if ((int)fbp == -1) {
+    /* ask for a second page to flip to; drivers that can't grow the virtual screen leave us with one */
+    if (vinfo.yres_virtual < 2 * vinfo.yres) {
+        struct fb_var_screeninfo request = vinfo;
+        request.yres_virtual = 2 * vinfo.yres;
+        request.yoffset = 0;
+        if (ioctl(fbfd, FBIOPUT_VSCREENINFO, &request) == 0 && ioctl(fbfd, FBIOGET_VSCREENINFO, &vinfo)) {
+            perror("Error reading variable information");
+            exit(1);
+        }
+    }
+
+    if (ioctl(fbfd, FBIOGET_FSCREENINFO, &finfo)) {
+        perror("Error reading fixed information");
+        exit(1);
+    }
+
+    screensize = vinfo.yres_virtual * finfo.line_length;
+    fbp = (char *)mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED, fbfd, 0);
+    if (fbp == MAP_FAILED) {
         perror("Error mapping framebuffer to memory");
         exit(1);
     }
     memset(fbp, 0, screensize);
     g_test_hdmi_fb_bp = (struct hdmi_rgba *)fbp;
+
+    g_fb_fd = fbfd;
+    g_fb_vinfo = vinfo;
+    g_fb_vinfo.xoffset = 0;
+    g_fb_vinfo.yoffset = 0;
+    g_fb_base = (uint8_t *)fbp;
+    g_fb_line_length = finfo.line_length;
+    g_fb_pages = (vinfo.yres_virtual >= 2 * vinfo.yres) ? 2 : 1;
+    g_fb_page = vinfo.yoffset / vinfo.yres % g_fb_pages;
 }
 
 
@@ -664,12 +774,17 @@ int main(int argc, const char **argv)
     gpio_init();
     hdmi_fb_init();
     g_pcm_handle = device_create();
-	g_draw_buff = malloc(sizeof(struct rgb888) * DRAW_WIDTH_MAX * DRAW_HEIGHT_MAX);
 
     pthread_t tid;
     pthread_create(&tid, NULL, check_key, NULL);
     pthread_create(&tid, NULL, poll_joystick, NULL);
-    lcd_test(DRAW_WIDTH_MAX, DRAW_HEIGHT_MAX);
+    if (g_fb_vinfo.bits_per_pixel == 32) {
+        lcd_test(DRAW_WIDTH_MAX, DRAW_HEIGHT_MAX);
+    }
+
+    /* create the render workers before pinning ourselves so they can use every core */
+    g_render_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+    g_render_bands = sysconf(_SC_NPROCESSORS_ONLN);
 
     set_thread_affinity(1);
     return cli_execute(argc, argv, mame_unix_options);
@@ -679,6 +794,8 @@ int main(int argc, const char **argv)
 //  SOFTWARE RENDERING
 //============================================================
 
+/* these draw straight into the mapped framebuffer, which is too slow to read back */
+
 #define FUNC_PREFIX(x)		drawdd_rgb888_##x
 #define PIXEL_TYPE			UINT32
 #define SRCSHIFT_R			0
@@ -687,5 +804,43 @@ int main(int argc, const char **argv)
 #define DSTSHIFT_R			16
 #define DSTSHIFT_G			8
 #define DSTSHIFT_B			0
+#define NO_DEST_READ		1
+
+#include "rendersw.c"
+
+#define FUNC_PREFIX(x)		drawdd_bgr888_##x
+#define PIXEL_TYPE			UINT32
+#define SRCSHIFT_R			0
+#define SRCSHIFT_G			0
+#define SRCSHIFT_B			0
+#define DSTSHIFT_R			0
+#define DSTSHIFT_G			8
+#define DSTSHIFT_B			16
+#define NO_DEST_READ		1
+
+#include "rendersw.c"
+
+#define FUNC_PREFIX(x)		drawdd_rgb565_##x
+#define PIXEL_TYPE			UINT16
+#define SRCSHIFT_R			3
+#define SRCSHIFT_G			2
+#define SRCSHIFT_B			3
+#define DSTSHIFT_R			11
+#define DSTSHIFT_G			5
+#define DSTSHIFT_B			0
+#define NO_DEST_READ		1
+
+#include "rendersw.c"
+
+#define FUNC_PREFIX(x)		drawdd_rgb565be_##x
+#define PIXEL_TYPE			UINT16
+#define SRCSHIFT_R			3
+#define SRCSHIFT_G			2
+#define SRCSHIFT_B			3
+#define DSTSHIFT_R			11
+#define DSTSHIFT_G			5
+#define DSTSHIFT_B			0
+#define DEST_BIG_ENDIAN		1
+#define NO_DEST_READ		1
 
 #include "rendersw.c"
@@ -8,80 +8,230 @@
 
 ***************************************************************************/
 
+#define _FILE_OFFSET_BITS 64
+
 #include "osdcore.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "mamecore.h"
 #include "inptport.h"
 
+struct _osd_file
+{
+	int			fd;				// file descriptor
+	UINT32		openflags;		// flags we were opened with
+	void *		map;			// mapping of the whole file, or NULL
+	UINT64		maplength;		// length of the mapping
+	UINT64		nextoffset;		// offset following the last read
+	int			sequential;		// have we told the kernel we are streaming?
+};
+
+static file_error errno_to_file_error(int err)
+{
+	switch (err)
+	{
+		case ENOENT:
+		case ENOTDIR:
+			return FILERR_NOT_FOUND;
+
+		case EACCES:
+		case EROFS:
+		case EPERM:
+			return FILERR_ACCESS_DENIED;
+
+		case EMFILE:
+		case ENFILE:
+			return FILERR_TOO_MANY_FILES;
+
+		case ENOMEM:
+			return FILERR_OUT_OF_MEMORY;
+
+		default:
+			return FILERR_FAILURE;
+	}
+}
+
+// create every missing directory leading up to the final component of path
+static int create_path_recursive(char *path)
+{
+	char *sep = strrchr(path, '/');
+	struct stat st;
+	int result = 0;
+
+	// nothing to create above a bare name or the root
+	if (sep == NULL || sep == path)
+		return 0;
+
+	// create the parent first if it doesn't exist
+	*sep = 0;
+	if (stat(path, &st) != 0)
+	{
+		result = create_path_recursive(path);
+		if (result == 0 && mkdir(path, 0777) != 0 && errno != EEXIST)
+			result = errno;
+	}
+	*sep = '/';
+	return result;
+}
+
 file_error osd_open(const char *path, UINT32 openflags, osd_file **file, UINT64 *filesize)
 {
-	const char *mode;
-	FILE *fileptr;
+	struct stat st;
+	int access;
+	int fd;
 
 	// based on the flags, choose a mode
 	if (openflags & OPEN_FLAG_WRITE)
 	{
 		if (openflags & OPEN_FLAG_READ)
-			mode = (openflags & OPEN_FLAG_CREATE) ? "w+b" : "r+b";
+			access = (openflags & OPEN_FLAG_CREATE) ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR;
 		else
-			mode = "wb";
+			access = O_WRONLY | O_CREAT | O_TRUNC;
 	}
 	else if (openflags & OPEN_FLAG_READ)
-		mode = "rb";
+		access = O_RDONLY;
 	else
 		return FILERR_INVALID_ACCESS;
 
 	// open the file
-	fileptr = fopen(path, mode);
-	if (fileptr == NULL)
-		return FILERR_NOT_FOUND;
+	fd = open(path, access, 0666);
 
-	// store the file pointer directly as an osd_file
-	*file = (osd_file *)fileptr;
+	// if the directory is missing and we may create it, do so and try again
+	if (fd == -1 && errno == ENOENT && (openflags & OPEN_FLAG_CREATE_PATHS))
+	{
+		char *pathcopy = malloc(strlen(path) + 1);
+		int err;
+
+		if (pathcopy == NULL)
+			return FILERR_OUT_OF_MEMORY;
+		strcpy(pathcopy, path);
+		err = create_path_recursive(pathcopy);
+		free(pathcopy);
+		if (err != 0)
+			return errno_to_file_error(err);
+		fd = open(path, access, 0666);
+	}
+	if (fd == -1)
+		return errno_to_file_error(errno);
 
-	// get the size -- note that most fseek/ftell implementations are limited to 32 bits
-	fseek(fileptr, 0, SEEK_END);
-	*filesize = ftell(fileptr);
-	fseek(fileptr, 0, SEEK_SET);
+	// get the size; off_t is 64 bits here, so large CHDs are fine
+	if (fstat(fd, &st) != 0)
+	{
+		file_error filerr = errno_to_file_error(errno);
+		close(fd);
+		return filerr;
+	}
+
+	// allocate the file object
+	*file = malloc(sizeof(**file));
+	if (*file == NULL)
+	{
+		close(fd);
+		return FILERR_OUT_OF_MEMORY;
+	}
+	memset(*file, 0, sizeof(**file));
+	(*file)->fd = fd;
+	(*file)->openflags = openflags;
 
+	*filesize = st.st_size;
 	return FILERR_NONE;
 }
 
 file_error osd_close(osd_file *file)
 {
-	// close the file handle
-	fclose((FILE *)file);
+	// release the mapping and close the file
+	if (file->map != NULL)
+		munmap(file->map, file->maplength);
+	close(file->fd);
+	free(file);
 	return FILERR_NONE;
 }
 
 file_error osd_read(osd_file *file, void *buffer, UINT64 offset, UINT32 length, UINT32 *actual)
 {
-	size_t count;
+	UINT32 count = 0;
 
-	// seek to the new location; note that most fseek implementations are limited to 32 bits
-	fseek((FILE *)file, offset, SEEK_SET);
+	// once reads pick up where the last one left off, ask for more aggressive read-ahead;
+	// drop back to the default as soon as we see a seek
+	if ((offset == file->nextoffset && offset != 0) != file->sequential)
+	{
+		file->sequential = !file->sequential;
+		posix_fadvise(file->fd, 0, 0, file->sequential ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_NORMAL);
+	}
+
+	// perform the read, which may come back short
+	while (count < length)
+	{
+		ssize_t result = pread(file->fd, (UINT8 *)buffer + count, length - count, offset + count);
+		if (result == -1 && errno == EINTR)
+			continue;
+		if (result == -1)
+			return errno_to_file_error(errno);
+		if (result == 0)
+			break;
+		count += result;
+	}
+	file->nextoffset = offset + count;
 
-	// perform the read
-	count = fread(buffer, 1, length, (FILE *)file);
 	if (actual != NULL)
 		*actual = count;
-
 	return FILERR_NONE;
 }
 
 file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 length, UINT32 *actual)
 {
-	size_t count;
+	UINT32 count = 0;
 
-	// seek to the new location; note that most fseek implementations are limited to 32 bits
-	fseek((FILE *)file, offset, SEEK_SET);
+	// perform the write, which may go out in pieces
+	while (count < length)
+	{
+		ssize_t result = pwrite(file->fd, (const UINT8 *)buffer + count, length - count, offset + count);
+		if (result == -1 && errno == EINTR)
+			continue;
+		if (result == -1)
+			return errno_to_file_error(errno);
+		count += result;
+	}
 
-	// perform the write
-	count = fwrite(buffer, 1, length, (FILE *)file);
 	if (actual != NULL)
 		*actual = count;
+	return FILERR_NONE;
+}
+
+file_error osd_map(osd_file *file, const void **base)
+{
+	struct stat st;
+	void *map;
+
+	// only files opened read-only can be mapped
+	if (file->openflags & OPEN_FLAG_WRITE)
+		return FILERR_INVALID_ACCESS;
 
+	// reuse an existing mapping
+	if (file->map == NULL)
+	{
+		// mmap can't do empty files
+		if (fstat(file->fd, &st) != 0)
+			return errno_to_file_error(errno);
+		if (st.st_size == 0 || (UINT64)st.st_size != (size_t)st.st_size)
+			return FILERR_FAILURE;
+
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+		if (map == MAP_FAILED)
+			return errno_to_file_error(errno);
+		file->map = map;
+		file->maplength = st.st_size;
+	}
+
+	*base = file->map;
 	return FILERR_NONE;
 }
 
@@ -90,6 +240,19 @@ file_error osd_rmfile(const char *filename)
     return FILERR_NONE;
 }
 
+file_error osd_stat(const char *filename, UINT64 *filesize, UINT64 *modified)
+{
+	struct stat st;
+
+	if (stat(filename, &st) != 0)
+		return (errno == ENOENT) ? FILERR_NOT_FOUND : FILERR_FAILURE;
+
+	// fold in the nanoseconds so rewrites within the same second are noticed
+	*filesize = st.st_size;
+	*modified = (UINT64)st.st_mtime * 1000000000 + st.st_mtim.tv_nsec;
+	return FILERR_NONE;
+}
+
 int osd_uchar_from_osdchar(UINT32 /* unicode_char */ *uchar, const char *osdchar, size_t count)
 {
 	// we assume a standard 1:1 mapping of characters to the first 256 unicode characters
@@ -161,9 +324,19 @@ void osd_sleep(osd_ticks_t duration)
 
 osd_lock *osd_lock_alloc(void)
 {
-	// the minimal implementation does not support threading
-	// just return a dummy value here
-	return (osd_lock *)1;
+	pthread_mutexattr_t attr;
+	pthread_mutex_t *mutex;
+
+	// the work queues run real threads, so locks must be real too;
+	// osd_locks are recursive
+	mutex = malloc(sizeof(*mutex));
+	if (mutex == NULL)
+		return NULL;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return (osd_lock *)mutex;
 }
 
 
@@ -173,8 +346,7 @@ osd_lock *osd_lock_alloc(void)
 
 void osd_lock_acquire(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// the acquire always "succeeds"
+	pthread_mutex_lock((pthread_mutex_t *)lock);
 }
 
 
@@ -184,9 +356,7 @@ void osd_lock_acquire(osd_lock *lock)
 
 int osd_lock_try(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// the acquire always "succeeds"
-	return TRUE;
+	return (pthread_mutex_trylock((pthread_mutex_t *)lock) == 0);
 }
 
 
@@ -196,8 +366,7 @@ int osd_lock_try(osd_lock *lock)
 
 void osd_lock_release(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// do nothing here
+	pthread_mutex_unlock((pthread_mutex_t *)lock);
 }
 
 
@@ -207,98 +376,8 @@ void osd_lock_release(osd_lock *lock)
 
 void osd_lock_free(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// do nothing here
-}
-
-
-//============================================================
-//  TYPE DEFINITIONS
-//============================================================
-
-struct _osd_work_item
-{
-	void *result;
-};
-
-
-
-//============================================================
-//  osd_work_queue_alloc
-//============================================================
-
-osd_work_queue *osd_work_queue_alloc(int flags)
-{
-	// this minimal implementation doesn't need to keep any state
-	// so we just return a non-NULL pointer
-	return (osd_work_queue *)1;
-}
-
-
-//============================================================
-//  osd_work_queue_items
-//============================================================
-
-int osd_work_queue_items(osd_work_queue *queue)
-{
-	// we never have pending items
-	return 0;
-}
-
-osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_callback callback, INT32 numitems, void *parambase, INT32 paramstep, UINT32 flags)
-{
-    return NULL;
-}
-
-//============================================================
-//  osd_work_queue_wait
-//============================================================
-
-int osd_work_queue_wait(osd_work_queue *queue, osd_ticks_t timeout)
-{
-	// never anything to wait for, so do nothing
-	return TRUE;
-}
-
-
-//============================================================
-//  osd_work_queue_free
-//============================================================
-
-void osd_work_queue_free(osd_work_queue *queue)
-{
-	// never allocated anything, so nothing to do
-}
-
-
-//============================================================
-//  osd_work_item_wait
-//============================================================
-
-int osd_work_item_wait(osd_work_item *item, osd_ticks_t timeout)
-{
-	// never anything to wait for, so do nothing
-	return TRUE;
-}
-
-
-//============================================================
-//  osd_work_item_result
-//============================================================
-
-void *osd_work_item_result(osd_work_item *item)
-{
-	return item->result;
-}
-
-
-//============================================================
-//  osd_work_item_release
-//============================================================
-
-void osd_work_item_release(osd_work_item *item)
-{
-	free(item);
+	pthread_mutex_destroy((pthread_mutex_t *)lock);
+	free(lock);
 }
 
 
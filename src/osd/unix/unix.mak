@@ -60,7 +60,8 @@ OSDCOREOBJS = \
 #-------------------------------------------------
 
 OSDOBJS = \
-	$(UNIXOBJ)/osd_stub.o
+	$(UNIXOBJ)/osd_stub.o \
+	$(UNIXOBJ)/unixwork.o
 
 #-------------------------------------------------
 # rules for building the libaries
@@ -0,0 +1,454 @@
+//============================================================
+//
+//  unixwork.c - Unix OSD core work item functions
+//
+//  Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+//  Visit http://mamedev.org for licensing and usage restrictions.
+//
+//============================================================
+
+// standard headers
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+// MAME headers
+#include "osdcore.h"
+
+
+
+//============================================================
+//  TYPE DEFINITIONS
+//============================================================
+
+typedef struct _work_thread_info work_thread_info;
+struct _work_thread_info
+{
+	osd_work_queue *	queue;			// pointer back to the queue
+	pthread_t			handle;			// handle to the thread
+	int					started;		// did the thread start?
+};
+
+
+struct _osd_work_queue
+{
+	pthread_mutex_t		lock;			// lock for protecting the queue
+	pthread_cond_t		wakecond;		// signalled when work is added or we are exiting
+	pthread_cond_t		donecond;		// signalled whenever an item completes
+	osd_work_item *		list;			// list of items in the queue
+	osd_work_item **	tailptr;		// pointer to the tail pointer of work items in the queue
+	osd_work_item *		free;			// free list of work items
+	INT32				items;			// items queued or running
+	UINT8				exiting;		// should the threads exit on their next opportunity?
+	UINT32				threads;		// number of threads in this queue
+	UINT32				flags;			// creation flags
+	work_thread_info *	thread;			// array of thread information
+};
+
+
+struct _osd_work_item
+{
+	osd_work_item *		next;			// pointer to next item
+	osd_work_queue *	queue;			// pointer back to the owning queue
+	osd_work_callback 	callback;		// callback function
+	void *				param;			// callback parameter
+	void *				result;			// callback result
+	UINT32				flags;			// creation flags
+	INT32				done;			// is the item done?
+};
+
+
+
+//============================================================
+//  FUNCTION PROTOTYPES
+//============================================================
+
+static int effective_num_processors(void);
+static void *worker_thread_entry(void *param);
+static void worker_thread_process(osd_work_queue *queue, work_thread_info *thread);
+
+
+
+//============================================================
+//  INLINE FUNCTIONS
+//============================================================
+
+INLINE void ticks_to_deadline(struct timespec *deadline, osd_ticks_t timeout)
+{
+	osd_ticks_t persecond = osd_ticks_per_second();
+	double seconds = (double)timeout / (double)persecond;
+	INT64 nsec;
+
+	clock_gettime(CLOCK_REALTIME, deadline);
+	nsec = (INT64)deadline->tv_nsec + (INT64)((seconds - (INT64)seconds) * 1e9);
+	deadline->tv_sec += (time_t)seconds + (time_t)(nsec / 1000000000);
+	deadline->tv_nsec = nsec % 1000000000;
+}
+
+
+
+//============================================================
+//  osd_work_queue_alloc
+//============================================================
+
+osd_work_queue *osd_work_queue_alloc(int flags)
+{
+	int numprocs = effective_num_processors();
+	osd_work_queue *queue;
+	int threadnum;
+
+	// allocate a new queue
+	queue = malloc(sizeof(*queue));
+	if (queue == NULL)
+		return NULL;
+	memset(queue, 0, sizeof(*queue));
+
+	// initialize basic queue members
+	queue->tailptr = &queue->list;
+	queue->flags = flags;
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->wakecond, NULL);
+	pthread_cond_init(&queue->donecond, NULL);
+
+	// determine how many threads to create...
+	// on a single-CPU system, create 1 thread for I/O queues, and 0 threads for everything else
+	if (numprocs == 1)
+		queue->threads = (flags & WORK_QUEUE_FLAG_IO) ? 1 : 0;
+
+	// on an n-CPU system, create (n-1) threads for multi queues, and 1 thread for everything else
+	else
+		queue->threads = (flags & WORK_QUEUE_FLAG_MULTI) ? (numprocs - 1) : 1;
+
+	// clamp to the maximum, leaving a thread ID for the calling thread
+	queue->threads = MIN(queue->threads, WORK_MAX_THREADS - 1);
+
+	// allocate memory for thread array (+1 to count the calling thread)
+	queue->thread = malloc((queue->threads + 1) * sizeof(queue->thread[0]));
+	if (queue->thread == NULL)
+		goto error;
+	memset(queue->thread, 0, (queue->threads + 1) * sizeof(queue->thread[0]));
+
+	// iterate over threads
+	for (threadnum = 0; threadnum < queue->threads; threadnum++)
+	{
+		work_thread_info *thread = &queue->thread[threadnum];
+
+		// set a pointer back to the queue and create the thread
+		thread->queue = queue;
+		if (pthread_create(&thread->handle, NULL, worker_thread_entry, thread) != 0)
+			goto error;
+		thread->started = TRUE;
+	}
+	return queue;
+
+error:
+	osd_work_queue_free(queue);
+	return NULL;
+}
+
+
+//============================================================
+//  osd_work_queue_items
+//============================================================
+
+int osd_work_queue_items(osd_work_queue *queue)
+{
+	int items;
+
+	// return the number of items currently in the queue
+	pthread_mutex_lock(&queue->lock);
+	items = queue->items;
+	pthread_mutex_unlock(&queue->lock);
+	return items;
+}
+
+
+//============================================================
+//  osd_work_queue_wait
+//============================================================
+
+int osd_work_queue_wait(osd_work_queue *queue, osd_ticks_t timeout)
+{
+	struct timespec deadline;
+	int result;
+
+	// if no threads, no waiting
+	if (queue->threads == 0)
+		return TRUE;
+
+	// if this is a multi queue, help out rather than doing nothing
+	if (queue->flags & WORK_QUEUE_FLAG_MULTI)
+		worker_thread_process(queue, &queue->thread[queue->threads]);
+
+	// block until the last item completes or we time out
+	ticks_to_deadline(&deadline, timeout);
+	pthread_mutex_lock(&queue->lock);
+	while (queue->items != 0)
+		if (pthread_cond_timedwait(&queue->donecond, &queue->lock, &deadline) == ETIMEDOUT)
+			break;
+	result = (queue->items == 0);
+	pthread_mutex_unlock(&queue->lock);
+
+	// return TRUE if we actually hit 0
+	return result;
+}
+
+
+//============================================================
+//  osd_work_queue_free
+//============================================================
+
+void osd_work_queue_free(osd_work_queue *queue)
+{
+	// if we have threads, clean them up
+	if (queue->thread != NULL)
+	{
+		int threadnum;
+
+		// signal all the threads to exit
+		pthread_mutex_lock(&queue->lock);
+		queue->exiting = TRUE;
+		pthread_cond_broadcast(&queue->wakecond);
+		pthread_mutex_unlock(&queue->lock);
+
+		// wait for all the threads to go away
+		for (threadnum = 0; threadnum < queue->threads; threadnum++)
+			if (queue->thread[threadnum].started)
+				pthread_join(queue->thread[threadnum].handle, NULL);
+
+		// free the list
+		free(queue->thread);
+	}
+
+	// free all items in the free list
+	while (queue->free != NULL)
+	{
+		osd_work_item *item = queue->free;
+		queue->free = item->next;
+		free(item);
+	}
+
+	// free all items in the active list
+	while (queue->list != NULL)
+	{
+		osd_work_item *item = queue->list;
+		queue->list = item->next;
+		free(item);
+	}
+
+	// free the synchronization objects and the queue itself
+	pthread_cond_destroy(&queue->donecond);
+	pthread_cond_destroy(&queue->wakecond);
+	pthread_mutex_destroy(&queue->lock);
+	free(queue);
+}
+
+
+//============================================================
+//  osd_work_item_queue_multiple
+//============================================================
+
+osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_callback callback, INT32 numitems, void *parambase, INT32 paramstep, UINT32 flags)
+{
+	osd_work_item *itemlist = NULL, *lastitem = NULL;
+	osd_work_item **item_tailptr = &itemlist;
+	int itemnum;
+
+	// loop over items, building up a local list of work
+	pthread_mutex_lock(&queue->lock);
+	for (itemnum = 0; itemnum < numitems; itemnum++)
+	{
+		osd_work_item *item;
+
+		// first allocate a new work item; try the free list first
+		item = queue->free;
+		if (item != NULL)
+			queue->free = item->next;
+
+		// if nothing, allocate something new
+		else
+		{
+			item = malloc(sizeof(*item));
+			if (item == NULL)
+				break;
+			item->queue = queue;
+		}
+
+		// fill in the basics
+		item->next = NULL;
+		item->callback = callback;
+		item->param = parambase;
+		item->result = NULL;
+		item->flags = flags;
+		item->done = FALSE;
+
+		// advance to the next
+		*item_tailptr = item;
+		item_tailptr = &item->next;
+		lastitem = item;
+		parambase = (UINT8 *)parambase + paramstep;
+	}
+
+	// enqueue the whole thing and wake the workers
+	if (itemlist != NULL)
+	{
+		*queue->tailptr = itemlist;
+		queue->tailptr = item_tailptr;
+		queue->items += itemnum;
+		pthread_cond_broadcast(&queue->wakecond);
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	// if no threads, run the queue now on this thread
+	if (queue->threads == 0)
+		worker_thread_process(queue, &queue->thread[0]);
+
+	// only return the item if it won't get released automatically
+	return (flags & WORK_ITEM_FLAG_AUTO_RELEASE) ? NULL : lastitem;
+}
+
+
+//============================================================
+//  osd_work_item_wait
+//============================================================
+
+int osd_work_item_wait(osd_work_item *item, osd_ticks_t timeout)
+{
+	osd_work_queue *queue = item->queue;
+	struct timespec deadline;
+	int result;
+
+	// block until the item is done or we time out
+	ticks_to_deadline(&deadline, timeout);
+	pthread_mutex_lock(&queue->lock);
+	while (!item->done)
+		if (pthread_cond_timedwait(&queue->donecond, &queue->lock, &deadline) == ETIMEDOUT)
+			break;
+	result = item->done;
+	pthread_mutex_unlock(&queue->lock);
+	return result;
+}
+
+
+//============================================================
+//  osd_work_item_result
+//============================================================
+
+void *osd_work_item_result(osd_work_item *item)
+{
+	return item->result;
+}
+
+
+//============================================================
+//  osd_work_item_release
+//============================================================
+
+void osd_work_item_release(osd_work_item *item)
+{
+	osd_work_queue *queue = item->queue;
+
+	// make sure we're done first
+	osd_work_item_wait(item, 100 * osd_ticks_per_second());
+
+	// add us to the free list on our queue
+	pthread_mutex_lock(&queue->lock);
+	item->next = queue->free;
+	queue->free = item;
+	pthread_mutex_unlock(&queue->lock);
+}
+
+
+//============================================================
+//  effective_num_processors
+//============================================================
+
+static int effective_num_processors(void)
+{
+	char *procsoverride;
+	int numprocs = 0;
+
+	// if the OSDPROCESSORS environment variable is set, use that value if valid
+	procsoverride = getenv("OSDPROCESSORS");
+	if (procsoverride != NULL && sscanf(procsoverride, "%d", &numprocs) == 1 && numprocs > 0)
+		return numprocs;
+
+	// otherwise, fetch the info from the system
+	numprocs = sysconf(_SC_NPROCESSORS_ONLN);
+	if (numprocs < 1)
+		numprocs = 1;
+
+	// max out at 4 for now since scaling above that seems to do poorly
+	return MIN(numprocs, 4);
+}
+
+
+//============================================================
+//  worker_thread_entry
+//============================================================
+
+static void *worker_thread_entry(void *param)
+{
+	work_thread_info *thread = param;
+	osd_work_queue *queue = thread->queue;
+
+	// loop until we exit
+	for ( ;; )
+	{
+		int exiting;
+
+		// block waiting for work or exit
+		pthread_mutex_lock(&queue->lock);
+		while (!queue->exiting && queue->list == NULL)
+			pthread_cond_wait(&queue->wakecond, &queue->lock);
+		exiting = queue->exiting;
+		pthread_mutex_unlock(&queue->lock);
+		if (exiting)
+			break;
+
+		// process work items
+		worker_thread_process(queue, thread);
+	}
+	return NULL;
+}
+
+
+//============================================================
+//  worker_thread_process
+//============================================================
+
+static void worker_thread_process(osd_work_queue *queue, work_thread_info *thread)
+{
+	int threadid = thread - queue->thread;
+
+	// loop until everything is processed
+	pthread_mutex_lock(&queue->lock);
+	while (queue->list != NULL)
+	{
+		// pull the item from the queue
+		osd_work_item *item = queue->list;
+		queue->list = item->next;
+		if (queue->list == NULL)
+			queue->tailptr = &queue->list;
+
+		// call the callback and stash the result outside the lock
+		pthread_mutex_unlock(&queue->lock);
+		item->result = (*item->callback)(item->param, threadid);
+		pthread_mutex_lock(&queue->lock);
+
+		// mark it done; auto-release items go straight back to the free list
+		queue->items--;
+		item->done = TRUE;
+		if (item->flags & WORK_ITEM_FLAG_AUTO_RELEASE)
+		{
+			item->next = queue->free;
+			queue->free = item;
+		}
+		pthread_cond_broadcast(&queue->donecond);
+	}
+	pthread_mutex_unlock(&queue->lock);
+}
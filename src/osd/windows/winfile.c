@@ -28,6 +28,8 @@
 struct _osd_file
 {
 	HANDLE		handle;
+	HANDLE		mapping;
+	const void *view;
 	TCHAR 		filename[1];
 };
 
@@ -69,6 +71,8 @@ file_error osd_open(const char *path, UINT32 openflags, osd_file **file, UINT64
 		filerr = FILERR_OUT_OF_MEMORY;
 		goto error;
 	}
+	(*file)->mapping = NULL;
+	(*file)->view = NULL;
 
 	// convert the path into something Windows compatible
 	dst = (*file)->filename;
@@ -196,13 +200,44 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 l
 }
 
 
+//============================================================
+//  osd_map
+//============================================================
+
+file_error osd_map(osd_file *file, const void **base)
+{
+	// create a read-only view of the whole file the first time through
+	if (file->view == NULL)
+	{
+		file->mapping = CreateFileMapping(file->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (file->mapping == NULL)
+			return win_error_to_file_error(GetLastError());
+		file->view = MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+		if (file->view == NULL)
+		{
+			DWORD error = GetLastError();
+			CloseHandle(file->mapping);
+			file->mapping = NULL;
+			return win_error_to_file_error(error);
+		}
+	}
+
+	*base = file->view;
+	return FILERR_NONE;
+}
+
+
 //============================================================
 //  osd_close
 //============================================================
 
 file_error osd_close(osd_file *file)
 {
-	// close the file handle and free the file structure
+	// release any mapping, then close the file handle and free the file structure
+	if (file->view != NULL)
+		UnmapViewOfFile(file->view);
+	if (file->mapping != NULL)
+		CloseHandle(file->mapping);
 	CloseHandle(file->handle);
 	free(file);
 	return FILERR_NONE;
@@ -237,6 +272,39 @@ done:
 }
 
 
+//============================================================
+//  osd_stat
+//============================================================
+
+file_error osd_stat(const char *filename, UINT64 *filesize, UINT64 *modified)
+{
+	file_error filerr = FILERR_NONE;
+	WIN32_FILE_ATTRIBUTE_DATA attr;
+
+	TCHAR *tempstr = tstring_from_utf8(filename);
+	if (!tempstr)
+	{
+		filerr = FILERR_OUT_OF_MEMORY;
+		goto done;
+	}
+
+	if (!GetFileAttributesEx(tempstr, GetFileExInfoStandard, &attr))
+	{
+		filerr = win_error_to_file_error(GetLastError());
+		goto done;
+	}
+
+	// the last write time is already a 64-bit count of 100ns units
+	*filesize = ((UINT64)attr.nFileSizeHigh << 32) | attr.nFileSizeLow;
+	*modified = ((UINT64)attr.ftLastWriteTime.dwHighDateTime << 32) | attr.ftLastWriteTime.dwLowDateTime;
+
+done:
+	if (tempstr)
+		free(tempstr);
+	return filerr;
+}
+
+
 //============================================================
 //  osd_get_physical_drive_geometry
 //============================================================
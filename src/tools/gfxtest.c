@@ -0,0 +1,373 @@
+/***************************************************************************
+
+    gfxtest.c
+
+    Pixel-exact test for the drawgfx span kernels. Draws random elements
+    through drawgfx, pdrawgfx, mdrawgfx and the three drawgfxzoom
+    variants, once with the span kernels turned off and once with them
+    on, and checks that the destination and priority bitmaps come out
+    identical. Every transparency mode, both flips, clipping, 4bpp and
+    8bpp elements and 8, 16 and 32bpp destinations are covered. With the
+    kernels off, drawgfx.c runs the same scalar loops it ran before the
+    kernels were added.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "driver.h"
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define DEST_WIDTH			200
+#define DEST_HEIGHT			120
+
+#define MAX_ELEMENT_WIDTH	64
+#define MAX_ELEMENT_HEIGHT	40
+#define ELEMENTS			4
+
+#define TABLE_SIZE			65536
+
+#define KIND_DRAWGFX		0
+#define KIND_PDRAWGFX		1
+#define KIND_MDRAWGFX		2
+#define KIND_DRAWGFXZOOM	3
+#define KIND_PDRAWGFXZOOM	4
+#define KIND_MDRAWGFXZOOM	5
+#define KINDS				6
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+extern int drawgfx_use_spans;
+
+running_machine *Machine;
+mame_bitmap *priority_bitmap;
+
+static running_machine machine;
+static machine_config config;
+
+static pen_t remapped[TABLE_SIZE];
+static pen_t shadow[TABLE_SIZE];
+static UINT16 colortable[TABLE_SIZE];
+
+static UINT8 gfxdata[ELEMENTS * (MAX_ELEMENT_WIDTH + 2) * MAX_ELEMENT_HEIGHT];
+static UINT32 pen_usage[ELEMENTS];
+
+static const char *const kind_name[KINDS] =
+{
+	"drawgfx", "pdrawgfx", "mdrawgfx", "drawgfxzoom", "pdrawgfxzoom", "mdrawgfxzoom"
+};
+
+
+
+/***************************************************************************
+    STUBS FOR THE EMULATOR CORE
+***************************************************************************/
+
+void CLIB_DECL fatalerror(const char *text, ...)
+{
+	va_list arg;
+
+	va_start(arg, text);
+	vfprintf(stderr, text, arg);
+	va_end(arg);
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+void CLIB_DECL popmessage(const char *text, ...)
+{
+}
+
+void *malloc_or_die_file_line(size_t size, const char *file, int line)
+{
+	void *result = malloc(size);
+	if (result == NULL)
+	{
+		fprintf(stderr, "Out of memory allocating %d bytes (%s:%d)\n", (int)size, file, line);
+		exit(1);
+	}
+	return result;
+}
+
+
+
+/***************************************************************************
+    RANDOM INPUTS
+***************************************************************************/
+
+/*-------------------------------------------------
+    test_rand - simple LCG so runs repeat
+-------------------------------------------------*/
+
+static UINT32 test_rand(void)
+{
+	static UINT32 seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) & 0xffffff;
+}
+
+
+/*-------------------------------------------------
+    fill_random - fill a bitmap with random data
+-------------------------------------------------*/
+
+static void fill_random(mame_bitmap *bitmap)
+{
+	UINT8 *base = bitmap->base;
+	int bytes = bitmap->rowpixels * bitmap->height * (bitmap->bpp / 8);
+	int i;
+
+	for (i = 0; i < bytes; i++)
+		base[i] = test_rand();
+}
+
+
+/*-------------------------------------------------
+    make_element - build a random element set;
+    most pixels are often one pen so that rows
+    mix fully transparent and opaque spans
+-------------------------------------------------*/
+
+static void make_element(gfx_element *gfx, int transpen)
+{
+	static const int widths[] = { 8, 15, 16, 17, 24, 31, 32, 33, 48, 64 };
+	int density = (test_rand() & 1) ? ((test_rand() & 1) ? 0 : 100) : test_rand() % 101;
+	int code, x, y;
+
+	memset(gfx, 0, sizeof(*gfx));
+	gfx->width = widths[test_rand() % ARRAY_LENGTH(widths)];
+	gfx->height = 1 + test_rand() % MAX_ELEMENT_HEIGHT;
+	gfx->flags = (test_rand() % 4 == 0) ? GFX_ELEMENT_PACKED : 0;
+	gfx->total_elements = ELEMENTS;
+	gfx->color_base = test_rand() % 256;
+	gfx->color_depth = gfx->color_granularity = (gfx->flags & GFX_ELEMENT_PACKED) ? 16 : ((test_rand() & 1) ? 16 : 32);
+	gfx->total_colors = 64;
+	gfx->line_modulo = gfx->width + test_rand() % 3;
+	gfx->char_modulo = gfx->line_modulo * gfx->height;
+	gfx->gfxdata = gfxdata;
+	gfx->pen_usage = (test_rand() % 4 != 0) ? pen_usage : NULL;
+
+	for (code = 0; code < ELEMENTS; code++)
+	{
+		UINT8 *src = &gfxdata[code * gfx->char_modulo];
+
+		pen_usage[code] = 0;
+		for (y = 0; y < gfx->height; y++)
+			for (x = 0; x < gfx->line_modulo; x++)
+			{
+				int lo = ((int)(test_rand() % 100) < density) ? transpen % gfx->color_depth : test_rand() % gfx->color_depth;
+				int hi = ((int)(test_rand() % 100) < density) ? transpen % gfx->color_depth : test_rand() % gfx->color_depth;
+
+				/* packed elements hold two pixels per byte, low nibble first */
+				if (gfx->flags & GFX_ELEMENT_PACKED)
+				{
+					src[y * gfx->line_modulo + x] = lo | (hi << 4);
+					if (2 * x < gfx->width)
+						pen_usage[code] |= 1 << lo;
+					if (2 * x + 1 < gfx->width)
+						pen_usage[code] |= 1 << hi;
+				}
+				else
+				{
+					src[y * gfx->line_modulo + x] = lo;
+					if (x < gfx->width)
+						pen_usage[code] |= 1 << lo;
+				}
+			}
+	}
+}
+
+
+/*-------------------------------------------------
+    setup_tables - randomize the global tables
+    that the drawing modes consult
+-------------------------------------------------*/
+
+static void setup_tables(void)
+{
+	int i;
+
+	for (i = 0; i < 256; i++)
+	{
+		gfx_drawmode_table[i] = test_rand() % 3;
+		gfx_alpharange_table[i] = (test_rand() & 1) ? 0xff : test_rand() & 0xff;
+	}
+	alpha_set_level(test_rand() % 257);
+	pdrawgfx_shadow_lowpri = test_rand() & 1;
+	config.color_table_len = test_rand() & 1;
+}
+
+
+
+/***************************************************************************
+    DRAWING
+***************************************************************************/
+
+/*-------------------------------------------------
+    draw - issue one call through the requested
+    entry point
+-------------------------------------------------*/
+
+static void draw(int kind, mame_bitmap *dest, const gfx_element *gfx, UINT32 code, UINT32 color, int flipx, int flipy,
+	int sx, int sy, const rectangle *clip, int transparency, int transparent_color, int scale, UINT32 pmask)
+{
+	switch (kind)
+	{
+		case KIND_DRAWGFX:
+			drawgfx(dest, gfx, code, color, flipx, flipy, sx, sy, clip, transparency, transparent_color);
+			break;
+
+		case KIND_PDRAWGFX:
+			pdrawgfx(dest, gfx, code, color, flipx, flipy, sx, sy, clip, transparency, transparent_color, pmask);
+			break;
+
+		case KIND_MDRAWGFX:
+			mdrawgfx(dest, gfx, code, color, flipx, flipy, sx, sy, clip, transparency, transparent_color, pmask);
+			break;
+
+		case KIND_DRAWGFXZOOM:
+			drawgfxzoom(dest, gfx, code, color, flipx, flipy, sx, sy, clip, transparency, transparent_color, scale, scale);
+			break;
+
+		case KIND_PDRAWGFXZOOM:
+			pdrawgfxzoom(dest, gfx, code, color, flipx, flipy, sx, sy, clip, transparency, transparent_color, scale, scale, pmask);
+			break;
+
+		case KIND_MDRAWGFXZOOM:
+			mdrawgfxzoom(dest, gfx, code, color, flipx, flipy, sx, sy, clip, transparency, transparent_color, scale, scale, pmask);
+			break;
+	}
+}
+
+
+
+/***************************************************************************
+    MAIN
+***************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	static const bitmap_format formats[] = { BITMAP_FORMAT_INDEXED8, BITMAP_FORMAT_INDEXED16, BITMAP_FORMAT_RGB15, BITMAP_FORMAT_RGB32 };
+	int iterations = (argc > 1) ? atoi(argv[1]) : 200000;
+	mame_bitmap *dest[2][ARRAY_LENGTH(formats)], *pri[2];
+	int iteration, failures = 0, i;
+
+	if (iterations <= 0)
+	{
+		fprintf(stderr, "Usage:\n  gfxtest [iterations] -- compare the drawgfx span kernels against the scalar loops\n");
+		return 1;
+	}
+
+	/* pens and their shadows stay below 64k, since 16bpp shadows are looked up by pen */
+	for (i = 0; i < TABLE_SIZE; i++)
+	{
+		remapped[i] = ((i * 2654435761U) ^ 0x12345) & 0xffff;
+		shadow[i] = ((i * 40503U) ^ 0xabcd) & 0xffff;
+		colortable[i] = test_rand() & 0xff;
+	}
+	config.total_colors = TABLE_SIZE;
+	machine.drv = &config;
+	machine.pens = remapped;
+	machine.remapped_colortable = remapped;
+	machine.game_colortable = colortable;
+	machine.shadow_table = shadow;
+	Machine = &machine;
+	drawgfx_init(Machine);
+
+	for (i = 0; i < 2; i++)
+	{
+		int format;
+
+		for (format = 0; format < ARRAY_LENGTH(formats); format++)
+			dest[i][format] = bitmap_alloc(DEST_WIDTH, DEST_HEIGHT, formats[format]);
+		pri[i] = bitmap_alloc(DEST_WIDTH, DEST_HEIGHT, BITMAP_FORMAT_INDEXED8);
+	}
+
+	printf("Comparing span kernels against scalar loops over %d draws...\n", iterations);
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		int format = test_rand() % ARRAY_LENGTH(formats);
+		int kind = test_rand() % KINDS;
+		int transparency = test_rand() % TRANSPARENCY_MODES;
+		int transpen = test_rand() % 36;
+		int transparent_color = transpen;
+		int flipx = test_rand() & 1, flipy = test_rand() & 1;
+		int sx = (int)(test_rand() % 260) - 40, sy = (int)(test_rand() % 160) - 30;
+		int scale = (test_rand() & 1) ? 0x10000 : 0x8000 + test_rand() % 0x20000;
+		UINT32 pmask = test_rand() | (test_rand() << 24);
+		UINT32 code = test_rand() % ELEMENTS, color = test_rand() % 64;
+		const rectangle *clipptr;
+		rectangle clip;
+		gfx_element gfx;
+		int bytes;
+
+		setup_tables();
+		make_element(&gfx, transpen);
+
+		/* multiple pen modes take a mask; raw modes take a base pen instead of a color code */
+		if (transparency == TRANSPARENCY_PENS || transparency == TRANSPARENCY_PENS_RAW)
+			transparent_color = (test_rand() & 1) ? (1 << transpen % 32) : test_rand() | (test_rand() << 24);
+		else if (transparency == TRANSPARENCY_BLEND || transparency == TRANSPARENCY_BLEND_RAW)
+			transparent_color = transpen % 8;
+		if (transparency == TRANSPARENCY_NONE_RAW || transparency == TRANSPARENCY_PEN_RAW || transparency == TRANSPARENCY_PENS_RAW ||
+				transparency == TRANSPARENCY_PEN_TABLE_RAW || transparency == TRANSPARENCY_BLEND_RAW)
+			color = test_rand() % (TABLE_SIZE - 256);
+
+		clip.min_x = test_rand() % 60;
+		clip.max_x = 100 + test_rand() % 120;
+		clip.min_y = test_rand() % 40;
+		clip.max_y = 60 + test_rand() % 70;
+		/* the scaled drawgfxzoom paths rely on a clip to stay inside the bitmap */
+		clipptr = (kind < KIND_DRAWGFXZOOM && test_rand() % 4 == 0) ? NULL : &clip;
+
+		/* identical starting contents for both passes */
+		bytes = dest[0][format]->rowpixels * dest[0][format]->height * (dest[0][format]->bpp / 8);
+		fill_random(dest[0][format]);
+		memcpy(dest[1][format]->base, dest[0][format]->base, bytes);
+		fill_random(pri[0]);
+		memcpy(pri[1]->base, pri[0]->base, pri[0]->rowpixels * pri[0]->height);
+
+		for (i = 0; i < 2; i++)
+		{
+			drawgfx_use_spans = i;
+			priority_bitmap = pri[i];
+			draw(kind, dest[i][format], &gfx, code, color, flipx, flipy, sx, sy, clipptr, transparency, transparent_color, scale, pmask);
+		}
+
+		if (memcmp(dest[0][format]->base, dest[1][format]->base, bytes) != 0 ||
+			memcmp(pri[0]->base, pri[1]->base, pri[0]->rowpixels * pri[0]->height) != 0)
+		{
+			if (failures++ < 10)
+				printf("draw %d: %s %dbpp %dx%d%s mode %d pen %d flip %d%d at %d,%d%s scale %05X differs\n",
+						iteration, kind_name[kind], dest[0][format]->bpp, gfx.width, gfx.height,
+						(gfx.flags & GFX_ELEMENT_PACKED) ? " packed" : "", transparency, transparent_color,
+						flipx, flipy, sx, sy, (clipptr == NULL) ? " unclipped" : "", scale);
+		}
+	}
+
+	for (i = 0; i < 2; i++)
+	{
+		int format;
+
+		for (format = 0; format < ARRAY_LENGTH(formats); format++)
+			bitmap_free(dest[i][format]);
+		bitmap_free(pri[i]);
+	}
+
+	printf("%d failures\n", failures);
+	return (failures != 0);
+}
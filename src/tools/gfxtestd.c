@@ -0,0 +1,14 @@
+/***************************************************************************
+
+    gfxtestd.c
+
+    drawgfx span kernel test: drawgfx.c built with a run-time switch
+    for the span kernels.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#define DRAWGFX_SPAN_SWITCH
+#include "drawgfx.c"
@@ -0,0 +1,445 @@
+/***************************************************************************
+
+    OKIM6295 phrase cache benchmark
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+    Plays the same OKI-heavy sound script through the OKIM6295 core with
+    the phrase cache disabled, enabled, and enabled with a budget small
+    enough to evict constantly. It reports the time taken by each, and
+    checks that all of them produce identical output. It also saves
+    the chip state halfway through and checks that loading it back,
+    with and without the cache still populated, replays the second half
+    exactly.
+
+***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "driver.h"
+#include "streams.h"
+#include "sound/okim6295.h"
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define CLOCK				1056000
+#define SAMPLE_RATE			(CLOCK / 132)
+#define FRAME_SAMPLES		(SAMPLE_RATE / 60)
+
+#define ROM_BANKS			2
+#define BANK_SIZE			0x40000
+#define PHRASES				127
+#define HOT_PHRASES			16
+
+#define MAX_ITEMS			64
+
+#define CACHE_KB			256
+#define SMALL_CACHE_KB		32
+
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+void okim6295_get_info(void *token, UINT32 state, sndinfo *info);
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/* a registered state save item */
+typedef struct _save_item save_item;
+struct _save_item
+{
+	void *			base;
+	UINT32			size;
+};
+
+
+/* state of the sound script */
+typedef struct _script_state script_state;
+struct _script_state
+{
+	UINT32			seed;
+	UINT32			frame;
+	int				bank;
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+static UINT8 rom[ROM_BANKS * BANK_SIZE];
+
+static void *chip;
+static stream_callback chip_update;
+static void *chip_param;
+static int cache_kb;
+
+static save_item items[MAX_ITEMS];
+static int item_count;
+static void (*presave)(void *);
+static void (*postload)(void *);
+static void *save_param;
+
+
+
+/***************************************************************************
+    STUBS FOR THE EMULATOR CORE
+***************************************************************************/
+
+void logerror(const char *text, ...)
+{
+}
+
+void *malloc_or_die_file_line(size_t size, const char *file, int line)
+{
+	void *result = malloc(size);
+	if (result == NULL)
+	{
+		fprintf(stderr, "Out of memory allocating %d bytes (%s:%d)\n", (int)size, file, line);
+		exit(1);
+	}
+	return result;
+}
+
+void *auto_malloc_file_line(size_t size, const char *file, int line)
+{
+	return malloc_or_die_file_line(size, file, line);
+}
+
+core_options *mame_options(void)
+{
+	return NULL;
+}
+
+int options_get_int(core_options *opts, const char *name)
+{
+	return cache_kb;
+}
+
+UINT8 *memory_region(int num)
+{
+	return rom;
+}
+
+UINT32 memory_region_length(int num)
+{
+	return sizeof(rom);
+}
+
+void *sndti_token(sound_type sndtype, int sndindex)
+{
+	return chip;
+}
+
+sound_stream *stream_create(int inputs, int outputs, int sample_rate, void *param, stream_callback callback)
+{
+	chip_update = callback;
+	chip_param = param;
+	return (sound_stream *)&chip_param;
+}
+
+void stream_update(sound_stream *stream)
+{
+}
+
+void stream_set_sample_rate(sound_stream *stream, int sample_rate)
+{
+}
+
+void state_save_register_memory(const char *module, UINT32 instance, const char *name, void *val, UINT32 valsize, UINT32 valcount)
+{
+	if (item_count < MAX_ITEMS)
+	{
+		items[item_count].base = val;
+		items[item_count].size = valsize * valcount;
+		item_count++;
+	}
+}
+
+void state_save_register_func_presave_ptr(void (*func)(void *), void *param)
+{
+	presave = func;
+	save_param = param;
+}
+
+void state_save_register_func_postload_ptr(void (*func)(void *), void *param)
+{
+	postload = func;
+	save_param = param;
+}
+
+
+
+/***************************************************************************
+    CHIP HELPERS
+***************************************************************************/
+
+/*-------------------------------------------------
+    chip_start - start a fresh chip with the
+    given cache size
+-------------------------------------------------*/
+
+static void chip_start(int kb)
+{
+	sndinfo info;
+	struct OKIM6295interface intf = { 0, 1 };
+
+	if (chip != NULL)
+	{
+		okim6295_get_info(chip, SNDINFO_PTR_STOP, &info);
+		(*info.stop)(chip);
+		free(chip);
+	}
+
+	cache_kb = kb;
+	item_count = 0;
+	okim6295_get_info(NULL, SNDINFO_PTR_START, &info);
+	chip = (*info.start)(0, CLOCK, &intf);
+}
+
+
+/*-------------------------------------------------
+    state_save/state_load - copy the registered
+    items out of and back into the chip
+-------------------------------------------------*/
+
+static UINT8 *state_save(void)
+{
+	UINT8 *buffer, *dest;
+	UINT32 total = 0;
+	int i;
+
+	(*presave)(save_param);
+	for (i = 0; i < item_count; i++)
+		total += items[i].size;
+	buffer = dest = malloc_or_die(total);
+	for (i = 0; i < item_count; i++)
+	{
+		memcpy(dest, items[i].base, items[i].size);
+		dest += items[i].size;
+	}
+	return buffer;
+}
+
+static void state_load(const UINT8 *buffer)
+{
+	int i;
+
+	for (i = 0; i < item_count; i++)
+	{
+		memcpy(items[i].base, buffer, items[i].size);
+		buffer += items[i].size;
+	}
+	(*postload)(save_param);
+}
+
+
+
+/***************************************************************************
+    SOUND SCRIPT
+***************************************************************************/
+
+/*-------------------------------------------------
+    script_rand - simple LCG so runs repeat
+-------------------------------------------------*/
+
+static UINT32 script_rand(script_state *state)
+{
+	state->seed = state->seed * 1103515245 + 12345;
+	return (state->seed >> 8) & 0xffffff;
+}
+
+
+/*-------------------------------------------------
+    build_rom - fill each bank with a phrase table
+    and random ADPCM data
+-------------------------------------------------*/
+
+static void build_rom(void)
+{
+	script_state state = { 1 };
+	int bank, phrase, i;
+
+	for (bank = 0; bank < ROM_BANKS; bank++)
+	{
+		UINT8 *base = &rom[bank * BANK_SIZE];
+
+		for (phrase = 1; phrase <= PHRASES; phrase++)
+		{
+			/* short effects first, longer speech and music phrases after */
+			UINT32 length = (phrase <= HOT_PHRASES) ? 0x200 + script_rand(&state) % 0xc00 : 0x400 + script_rand(&state) % 0x1800;
+			UINT32 start = 0x400 + script_rand(&state) % (BANK_SIZE - 0x400 - length);
+			UINT32 stop = start + length - 1;
+
+			base[phrase * 8 + 0] = start >> 16;
+			base[phrase * 8 + 1] = start >> 8;
+			base[phrase * 8 + 2] = start;
+			base[phrase * 8 + 3] = stop >> 16;
+			base[phrase * 8 + 4] = stop >> 8;
+			base[phrase * 8 + 5] = stop;
+		}
+		for (i = 0x400; i < BANK_SIZE; i++)
+			base[i] = script_rand(&state);
+	}
+}
+
+
+/*-------------------------------------------------
+    script_frame - issue one frame's worth of
+    commands and generate its samples
+-------------------------------------------------*/
+
+static void script_frame(script_state *state, stream_sample_t *output)
+{
+	int status = OKIM6295_status_0_r(0);
+	int voice;
+
+	/* games retrigger a handful of effects constantly and speech now and then */
+	for (voice = 0; voice < 4; voice++)
+		if (!(status & (1 << voice)) && script_rand(state) % 8 == 0)
+		{
+			int phrase = (script_rand(state) % 8 != 0) ? 1 + script_rand(state) % HOT_PHRASES : 1 + script_rand(state) % PHRASES;
+			OKIM6295_data_0_w(0, 0x80 | phrase);
+			OKIM6295_data_0_w(0, (0x10 << voice) | (script_rand(state) % 16));
+		}
+
+	/* occasionally cut a voice off */
+	if (script_rand(state) % 64 == 0)
+		OKIM6295_data_0_w(0, 0x08 << (script_rand(state) % 4));
+
+	/* and switch banks between stages */
+	if (script_rand(state) % 600 == 0)
+	{
+		state->bank = (state->bank + 1) % ROM_BANKS;
+		OKIM6295_set_bank_base(0, state->bank * BANK_SIZE);
+	}
+
+	(*chip_update)(chip_param, NULL, &output, FRAME_SAMPLES);
+	state->frame++;
+}
+
+
+/*-------------------------------------------------
+    run_script - play frames and return the time
+    taken in ticks
+-------------------------------------------------*/
+
+static osd_ticks_t run_script(script_state *state, int frames, stream_sample_t *output)
+{
+	osd_ticks_t start = osd_ticks();
+
+	while (frames--)
+	{
+		script_frame(state, output);
+		output += FRAME_SAMPLES;
+	}
+	return osd_ticks() - start;
+}
+
+
+
+/***************************************************************************
+    MAIN
+***************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	int seconds = (argc > 1) ? atoi(argv[1]) : 600;
+	int frames = seconds * 60;
+	int half = frames / 2;
+	size_t bytes = (size_t)frames * FRAME_SAMPLES * sizeof(stream_sample_t);
+	stream_sample_t *uncached, *cached, *small, *replay;
+	script_state state, saved;
+	osd_ticks_t ticks[3], tps = osd_ticks_per_second();
+	UINT8 *savebuf;
+	int errors = 0;
+
+	if (seconds <= 0)
+	{
+		fprintf(stderr, "Usage:\n  okibench [seconds] -- benchmark the OKIM6295 phrase cache\n");
+		return 1;
+	}
+
+	build_rom();
+	uncached = malloc_or_die(bytes);
+	cached = malloc_or_die(bytes);
+	small = malloc_or_die(bytes);
+	replay = malloc_or_die(bytes);
+
+	/* the same script with the cache off, on, and on but too small to hold the script */
+	chip_start(0);
+	memset(&state, 0, sizeof(state));
+	state.seed = 2;
+	ticks[0] = run_script(&state, frames, uncached);
+
+	chip_start(SMALL_CACHE_KB);
+	memset(&state, 0, sizeof(state));
+	state.seed = 2;
+	ticks[2] = run_script(&state, frames, small);
+
+	chip_start(CACHE_KB);
+	memset(&state, 0, sizeof(state));
+	state.seed = 2;
+	ticks[1] = run_script(&state, half, cached);
+	saved = state;
+	savebuf = state_save();
+	ticks[1] += run_script(&state, frames - half, cached + half * FRAME_SAMPLES);
+
+	printf("%d seconds of sound, %d voices\n", seconds, 4);
+	printf("cache off:  %8.3f s\n", (double)ticks[0] / (double)tps);
+	printf("cache %3dK: %8.3f s (%.2fx)\n", CACHE_KB, (double)ticks[1] / (double)tps, (double)ticks[0] / (double)ticks[1]);
+	printf("cache %3dK: %8.3f s (%.2fx)\n", SMALL_CACHE_KB, (double)ticks[2] / (double)tps, (double)ticks[0] / (double)ticks[2]);
+
+	if (memcmp(uncached, cached, bytes) != 0)
+	{
+		printf("FAILED: output with the cache differs\n");
+		errors++;
+	}
+	if (memcmp(uncached, small, bytes) != 0)
+	{
+		printf("FAILED: output with the small cache differs\n");
+		errors++;
+	}
+
+	/* load the halfway state while the cache is still populated */
+	state_load(savebuf);
+	state = saved;
+	run_script(&state, frames - half, replay + half * FRAME_SAMPLES);
+	if (memcmp(uncached + half * FRAME_SAMPLES, replay + half * FRAME_SAMPLES, bytes - half * FRAME_SAMPLES * sizeof(stream_sample_t)) != 0)
+	{
+		printf("FAILED: state load into a running chip differs\n");
+		errors++;
+	}
+
+	/* and into a fresh chip with nothing cached */
+	chip_start(CACHE_KB);
+	state_load(savebuf);
+	state = saved;
+	run_script(&state, frames - half, replay + half * FRAME_SAMPLES);
+	if (memcmp(uncached + half * FRAME_SAMPLES, replay + half * FRAME_SAMPLES, bytes - half * FRAME_SAMPLES * sizeof(stream_sample_t)) != 0)
+	{
+		printf("FAILED: state load into a fresh chip differs\n");
+		errors++;
+	}
+
+	if (errors == 0)
+		printf("output matches\n");
+	free(savebuf);
+	free(uncached);
+	free(cached);
+	free(small);
+	free(replay);
+	return (errors != 0);
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+
+    rgbtest.c
+
+    Sweep test for the NEON rgbutil backend. Feeds random inputs through
+    every rgbutil operation, once with rgbneon.h and once with the
+    portable rgbgen.h, and checks that the results are bit-for-bit
+    identical. The SSE2 and AltiVec backends saturate where rgbgen.h
+    wraps, so they are not expected to match and are not tested.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "osdcore.h"
+#include "rgbtest.h"
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+extern const char rgbtest_native_name[];
+
+void rgbtest_generic(const UINT32 *in, UINT32 *out);
+void rgbtest_native(const UINT32 *in, UINT32 *out);
+
+
+
+/***************************************************************************
+    RANDOM INPUTS
+***************************************************************************/
+
+/*-------------------------------------------------
+    sweep_rand - xorshift generator, so that runs
+    are repeatable
+-------------------------------------------------*/
+
+static UINT32 sweep_rand(void)
+{
+	static UINT32 state = 2463534242U;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+
+/*-------------------------------------------------
+    make_inputs - build one set of inputs; every
+    other set keeps the components near the byte
+    range, where clamping and blending matter most
+-------------------------------------------------*/
+
+static void make_inputs(UINT32 *in, UINT32 iteration)
+{
+	int i;
+
+	for (i = 0; i < RGBTEST_INPUTS; i++)
+	{
+		UINT32 value = sweep_rand();
+
+		if (i < 8 && (iteration & 1))
+			value = (value & 0x1ff) - 0x80;
+		in[i] = value;
+	}
+
+	/* scale factors are often in the usual 0-256 range */
+	if (iteration & 2)
+		in[9] &= 0x1ff;
+}
+
+
+
+/***************************************************************************
+    MAIN
+***************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	UINT32 iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000000;
+	UINT32 iteration;
+	int failures = 0;
+
+	if (iterations == 0)
+	{
+		fprintf(stderr, "Usage:\n  rgbtest [iterations] -- compare rgbneon.h against rgbgen.h\n");
+		return 1;
+	}
+
+	/* without NEON there is nothing to compare */
+	if (rgbtest_native_name[0] == 0)
+	{
+		printf("NEON is not available on this target\n");
+		return 0;
+	}
+
+	printf("Comparing %s against generic over %u inputs...\n", rgbtest_native_name, iterations);
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		UINT32 in[RGBTEST_INPUTS], expected[RGBTEST_OUTPUTS], actual[RGBTEST_OUTPUTS];
+		int i;
+
+		make_inputs(in, iteration);
+		memset(expected, 0, sizeof(expected));
+		memset(actual, 0, sizeof(actual));
+		rgbtest_generic(in, expected);
+		rgbtest_native(in, actual);
+
+		for (i = 0; i < RGBTEST_OUTPUTS; i++)
+			if (actual[i] != expected[i])
+			{
+				if (failures++ < 10)
+					printf("input %u result %d: %08X, expected %08X\n", iteration, i, actual[i], expected[i]);
+				break;
+			}
+	}
+
+	printf("%d failures\n", failures);
+	return (failures != 0);
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+
+    rgbtest.h
+
+    Operation sequence for the rgbutil sweep test. Each backend's file
+    includes this after its RGB header, with RGBTEST_FUNC set to the
+    name of the function to generate.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#ifndef __RGBTEST_H__
+#define __RGBTEST_H__
+
+/* number of inputs consumed and results produced per call */
+#define RGBTEST_INPUTS		16
+#define RGBTEST_OUTPUTS		50
+
+#endif /* __RGBTEST_H__ */
+
+
+#ifdef RGBTEST_FUNC
+
+/*-------------------------------------------------
+    rgbtest_observe - record everything the API
+    exposes about an rgbaint: the truncated and
+    clamped bytes, and the high byte of positive
+    values
+-------------------------------------------------*/
+
+#define RGBTEST_OBSERVE(_results, _color) \
+do { \
+	rgbaint _high = *(_color); \
+	*(_results)++ = rgbaint_to_rgba(_color); \
+	*(_results)++ = rgbaint_to_rgba_clamp(_color); \
+	rgbaint_scale_and_clamp(&_high, 1); \
+	*(_results)++ = rgbaint_to_rgba(&_high); \
+} while (0)
+
+#define RGBTEST_OBSERVE_RGB(_results, _color) \
+do { \
+	rgbint _high = *(_color); \
+	*(_results)++ = rgbint_to_rgb(_color); \
+	*(_results)++ = rgbint_to_rgb_clamp(_color); \
+	rgbint_scale_and_clamp(&_high, 1); \
+	*(_results)++ = rgbint_to_rgb(&_high); \
+} while (0)
+
+
+/*-------------------------------------------------
+    RGBTEST_FUNC - run every rgbutil operation
+    on one set of inputs
+-------------------------------------------------*/
+
+void RGBTEST_FUNC(const UINT32 *in, UINT32 *out)
+{
+	UINT8 scale = in[8], u = in[8] >> 8, v = in[14];
+	rgbaint a, b, t;
+	rgbint c, d, e;
+
+	/* the component constructors take any 16-bit value */
+	rgba_comp_to_rgbaint(&a, in[0], in[1], in[2], in[3]);
+	rgba_comp_to_rgbaint(&b, in[4], in[5], in[6], in[7]);
+	rgb_comp_to_rgbint(&c, in[1], in[2], in[3]);
+	rgb_comp_to_rgbint(&d, in[5], in[6], in[7]);
+	RGBTEST_OBSERVE(out, &a);
+	RGBTEST_OBSERVE_RGB(out, &c);
+
+	/* arithmetic wraps at 16 bits */
+	rgbaint_add(&a, &b);
+	rgbint_add(&c, &d);
+	RGBTEST_OBSERVE(out, &a);
+	RGBTEST_OBSERVE_RGB(out, &c);
+	rgbaint_sub(&a, &b);
+	rgbaint_sub(&a, &b);
+	rgbint_sub(&c, &d);
+	RGBTEST_OBSERVE(out, &a);
+	RGBTEST_OBSERVE_RGB(out, &c);
+	rgbaint_subr(&a, &b);
+	rgbint_subr(&c, &d);
+	RGBTEST_OBSERVE(out, &a);
+	RGBTEST_OBSERVE_RGB(out, &c);
+
+	/* blending and scaling of out-of-range values */
+	t = a;
+	e = c;
+	rgbaint_blend(&a, &b, scale);
+	rgbint_blend(&c, &d, scale);
+	RGBTEST_OBSERVE(out, &a);
+	RGBTEST_OBSERVE_RGB(out, &c);
+	rgbaint_scale_and_clamp(&t, in[9]);
+	rgbint_scale_and_clamp(&e, in[9]);
+	RGBTEST_OBSERVE(out, &t);
+	RGBTEST_OBSERVE_RGB(out, &e);
+
+	/* packed conversions */
+	rgba_to_rgbaint(&a, in[10]);
+	rgb_to_rgbint(&c, in[10]);
+	RGBTEST_OBSERVE(out, &a);
+	RGBTEST_OBSERVE_RGB(out, &c);
+
+	/* bilinear filters */
+	*out++ = rgb_bilinear_filter(in[10], in[11], in[12], in[13], u, v);
+	*out++ = rgba_bilinear_filter(in[10], in[11], in[12], in[13], u, v);
+	rgbaint_bilinear_filter(&a, in[10], in[11], in[12], in[13], u, v);
+	rgbint_bilinear_filter(&c, in[10], in[11], in[12], in[13], u, v);
+	RGBTEST_OBSERVE(out, &a);
+	RGBTEST_OBSERVE_RGB(out, &c);
+}
+
+#endif /* RGBTEST_FUNC */
@@ -0,0 +1,17 @@
+/***************************************************************************
+
+    rgbtestg.c
+
+    rgbutil sweep test: the portable C backend.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#include "osdcore.h"
+#include "palette.h"
+#include "video/rgbgen.h"
+
+#define RGBTEST_FUNC rgbtest_generic
+#include "rgbtest.h"
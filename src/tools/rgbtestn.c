@@ -0,0 +1,24 @@
+/***************************************************************************
+
+    rgbtestn.c
+
+    rgbutil sweep test: the NEON backend, when the target has NEON.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#include "osdcore.h"
+#include "palette.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include "video/rgbneon.h"
+const char rgbtest_native_name[] = "NEON";
+#else
+#include "video/rgbgen.h"
+const char rgbtest_native_name[] = "";
+#endif
+
+#define RGBTEST_FUNC rgbtest_native
+#include "rgbtest.h"
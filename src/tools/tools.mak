@@ -30,6 +30,10 @@ TOOLS += \
 	regrep$(EXE) \
 	srcclean$(EXE) \
 	src2html$(EXE) \
+	okibench$(EXE) \
+	ymreplay$(EXE) \
+	rgbtest$(EXE) \
+	gfxtest$(EXE) \
 
 
 
@@ -122,3 +126,61 @@ SRC2HTMLOBJS = \
 src2html$(EXE): $(SRC2HTMLOBJS) $(LIBUTIL) $(LIBOCORE) $(ZLIB) $(EXPAT)
 	@echo Linking $@...
 	$(LD) $(LDFLAGS) $^ $(LIBS) -o $@
+
+
+
+#-------------------------------------------------
+# okibench
+#-------------------------------------------------
+
+OKIBENCHOBJS = \
+	$(TOOLSOBJ)/okibench.o \
+	$(EMUOBJ)/sound/okim6295.o \
+
+okibench$(EXE): $(OKIBENCHOBJS) $(LIBOCORE)
+	@echo Linking $@...
+	$(LD) $(LDFLAGS) $^ $(LIBS) -o $@
+
+
+
+#-------------------------------------------------
+# ymreplay
+#-------------------------------------------------
+
+YMREPLAYOBJS = \
+	$(TOOLSOBJ)/ymreplay.o \
+	$(EMUOBJ)/sound/ym2151.o \
+	$(EMUOBJ)/attotime.o \
+
+ymreplay$(EXE): $(YMREPLAYOBJS) $(ZLIB) $(LIBOCORE)
+	@echo Linking $@...
+	$(LD) $(LDFLAGS) $^ $(LIBS) -o $@
+
+
+
+#-------------------------------------------------
+# rgbtest
+#-------------------------------------------------
+
+RGBTESTOBJS = \
+	$(TOOLSOBJ)/rgbtest.o \
+	$(TOOLSOBJ)/rgbtestg.o \
+	$(TOOLSOBJ)/rgbtestn.o \
+
+rgbtest$(EXE): $(RGBTESTOBJS) $(LIBOCORE)
+	@echo Linking $@...
+	$(LD) $(LDFLAGS) $^ $(LIBS) -o $@
+
+
+
+#-------------------------------------------------
+# gfxtest
+#-------------------------------------------------
+
+GFXTESTOBJS = \
+	$(TOOLSOBJ)/gfxtest.o \
+	$(TOOLSOBJ)/gfxtestd.o \
+
+gfxtest$(EXE): $(GFXTESTOBJS) $(LIBUTIL) $(LIBOCORE)
+	@echo Linking $@...
+	$(LD) $(LDFLAGS) $^ $(LIBS) -o $@
@@ -0,0 +1,281 @@
+/***************************************************************************
+
+    YM2151 register dump replayer
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+    Replays register dumps in the format written by ym2151.c when it is
+    built with LOG_CYM_FILE: pairs of (register, value) bytes, with a
+    zero byte marking each 1/110th of a second. The output of the core
+    is reduced to a CRC, and can also be written to a WAV file.
+
+    With -verify, every dump named in a list file is replayed and its
+    CRC compared against the one recorded there. The list in
+    src/tools/ym2151 holds the CRCs produced by the YM2151 core before
+    the per-algorithm rewrite, so any change to the output shows up as
+    a mismatch.
+
+***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "driver.h"
+#include "sound/ym2151.h"
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define CLOCK				3579545
+#define SAMPLE_RATE			(CLOCK / 64)
+#define TICK_RATE			110
+
+#define MAX_TICK_SAMPLES	(SAMPLE_RATE / TICK_RATE + 1)
+
+
+
+/***************************************************************************
+    STUBS FOR THE EMULATOR CORE
+***************************************************************************/
+
+void logerror(const char *text, ...)
+{
+}
+
+emu_timer *_timer_alloc_internal(timer_callback callback, void *param, const char *file, int line, const char *func)
+{
+	return NULL;
+}
+
+void _timer_set_internal(attotime duration, void *ptr, INT32 param, timer_callback callback, const char *file, int line, const char *func)
+{
+}
+
+void timer_adjust(emu_timer *which, attotime duration, INT32 param, attotime period)
+{
+}
+
+int timer_enable(emu_timer *which, int enable)
+{
+	return 0;
+}
+
+void state_save_register_memory(const char *module, UINT32 instance, const char *name, void *val, UINT32 valsize, UINT32 valcount)
+{
+}
+
+
+
+/***************************************************************************
+    WAV OUTPUT
+***************************************************************************/
+
+/*-------------------------------------------------
+    write_le - write a little-endian value
+-------------------------------------------------*/
+
+static void write_le(FILE *file, UINT32 value, int bytes)
+{
+	while (bytes--)
+	{
+		fputc(value & 0xff, file);
+		value >>= 8;
+	}
+}
+
+
+/*-------------------------------------------------
+    wav_header - write a 16-bit stereo header;
+    called again at the end to fill in the sizes
+-------------------------------------------------*/
+
+static void wav_header(FILE *file, UINT32 samples)
+{
+	fseek(file, 0, SEEK_SET);
+	fwrite("RIFF", 1, 4, file);
+	write_le(file, 36 + samples * 4, 4);
+	fwrite("WAVEfmt ", 1, 8, file);
+	write_le(file, 16, 4);
+	write_le(file, 1, 2);
+	write_le(file, 2, 2);
+	write_le(file, SAMPLE_RATE, 4);
+	write_le(file, SAMPLE_RATE * 4, 4);
+	write_le(file, 4, 2);
+	write_le(file, 16, 2);
+	fwrite("data", 1, 4, file);
+	write_le(file, samples * 4, 4);
+}
+
+
+
+/***************************************************************************
+    REPLAY
+***************************************************************************/
+
+/*-------------------------------------------------
+    replay - play a dump through a fresh chip;
+    returns 0 on success with the CRC filled in
+-------------------------------------------------*/
+
+static int replay(const char *filename, const char *wavname, UINT32 *crc)
+{
+	static SAMP left[MAX_TICK_SAMPLES], right[MAX_TICK_SAMPLES];
+	SAMP *buffers[2] = { left, right };
+	FILE *file, *wav = NULL;
+	UINT32 ticks = 0, samples = 0;
+	void *chip;
+	int r;
+
+	file = fopen(filename, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error opening %s\n", filename);
+		return 1;
+	}
+	if (wavname != NULL)
+	{
+		wav = fopen(wavname, "wb");
+		if (wav == NULL)
+		{
+			fprintf(stderr, "Error creating %s\n", wavname);
+			fclose(file);
+			return 1;
+		}
+		wav_header(wav, 0);
+	}
+
+	chip = YM2151Init(0, CLOCK, SAMPLE_RATE);
+	YM2151ResetChip(chip);
+	*crc = crc32(0, NULL, 0);
+
+	while ((r = fgetc(file)) != EOF)
+	{
+		UINT8 data[MAX_TICK_SAMPLES * 8];
+		int count, i;
+
+		/* a nonzero byte is a register, followed by its value */
+		if (r != 0)
+		{
+			int v = fgetc(file);
+			if (v == EOF)
+				break;
+			YM2151WriteReg(chip, r, v);
+			continue;
+		}
+
+		/* a zero byte ends a tick; generate the samples that fall inside it */
+		ticks++;
+		count = (UINT64)ticks * SAMPLE_RATE / TICK_RATE - samples;
+		YM2151UpdateOne(chip, buffers, count);
+		samples += count;
+
+		/* the CRC covers the full 32-bit output of both channels */
+		for (i = 0; i < count; i++)
+		{
+			UINT32 l = left[i], rt = right[i];
+			data[i * 8 + 0] = l;  data[i * 8 + 1] = l >> 8;  data[i * 8 + 2] = l >> 16;  data[i * 8 + 3] = l >> 24;
+			data[i * 8 + 4] = rt; data[i * 8 + 5] = rt >> 8; data[i * 8 + 6] = rt >> 16; data[i * 8 + 7] = rt >> 24;
+		}
+		*crc = crc32(*crc, data, count * 8);
+
+		if (wav != NULL)
+			for (i = 0; i < count; i++)
+			{
+				write_le(wav, (left[i] > 32767) ? 32767 : (left[i] < -32768) ? -32768 : left[i], 2);
+				write_le(wav, (right[i] > 32767) ? 32767 : (right[i] < -32768) ? -32768 : right[i], 2);
+			}
+	}
+
+	YM2151Shutdown(chip);
+	fclose(file);
+	if (wav != NULL)
+	{
+		wav_header(wav, samples);
+		fclose(wav);
+	}
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    verify - replay every dump in a list of
+    "crc filename" lines and compare the CRCs
+-------------------------------------------------*/
+
+static int verify(const char *listname)
+{
+	char line[1024], path[1024];
+	int dirlen, tested = 0, failed = 0;
+	FILE *list;
+
+	list = fopen(listname, "r");
+	if (list == NULL)
+	{
+		fprintf(stderr, "Error opening %s\n", listname);
+		return 1;
+	}
+
+	/* dump names are relative to the list */
+	for (dirlen = strlen(listname); dirlen > 0; dirlen--)
+		if (listname[dirlen - 1] == '/' || listname[dirlen - 1] == '\\')
+			break;
+
+	while (fgets(line, sizeof(line), list) != NULL)
+	{
+		char name[512];
+		unsigned int expected;
+		UINT32 crc;
+
+		if (line[0] == '#' || sscanf(line, "%x %511s", &expected, name) != 2)
+			continue;
+		sprintf(path, "%.*s%s", dirlen, listname, name);
+
+		tested++;
+		if (replay(path, NULL, &crc) != 0)
+			failed++;
+		else if (crc != expected)
+		{
+			printf("%-24s FAILED: %08x, expected %08x\n", name, crc, expected);
+			failed++;
+		}
+		else
+			printf("%-24s ok\n", name);
+	}
+	fclose(list);
+
+	printf("%d dumps, %d failed\n", tested, failed);
+	return (failed != 0 || tested == 0);
+}
+
+
+
+/***************************************************************************
+    MAIN
+***************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	UINT32 crc;
+
+	if (argc == 3 && strcmp(argv[1], "-verify") == 0)
+		return verify(argv[2]);
+
+	if (argc < 2 || argc > 3 || argv[1][0] == '-')
+	{
+		fprintf(stderr,
+			"Usage:\n"
+			"  ymreplay <dump.cym> [output.wav] -- replay a dump and print its CRC\n"
+			"  ymreplay -verify <list> -- replay the dumps in a list and check their CRCs\n"
+		);
+		return 1;
+	}
+
+	if (replay(argv[1], (argc > 2) ? argv[2] : NULL, &crc) != 0)
+		return 1;
+	printf("%08x %s\n", crc, argv[1]);
+	return 0;
+}
@@ -10,3 +10,6 @@
 ***************************************************************************/
 
 const char build_version[] = "0.122 ("__DATE__")";
+
+/* changes with every link, since this file is always recompiled */
+const char build_id[] = __DATE__ " " __TIME__;